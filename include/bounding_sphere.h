@@ -0,0 +1,23 @@
+#ifndef PROJECT_2_BOUNDING_SPHERE_H
+#define PROJECT_2_BOUNDING_SPHERE_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+struct BoundingSphere
+{
+    glm::vec3 center{0.0, 0.0, 0.0};
+    float radius{-1};       // negative for an empty sphere
+
+    bool empty() const {return radius < 0;}
+    BoundingSphere transformed(const glm::mat4& transform, float scale) const;
+};
+
+BoundingSphere minimalBoundingSphere(const std::vector<float>& vertices);
+BoundingSphere minimalBoundingSphere(const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                                     size_t first, size_t count);
+BoundingSphere mergeSpheres(const BoundingSphere& a, const BoundingSphere& b);
+
+#endif //PROJECT_2_BOUNDING_SPHERE_H
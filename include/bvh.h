@@ -0,0 +1,85 @@
+#ifndef PROJECT_2_BVH_H
+#define PROJECT_2_BVH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+struct RayHit
+{
+    float distance{0};
+    uint32_t triangle{0};       // index of the triangle in the Object's index array (index / 3)
+    glm::vec3 point{0.0, 0.0, 0.0};
+};
+
+class Bvh
+/** Bounding volume hierarchy over the triangles of an Object, used for ray picking.
+Built with binned surface area heuristic (SAH); top levels of the tree are built in parallel.
+Nodes are stored in a flat array in depth-first order: the left child directly follows its parent,
+so only the index of the right child is stored. Triangle indices are reordered to follow leaves. */
+{
+public:
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t right_or_first;    // internal node: index of the right child, leaf: first triangle
+        glm::vec3 max;
+        uint32_t count;             // number of triangles in a leaf, 0 for internal nodes
+    };
+
+    struct BenchmarkResult
+    {
+        double build_ms{0};
+        size_t rays{0};
+        size_t hits{0};
+        double single_thread_rays_per_second{0};
+        double parallel_rays_per_second{0};
+    };
+
+    void build(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+    void clear();
+    bool intersect(const Ray& ray, RayHit& hit) const;
+    bool closestPoint(const glm::vec3& point, float max_distance, RayHit& hit) const;
+    size_t queryPlane(const glm::vec3& normal, float distance, std::vector<uint32_t>& triangles) const;
+
+    bool empty() const {return nodes_.empty();}
+    size_t nodeCount() const {return nodes_.size();}
+    size_t triangleCount() const {return triangle_ids_.size();}
+    size_t memoryBytes() const;
+    double buildTimeMs() const {return build_time_ms_;}
+    const std::vector<Node>& nodes() const {return nodes_;}
+    glm::vec3 triangleVertex(uint32_t leaf_triangle, int corner) const;
+    uint32_t triangleId(uint32_t leaf_triangle) const {return triangle_ids_[leaf_triangle];}
+
+    BenchmarkResult benchmark(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t ray_count);
+
+private:
+    struct BuildTriangle
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        glm::vec3 centroid;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> triangle_ids_;        // original triangle index of each triangle in leaf order
+    std::vector<uint32_t> triangle_indices_;    // three vertex indices of each triangle in leaf order
+    const float* vertices_{nullptr};            // positions of the Object the tree is built for
+    double build_time_ms_{0};
+
+    void buildNode(std::vector<Node>& nodes, std::vector<uint32_t>& ids, const std::vector<BuildTriangle>& triangles,
+                   uint32_t begin, uint32_t end, int parallel_depth, int depth) const;
+    bool intersectTriangle(const Ray& ray, uint32_t leaf_triangle, float& distance) const;
+};
+
+glm::vec3 closestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+glm::vec3 closestPointOnSegment(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b);
+
+#endif //PROJECT_2_BVH_H
@@ -2,9 +2,17 @@
 #define PROJECT_2_CAMERA_H
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <vector>
+#include "../include/depth_bounds.h"
 
 
+const float kFitMargin{1.05f};          // framed spheres leave this much room around them
+const float kMinFitRadius{1e-3f};       // framing a single point still gives a valid view
+const double kDepthMargin{0.02};        // fitted depth ranges are widened by this fraction of their length
+const double kMinNearRatio{1e-3};       // smallest near / far ratio with a fixed-point depth buffer
+const double kReversedMinNearRatio{1e-6};   // and with a reversed floating-point depth buffer
+
 enum View
 {
     kOrthogonal,
@@ -14,7 +22,8 @@ enum View
 enum CameraMode
 {
     kFirstPerson,
-    kDome
+    kDome,
+    kArcball
 };
 
 enum DomeCameraRotate{
@@ -38,23 +47,32 @@ public:
 
     ViewCamera(CameraMode mode, glm::vec3 camera_position, glm::vec3 target_position, glm::vec3 up_direction);
     CameraMode mode(){return mode_;};
+    View view(){return view_;};
     void applyMatrix();
     virtual void rotate(float delta_x, float delta_z){};
     virtual void move(float delta_x, float delta_y){};
-    void resetCamera();
+    virtual void resetCamera();
 
     void switchView()
     {
-        if (mode_ == kDome){
+        if (mode_ == kDome || mode_ == kArcball){
             view_ =
                     (view_ == View::kOrthogonal) ? View::kPerspective : View::kOrthogonal;
         }
     }
-    void setView(float dim_ration);
+    void setView(float dim_ration, bool reversed_depth = false);
     void zoom(float zooming_factor);
     void resetView();
+    void fitSphere(const glm::vec3& center, float radius, float dim_ratio);
+    DepthRange fitDepthRange(const DepthBounds& bounds, float dim_ratio, bool reversed_depth);
+    glm::mat4 viewMatrix() const;
+    ViewFrustum frustum(float dim_ratio) const;
+    static glm::mat4 standardDepthProjection(const glm::mat4& reversed_projection);
+    float orthoScale() const {return ortho_scale_;}
 
     void orthogonalView(){view_ = kOrthogonal;}
+    const glm::vec3& targetPosition() const {return target_position_;}
+    void setTargetPosition(const glm::vec3& target_position){target_position_ = target_position;}
     std::string getCameraMode();
     std::string getCameraView();
     ViewParams& getCameraViewParams(){return view_params_;}
@@ -63,7 +81,9 @@ protected:
 
     CameraMode mode_;
     View view_{kPerspective};
+    // Perspective left, right, bottom and top are tangents of the view angles, so they do not depend on the near plane.
     ViewParams view_params_ = ViewParams{-1, 1, -1, 1, 1, 50};
+    float ortho_scale_{1};      // orthographic extents are multiplied by it, set by fitSphere
 
     glm::vec3 camera_position_;
     glm::vec3 target_position_;
@@ -72,6 +92,8 @@ protected:
 
     float yaw_   = glm::radians(90.0f);
     float pitch_ = glm::radians(0.0f);
+
+    virtual void placeCamera(const glm::vec3& center, float distance);
 };
 
 class FirstPersonCamera : public ViewCamera {
@@ -86,13 +108,48 @@ public:
     DomeCamera(glm::vec3 camera_position, glm::vec3 target_position, glm::vec3 up_direction, double radius);
     void move(float delta_x, float delta_z) override;
     void rotate(float delta_x, float delta_y) override;
+    void resetCamera() override;
 
     void changeElevation();
     void changeAzimuth();
     void viewOrtho(DomeCameraRotate direction);
+    float yaw() const {return yaw_;}
+    float pitch() const {return pitch_;}
+    void setAngles(float yaw, float pitch);
+    static void presetAngles(DomeCameraRotate direction, float& yaw, float& pitch);
+    const glm::vec3& center() const {return center_;}
 
 private:
     float radius_;
+    float initial_radius_;
+    glm::vec3 center_{0.0f, 0.0f, 0.0f};       // center of the dome, the origin until a sphere is framed
+    float ortho_distance_{10};                  // distance of the orthographic preset views from the center
+
+    void placeCamera(const glm::vec3& center, float distance) override;
+};
+
+class ArcballCamera : public ViewCamera
+/** Orbits a target at any distance with the orientation kept as a unit quaternion, so rotation is unlimited in every
+direction, including over the top and under the bottom of the model. Drags rotate the camera around its own up and
+right axes by composing two small quaternions with the orientation; the view matrix is built only when drawing. */
+{
+public:
+    ArcballCamera(glm::vec3 target_position, float radius);
+    void move(float delta_x, float delta_y) override;
+    void rotate(float delta_x, float delta_y) override;
+    void resetCamera() override;
+
+    void setOrbit(const glm::vec3& target_position, float radius);
+    float radius() const {return radius_;}
+    const glm::quat& orientation() const {return orientation_;}
+
+private:
+    glm::quat orientation_{1.0f, 0.0f, 0.0f, 0.0f};     // rotation from camera space, looking along -Z, to world space
+    float radius_;
+    float initial_radius_;
+
+    void updatePosition();
+    void placeCamera(const glm::vec3& center, float distance) override;
 };
 
 
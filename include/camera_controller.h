@@ -0,0 +1,76 @@
+#ifndef PROJECT_2_CAMERA_CONTROLLER_H
+#define PROJECT_2_CAMERA_CONTROLLER_H
+
+#include <glm/glm.hpp>
+#include "../include/camera.h"
+
+
+const double kCameraTimeStep{1.0 / 120.0};     // seconds per integration step
+const double kCameraMaxFrameTime{0.25};        // longer frames (loading, a dialog) are not caught up with
+
+class CameraController
+/** Moves the current camera once per frame instead of once per input event. Cursor drags and arrow keys are only
+recorded by the input callbacks and integrated in update() against a fixed-timestep clock, so the motion does not
+depend on the frame rate or on the rate of OS events. Drags rotate the camera by the summed cursor movement and leave
+an angular velocity that decays after the button is released. Held arrow keys accelerate the camera towards a constant
+speed, and it glides to a stop after they are released. A Dome camera can be turned to the position of an orthographic
+preset with a short interpolation instead of a jump. With smooth camera turned off in Config, cameras stop at once
+and presets are reached in one frame. */
+{
+public:
+    struct Statistics
+    /** Cursor events of drags and the camera rotations they were coalesced into. */
+    {
+        size_t cursor_events{0};
+        size_t camera_updates{0};       // frames that applied at least one cursor event
+        size_t last_frame_events{0};
+        size_t max_frame_events{0};
+
+        size_t coalesced() const {return cursor_events - camera_updates;}
+    };
+
+    struct CoalescingBenchmark
+    /** CPU time of rotating the perspective cameras once per cursor event compared to once per frame by the summed deltas. */
+    {
+        size_t frames{0};
+        size_t events_per_frame{0};
+        double per_event_ms{0};
+        double per_frame_ms{0};
+    };
+
+    void addRotation(float delta_x, float delta_y);
+    void setDragging(bool dragging);
+    void setMoveKey(int key, bool pressed);
+    void turnToPreset(DomeCameraRotate preset);
+    void update(ViewCamera& camera, double time);
+    void reset();
+    bool isMoving() const;
+    const Statistics& statistics() const {return statistics_;}
+    static CoalescingBenchmark benchmark(FirstPersonCamera fps, DomeCamera dome, ArcballCamera arcball, size_t frames,
+                                         size_t events_per_frame);
+
+private:
+    double clock_{-1};                          // time of the last update, -1 before the first one
+    double accumulator_{0};                     // time not yet integrated, shorter than a step
+
+    glm::vec2 pending_rotation_{0.0f};          // cursor drag since the last update
+    size_t pending_events_{0};
+    Statistics statistics_;
+    glm::vec2 rotation_velocity_{0.0f};         // per second
+    bool dragging_{false};
+
+    bool move_keys_[4] = {false, false, false, false};     // left, right, up, down
+    glm::vec2 move_velocity_{0.0f};             // per second, in the units of ViewCamera::move
+    glm::vec2 pending_move_{0.0f};              // key presses since the last update, when smooth camera is off
+
+    bool transition_{false};
+    double transition_progress_{0};             // 0 at the start of the interpolation, 1 at the preset
+    DomeCameraRotate transition_preset_{kFront};
+    float from_yaw_{0}, from_pitch_{0};
+    glm::vec3 from_target_{0.0f};
+
+    glm::vec2 moveInput() const;
+    void updateTransition(DomeCamera& camera, double elapsed, bool smooth);
+};
+
+#endif //PROJECT_2_CAMERA_CONTROLLER_H
@@ -1,7 +1,10 @@
 #ifndef PROJECT_2_CONFIG_H
 #define PROJECT_2_CONFIG_H
 
-#include <map>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 
 struct Parameters
 {
@@ -10,16 +13,111 @@ struct Parameters
     float grid_frequency_{1.0};
     float grid_end_{10};
     double ortho_coefficient_{15};
+    bool quantize_positions_{false};
+    bool solid_shading_{false};
+    bool hidden_line_{false};
+    bool meshlet_culling_{false};       // skip meshlets outside the view or facing away when drawing filled triangles
+    bool meshlet_cone_culling_{false};  // also skip back-facing meshlets; cuts holes into open or inconsistently wound meshes
+    bool instanced_rendering_{true};    // draw copies of a mesh in the scene with one call where supported
+    unsigned int edge_classes_{15};     // EdgeClass bits of the edges drawn by the wireframe, all classes by default
+    float crease_angle_{30};            // degrees between triangle normals above which their shared edge is a crease
+    bool measure_mode_{false};
+    bool section_{false};
+    float section_azimuth_{0};          // direction of the section plane normal in degrees, (0, 0) is the Z-axis
+    float section_elevation_{0};
+    float section_position_{0.5};       // 0 and 1 are the ends of the object along the normal
+    float streaming_error_pixels_{2};   // screen-space error up to which a coarser octree node is drawn instead of its children
+    int streaming_budget_mb_{512};      // GPU memory for octree nodes
+    bool smooth_camera_{true};          // camera glides to a stop and turns to presets with an animation
+    bool world_units_{false};           // draw models in their own units instead of scaling the primary Object to a fixed size
+    bool adaptive_depth_{true};         // fit near and far planes to the scene in view on every frame
+    bool reversed_depth_{false};        // draw into a floating-point depth buffer with reversed depth where supported
+    int viewport_layout_{0};            // ViewportLayoutType of engineering view, the 2x2 grid by default
+    float custom_split_{0.65};          // part of the window width taken by the main view of the custom layout
+    std::array<int, 4> custom_views_{{3, 0, 1, 2}};  // views of the custom layout (main view, then column), see ViewportLayout::customViewports
 
 };
 
+struct ConfigSnapshot
+/** Immutable copy of Parameters published by Config::publish. The version grows with every published change. */
+{
+    uint64_t version{0};
+    Parameters parameters;
+};
+
+enum ShortcutAction
+{
+    kNoShortcut,
+    kAnimateShortcut,
+    kExitShortcut,
+    kOpenFileShortcut,
+    kSaveImageShortcut,
+    kHelpShortcut,
+    kSwitchCameraModeShortcut,
+    kSwitchCameraViewShortcut,
+    kEnableGridShortcut,
+    kSwitchEngineeringViewShortcut,
+    kShortcutCount
+};
+
+const int kShortcutKeyCount{512};       // covers all GLFW key codes
+
 class Config
-/** Config class is used across the whole application to get access to Parameters. */
+/** Config class is used across the whole application to get access to Parameters. The main thread edits its own
+Parameters (UI, input) and publishes them once per frame as an immutable versioned snapshot, swapped in atomically.
+Threads with a snapshot of their own read it without locking Config: the render thread reads the snapshot of the frame it
+draws, and TaskScheduler tasks read the snapshot that was current when they were submitted (see useSnapshot).
+Shortcut keys are kept with a table from key code to action, so a key press is resolved with one lookup. */
 {
 public:
-    static Parameters& getParameters(){return parameters_;}
-    static std::map<std::string, char>& getShortcuts(){return shortcuts_;}
-    static char& getShortcut(const std::string& key){return shortcuts_[key];}
+    static const Parameters& getParameters()
+    {
+        return thread_snapshot_ != nullptr ? thread_snapshot_->parameters : parameters_;
+    }
+    static Parameters& editParameters(){return parameters_;}    // main thread only
+    // Makes getParameters on the calling thread return the snapshot, or the main thread's Parameters for nullptr.
+    static void useSnapshot(std::shared_ptr<const ConfigSnapshot> snapshot){thread_snapshot_ = std::move(snapshot);}
+    static const std::shared_ptr<const ConfigSnapshot>& threadSnapshot(){return thread_snapshot_;}
+    static std::shared_ptr<const ConfigSnapshot> snapshot(){return std::atomic_load(&published_);}
+
+    static std::shared_ptr<const ConfigSnapshot> publish()
+    /** Publishes the main thread's Parameters as a new snapshot if they changed since the last one and returns the
+    latest snapshot. Parameters are copied bytewise, so unchanged Parameters compare equal to the published copy. */
+    {
+        auto published = std::atomic_load(&published_);
+        if (published && std::memcmp(&published->parameters, &parameters_, sizeof(Parameters)) == 0)
+        {
+            return published;
+        }
+        auto next = std::make_shared<ConfigSnapshot>();
+        std::memcpy(&next->parameters, &parameters_, sizeof(Parameters));
+        next->version = published ? published->version + 1 : 1;
+        std::shared_ptr<const ConfigSnapshot> result = std::move(next);
+        std::atomic_store(&published_, result);
+        return result;
+    }
+
+    static char getShortcut(ShortcutAction action){return shortcuts_[action];}
+    static void setShortcut(ShortcutAction action, char key)
+    {
+        shortcuts_[action] = key;
+        actions_by_key_ = buildActionTable();
+    }
+    static ShortcutAction shortcutAction(int key)
+    /** Returns the action whose shortcut is the key code, kNoShortcut if there is none. */
+    {
+        return (key >= 0 && key < kShortcutKeyCount) ? actions_by_key_[key] : kNoShortcut;
+    }
+    static std::array<ShortcutAction, kShortcutKeyCount> buildActionTable()
+    {
+        std::array<ShortcutAction, kShortcutKeyCount> table{};
+        table.fill(kNoShortcut);
+        for (int action = kNoShortcut + 1; action < kShortcutCount; action++)
+        {
+            table[static_cast<unsigned char>(shortcuts_[action])] = static_cast<ShortcutAction>(action);
+        }
+        return table;
+    }
 
     static void switchGrid()
     /** Turn on/off grid.*/
@@ -44,7 +142,10 @@ public:
 
 private:
     static Parameters parameters_;
-    static std::map<std::string, char> shortcuts_;
+    static std::shared_ptr<const ConfigSnapshot> published_;
+    static thread_local std::shared_ptr<const ConfigSnapshot> thread_snapshot_;   // set on the render thread and in tasks
+    static std::array<char, kShortcutCount> shortcuts_;
+    static std::array<ShortcutAction, kShortcutKeyCount> actions_by_key_;
 };
 
 #endif //PROJECT_2_CONFIG_H
@@ -0,0 +1,57 @@
+#ifndef PROJECT_2_DEPTH_BOUNDS_H
+#define PROJECT_2_DEPTH_BOUNDS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+class Bvh;
+class Scene;
+
+
+struct Aabb
+{
+    glm::vec3 min{0.0, 0.0, 0.0};
+    glm::vec3 max{0.0, 0.0, 0.0};
+
+    Aabb transformed(const glm::mat4& transform) const;
+};
+
+struct ViewFrustum
+/** Sides of a view, without its near and far planes. For perspective views the sides are tangents of the view angles,
+for orthogonal views they are view coordinates. */
+{
+    bool orthographic{false};
+    double left{-1}, right{1}, bottom{-1}, top{1};
+};
+
+struct DepthRange
+/** Range of view depths, the distances along the view direction, covered by the boxes inside a view. */
+{
+    size_t boxes{0};
+    size_t visible{0};
+    double min_depth{0};
+    double max_depth{0};
+    double near{0};             // planes fitted to the range, see ViewCamera::fitDepthRange
+    double far{0};
+
+    bool empty() const {return visible == 0;}
+};
+
+class DepthBounds
+/** World-space boxes around the parts of the scene, gathered once per frame from bounds cached when meshes are loaded:
+the top levels of the primary Object's BVH, the bounding box of each instance and the grid. For each view the boxes
+are tested against its sides and the depths of the visible ones give the near and far planes, so no frame touches
+the vertices of a mesh. */
+{
+public:
+    void update(const Scene& scene, float model_scale, bool grid, float grid_end);
+    DepthRange depthRange(const glm::mat4& view, const ViewFrustum& frustum) const;
+    const std::vector<Aabb>& boxes() const {return boxes_;}
+
+    static void collectBvhBoxes(const Bvh& bvh, int levels, std::vector<Aabb>& boxes);
+
+private:
+    std::vector<Aabb> boxes_;
+};
+
+#endif //PROJECT_2_DEPTH_BOUNDS_H
@@ -3,9 +3,21 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <memory>
 #include <tuple>
+#include <vector>
 #include "../include/object.h"
+#include "../include/scene.h"
 #include "../include/camera.h"
+#include "../include/camera_controller.h"
+#include "../include/depth_bounds.h"
+#include "../include/frame_snapshot.h"
+#include "../include/id_buffer.h"
+#include "../include/input_recorder.h"
+#include "../include/measure_tool.h"
+#include "../include/scene_framebuffer.h"
+#include "../include/section_slicer.h"
+#include "../include/viewport_layout.h"
 
 class DrawingLib{
 public:
@@ -14,22 +26,56 @@ public:
     void getWindowSize(GLFWwindow* window);
     std::tuple<int, int> windowSize(){return std::make_tuple(window_width_, window_height_);}
 
-    void drawScene(GLFWwindow* window, Object& object, bool imGuiCaptureMouse);
+    std::unique_ptr<FrameSnapshot> makeSnapshot(Scene& scene, bool imGuiCaptureMouse);
+    void drawScene(GLFWwindow* window, FrameSnapshot& frame);
     void defineCallbackFunction(GLFWwindow* window);
     std::string getCameraMetadata(){return "Camera mode: " + current_camera_->getCameraMode() + "\nCamera view: " + current_camera_->getCameraView();}
     void switchPerspectiveCameraMode()
+    /** Cycles through First person, Dome and Arcball cameras. */
     {
-        current_camera_ = (current_camera_->mode() == kFirstPerson) ? static_cast<ViewCamera*>(&dome_) : static_cast<ViewCamera*>(&fps_);
+        switch (current_camera_->mode())
+        {
+            case kFirstPerson: current_camera_ = &dome_; break;
+            case kDome: current_camera_ = &arcball_; break;
+            default: current_camera_ = &fps_; break;
+        }
+        camera_controller_.reset();
     }
+    CameraMode cameraMode() const {return current_camera_->mode();}
     void switchCameraView()
     {
         current_camera_-> switchView();
     }
     void turnOnDomeCamera(){current_camera_ = static_cast<ViewCamera*>(&dome_);}
+    void turnToPreset(DomeCameraRotate preset){camera_controller_.turnToPreset(preset);}
+    void frameAll(const Scene& scene);
+    void frameSelection(const Scene& scene);
+    const CameraController& cameraController() const {return camera_controller_;}
+    CameraController::CoalescingBenchmark benchmarkCursorCoalescing() const {return CameraController::benchmark(fps_, dome_, arcball_, 600, 16);}
 
-    void drawRuler();
+    void drawRuler(FrameSnapshot& frame);
     void reset();
 
+    InputRecorder& inputRecorder(){return input_recorder_;}
+    void startInputRecording();
+    void startInputReplay(ReplaySpeed speed);
+    void processRecordedInput(GLFWwindow* window);
+
+    struct PickResult
+    {
+        bool hit{false};
+        glm::vec3 point{0.0, 0.0, 0.0};     // in object coordinates
+        uint32_t triangle{0};
+        double time_us{0};
+    };
+    const PickResult& lastPick() const {return last_pick_;}
+    const MeasureTool& measureTool() const {return measure_tool_;}
+    uint32_t selectedShape() const {return selected_shape_;}
+    const IdBuffer& idBuffer() const {return id_buffer_;}
+    const SectionSlicer& sectionSlicer() const {return section_slicer_;}
+    const std::vector<DepthRange>& depthRanges() const {return depth_ranges_;}
+    bool reversedDepth() const {return reversed_depth_;}
+
 private:
     int window_width_{1920};
     int window_height_{1080};
@@ -49,27 +95,88 @@ private:
 
     FirstPersonCamera fps_ = FirstPersonCamera(glm::vec3(0.0f, 3.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     DomeCamera dome_       = DomeCamera(glm::vec3(0.0f, 1.0f, 20.0), glm::vec3(0.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 20);
+    ArcballCamera arcball_ = ArcballCamera(glm::vec3(0.0f, 0.0f, 0.0f), 20);
     DomeCamera engineering_camera_       = DomeCamera(glm::vec3(0.0f, 1.0f, 20.0), glm::vec3(0.0f, 1.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 20);
 
     ViewCamera* current_camera_ = &fps_;
+    // Input callbacks only record drags and arrow keys; the controller moves the current camera once per frame.
+    CameraController camera_controller_;
+
+    InputRecorder input_recorder_;
 
-    void drawRegularScene(GLFWwindow* window, Object &object);
-    void drawEngineeringScene(GLFWwindow* window, Object &object);
+    struct ViewportTransform
+    /** Matrices an Object was drawn with in a viewport, used to turn cursor positions into rays in object coordinates. */
+    {
+        bool valid{false};
+        glm::mat4 model_view{1.0f};
+        glm::mat4 projection{1.0f};
+        glm::vec4 viewport{0.0f};
+    };
+    std::vector<ViewportTransform> viewport_transforms_;     // one per viewport of the layout
+
+    bool pick_requested_{false};
+    double pick_pos_x_{0}, pick_pos_y_{0};
+    PickResult last_pick_;
+
+    // A left click without dragging selects the shape under the cursor through the ID buffer.
+    IdBuffer id_buffer_;
+    bool select_requested_{false};
+    double press_pos_x_{0}, press_pos_y_{0};
+    uint32_t selected_shape_{IdBuffer::kNoShape};
+    size_t selection_version_{0};
+
+    SectionSlicer section_slicer_;
+
+    // Boxes of the scene gathered once per frame, fitting the near and far planes of each viewport.
+    DepthBounds depth_bounds_;
+    std::vector<DepthRange> depth_ranges_;
+    SceneFramebuffer scene_framebuffer_;
+    bool reversed_depth_{false};        // the current frame is drawn with reversed depth
+
+    // Measurement requests are resolved once per frame in drawScene, so several cursor events between frames cost one query.
+    MeasureTool measure_tool_;
+    bool measure_start_requested_{false};
+    bool measure_update_requested_{false};
+    bool measure_finish_requested_{false};
+
+    void drawViewports(FrameSnapshot& frame);
+    void setProjection(const FrameSnapshot& frame, ViewCamera& camera, float dim_ratio, int viewport);
 
     void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     void cursorPositionCallback(GLFWwindow* window, double xpos, double ypos);
     void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     void scrollCallback(GLFWwindow* window, double yoffset);
+    void dispatchInputEvent(GLFWwindow* window, const InputRecorder::InputEvent& event);
+    void resetInputState();
+
+    void captureViewportTransform(int index);
+    const ViewportTransform* viewportTransformAt(const FrameSnapshot& frame, double x_screen, double y_screen) const;
+    bool cursorRay(const FrameSnapshot& frame, double x_screen, double y_screen, Ray& ray) const;
+    void updateMeasurement(const FrameSnapshot& frame, const Object& object);
+    void pickSurface(const FrameSnapshot& frame, const Object& object);
+    void drawPickMarker() const;
+    void selectShape(const FrameSnapshot& frame, const Object& object);
+    void drawSelection(const Object& object) const;
+
+    void frameSphere(const BoundingSphere& sphere, float model_scale);
+    float modelScale(const Object& object, const Parameters& parameters) const;
 
     void drawGrid();
+    static glm::vec3 sectionNormal();
     static void drawAxisArrow(float x, float y, float z, const std::string& axis_name);
 
     std::tuple<double, double> calculateCoordinatesOnMouseMove(int correction_factor) const;
-    std::tuple<int, int>  getCurrentViewport(double x_screen, double y_screen) const;
-
-    std::tuple<int, int> current_viewport_;
-    std::tuple<double, double> convertCoordinates(double x, double y);
-    void printOrthoViewType(int i, int j, DomeCameraRotate ortho_view);
+    double inputTime() const;
+
+    // Layout of the last snapshot, used by the input callbacks to find the viewport under the cursor.
+    ViewportLayout layout_;
+    int current_viewport_{-1};
+    std::vector<DomeCamera> free_cameras_;     // cameras of the layout's Free views after the first one
+    int controlled_camera_{0};                 // Free view camera moved by drags and arrow keys, see freeCamera
+    static ViewportLayout layoutOf(const Parameters& parameters);
+    ViewCamera& freeCamera(int index);
+    static std::tuple<double, double> convertCoordinates(FrameSnapshot& frame, double x, double y, const ViewportRect& rect);
+    static void printOrthoViewType(DomeCameraRotate ortho_view, float dim_ratio);
     static std::string OrthViewToString(DomeCameraRotate view) ;
 };
 
@@ -0,0 +1,40 @@
+#ifndef PROJECT_2_EDGE_TABLE_H
+#define PROJECT_2_EDGE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "../include/task_scheduler.h"
+
+
+class EdgeTable
+/** Edges of a triangle mesh. The three edges of every triangle are stored as records keyed by their vertex pair
+(smaller vertex index first) and sorted in parallel, so all triangles sharing an edge form a run of equal keys:
+a run of one record is a boundary edge, a run of more than two records is a non-manifold edge. */
+{
+public:
+    struct EdgeRecord
+    {
+        uint64_t key;
+        uint32_t triangle;
+    };
+
+    void build(const std::vector<unsigned int>& indices) {build(indices.data(), indices.size());}
+    void build(const unsigned int* indices, size_t index_count, const CancellationToken& token = CancellationToken());
+    void clear();
+    void parallelForEdges(const std::function<void(size_t begin, size_t end)>& body) const;
+
+    const std::vector<EdgeRecord>& records() const {return records_;}
+    size_t runEnd(size_t begin) const;
+    size_t memoryBytes() const;
+
+    static uint64_t edgeKey(uint32_t a, uint32_t b) {return a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;}
+    static uint32_t firstVertex(uint64_t key) {return static_cast<uint32_t>(key >> 32);}
+    static uint32_t secondVertex(uint64_t key) {return static_cast<uint32_t>(key);}
+
+private:
+    std::vector<EdgeRecord> records_;
+};
+
+#endif //PROJECT_2_EDGE_TABLE_H
@@ -0,0 +1,56 @@
+#ifndef PROJECT_2_FEATURE_EDGES_H
+#define PROJECT_2_FEATURE_EDGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+enum EdgeClass : uint8_t
+{
+    kBoundaryEdge = 1,          // edge of one triangle
+    kCreaseEdge = 2,            // normals of the two triangles differ by more than the crease angle
+    kSmoothEdge = 4,
+    kNonManifoldEdge = 8,       // edge of more than two triangles
+    kAllEdges = 15
+};
+
+class FeatureEdges
+/** Edge adjacency of a triangle mesh: every edge once, with the triangles sharing it, and unit face normals.
+Built once after loading from a sorted EdgeTable. Edges are classified by the crease angle, and edges of selected
+classes or silhouette edges are extracted as line indices, each edge once. */
+{
+public:
+    struct Edge
+    {
+        uint32_t vertices[2];
+        uint32_t triangles[2];      // the second triangle is undefined for boundary edges
+        uint32_t triangle_count;
+    };
+
+    void build(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+    void clear();
+
+    void classify(float crease_angle);
+    void lineIndices(uint8_t class_mask, std::vector<uint32_t>& line_indices) const;
+    void silhouetteEdges(const glm::vec3& eye, bool orthographic, std::vector<uint32_t>& line_indices) const;
+
+    const std::vector<Edge>& edges() const {return edges_;}
+    size_t classCount(EdgeClass edge_class) const;
+    float creaseAngle() const {return crease_angle_;}
+    size_t memoryBytes() const;
+    double buildTimeMs() const {return build_time_ms_;}
+
+private:
+    std::vector<Edge> edges_;
+    std::vector<glm::vec3> face_normals_;
+    std::vector<glm::vec3> face_centers_;
+    std::vector<uint8_t> classes_;                  // EdgeClass of each edge
+    size_t class_counts_[4] = {0, 0, 0, 0};         // in the order of EdgeClass bits
+    float crease_angle_{-1};                        // angle of the last classification, negative if not classified
+    mutable std::vector<uint8_t> front_facing_;     // scratch buffer of silhouetteEdges
+    double build_time_ms_{0};
+};
+
+#endif //PROJECT_2_FEATURE_EDGES_H
@@ -0,0 +1,70 @@
+#ifndef PROJECT_2_FRAME_SNAPSHOT_H
+#define PROJECT_2_FRAME_SNAPSHOT_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "../include/camera.h"
+#include "../include/config.h"
+#include "../include/viewport_layout.h"
+
+class Scene;
+struct ImDrawData;
+
+
+struct FrameSnapshot
+/** Everything the render thread reads to draw one frame, taken on the main thread after the frame's events and UI
+are processed (see DrawingLib::makeSnapshot). The main thread keeps changing its own cameras, Parameters and input
+state while the frame is drawn. Cameras are copies, since drawing engineering views moves the engineering camera
+to each orthogonal view. */
+{
+    FrameSnapshot(const FirstPersonCamera& fps_camera, const DomeCamera& dome_camera, const ArcballCamera& arcball_camera,
+                  const DomeCamera& engineering_camera):
+            fps(fps_camera), dome(dome_camera), arcball(arcball_camera), engineering(engineering_camera){};
+
+    size_t frame{0};
+    std::shared_ptr<const ConfigSnapshot> config;
+    const Parameters& parameters() const {return config->parameters;}
+    int window_width{0};
+    int window_height{0};
+
+    FirstPersonCamera fps;
+    DomeCamera dome;
+    ArcballCamera arcball;
+    DomeCamera engineering;
+    CameraMode camera_mode{kFirstPerson};
+    ViewportLayout layout;
+    ViewCamera& camera()
+    {
+        switch (camera_mode)
+        {
+            case kDome: return dome;
+            case kArcball: return arcball;
+            default: return fps;
+        }
+    }
+    std::vector<DomeCamera> free_cameras;     // cameras of the layout's Free views after the first one
+    ViewCamera& camera(int index)
+    /** Returns the camera of a Free view of the layout (see Viewport::camera). */
+    {
+        return index > 0 && static_cast<size_t>(index) <= free_cameras.size() ? free_cameras[index - 1] : camera();
+    }
+
+    // Mouse state and requests collected from input events since the previous snapshot.
+    bool imgui_capture_mouse{false};
+    double cursor_x{0}, cursor_y{0};
+    bool select_requested{false};
+    bool pick_requested{false};
+    double pick_x{0}, pick_y{0};
+    bool measure_start_requested{false};
+    bool measure_update_requested{false};
+    bool measure_finish_requested{false};
+    bool ruler{false};
+    double ruler_start_x{0}, ruler_start_y{0};
+    int ruler_viewport{-1};     // index into layout
+
+    Scene* scene{nullptr};
+    ImDrawData* ui_draw_data{nullptr};    // valid until the main thread starts the next ImGui frame
+};
+
+#endif //PROJECT_2_FRAME_SNAPSHOT_H
@@ -4,18 +4,28 @@
 #include <functional>
 
 #include "../include/object.h"
+#include "../include/scene.h"
 #include "../include/drawing_lib.h"
+#include "../include/render_thread.h"
+#include "../include/task_scheduler.h"
 
 
 class GuiWindow{
 public:
-    explicit GuiWindow(Object& object): object_(object){readme_txt_ = readTextFile("../docs/ReadMe.txt");};
+    GuiWindow(Scene& scene, RenderThread& render_thread, TaskProfiler& task_profiler):
+    scene_(scene), object_(scene.primary()), render_thread_(render_thread), task_profiler_(task_profiler)
+    {readme_txt_ = readTextFile("../docs/ReadMe.txt");};
     void drawMenu(std::tuple<int, int> window_parameters);
     void drawMainPanel(DrawingLib &drawing_lib);
     void handleShortcuts(std::tuple<int, int> window_parameters);
 
 private:
+    Scene& scene_;
     Object& object_;
+    // OpenGL work (loading files, uploading buffers, reading the framebuffer) is posted to the render thread.
+    RenderThread& render_thread_;
+    // Timings of tasks run by the TaskScheduler, collected through its timing hook.
+    TaskProfiler& task_profiler_;
     float window_width_{260};
     float window_height_{500};
 
@@ -31,18 +41,43 @@ private:
     float animation_step_{-3.0};
     int axis_{0};
 
+    int replay_speed_{kRecordedSpeed};
+    bool replay_in_progress_{false};
+    std::string input_log_path_;
+    InputRecorder::ReplayReport last_replay_report_;
+    float frame_time_ms_[2] = {0, 0};     // last frame time with float and quantized vertex positions
+    Bvh::BenchmarkResult picking_benchmark_;
+    Object::NormalsBenchmark normals_benchmark_;
+    CameraController::CoalescingBenchmark coalescing_benchmark_;
+    int grid_instances_{16};
+    int selected_instance_{0};
+
     std::string readme_txt_;
     std::string rendered_image_path_;
 
-    static void addMenuItem(const std::string& item, const std::string& shortcut, bool &bool_to_update,  const std::function<void()>& func = nullptr);
+    static void addMenuItem(const std::string& item, ShortcutAction shortcut, bool &bool_to_update,  const std::function<void()>& func = nullptr);
     static std::string readTextFile(const std::string& filePath);
     void drawHelpWindow();
     void openFile();
+    void reportLoadError();
     static void exitConfirmMessage();
-    void shortcutInput(const std::string& text, const std::string& shortcut_key) const;
+    void shortcutInput(const std::string& text, ShortcutAction action) const;
     static int inputTextToUpperCaseCallback(ImGuiInputTextCallbackData* data);
     void makePrtSc(int width, int height);
     static void saveRenderedImage(const char* filename, int width, int height);
+    void drawInputRecordingPanel(DrawingLib &drawing_lib);
+    void openInputLog(DrawingLib &drawing_lib);
+    static void saveInputLog(InputRecorder &recorder);
+    void finishInputReplay(InputRecorder &recorder);
+    void drawMemoryPanel() const;
+    void drawPickingPanel(DrawingLib &drawing_lib);
+    void drawMeshAnalysisPanel();
+    void drawStreamingPanel();
+    void drawScenePanel();
+    void drawRenderThreadPanel() const;
+    void drawDepthRangePanel(DrawingLib &drawing_lib) const;
+    void drawTasksPanel();
+    void drawCursorEventsPanel(DrawingLib &drawing_lib);
 
 };
 
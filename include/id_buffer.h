@@ -0,0 +1,51 @@
+#ifndef PROJECT_2_ID_BUFFER_H
+#define PROJECT_2_ID_BUFFER_H
+
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "../include/object.h"
+
+
+class IdBuffer
+/** Offscreen framebuffer holding the ID of the Object's shape visible at each pixel, used to select shapes with the mouse.
+The fixed-function pipeline cannot write integer attachments, so IDs are encoded into the RGB channels of an RGBA8
+color buffer (see Object::drawShapeIds). The buffer is rendered again only when the matrices, the window size or
+the Object change, and the pixel under the cursor is read back through a pixel buffer object, so the read does not
+stall the frame it is requested in. */
+{
+public:
+    static const uint32_t kNoShape{UINT32_MAX};
+
+    void render(const Object& object, const glm::mat4& model_view, const glm::mat4& projection, const glm::vec4& viewport,
+                int width, int height);
+    void requestPixel(int x_window, int y_window);
+    bool readResult(uint32_t& shape);
+    void release();
+
+    bool isPending() const {return pending_;}
+    size_t renderCount() const {return render_count_;}
+    double lastRenderMs() const {return last_render_ms_;}
+
+private:
+    GLuint framebuffer_{0};
+    GLuint color_buffer_{0};
+    GLuint depth_buffer_{0};
+    GLuint pixel_buffer_{0};
+    int width_{0}, height_{0};
+
+    // State the current content was rendered with.
+    bool valid_{false};
+    glm::mat4 model_view_{1.0f};
+    glm::mat4 projection_{1.0f};
+    glm::vec4 viewport_{0.0f};
+    size_t object_version_{0};
+
+    bool pending_{false};
+    size_t render_count_{0};
+    double last_render_ms_{0};
+
+    bool resize(int width, int height);
+};
+
+#endif //PROJECT_2_ID_BUFFER_H
@@ -0,0 +1,108 @@
+#ifndef PROJECT_2_INPUT_RECORDER_H
+#define PROJECT_2_INPUT_RECORDER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+enum InputEventType : uint8_t
+{
+    kMouseButtonEvent,
+    kCursorPositionEvent,
+    kKeyEvent,
+    kScrollEvent,
+    kFrameEndEvent
+};
+
+enum ReplaySpeed
+{
+    kRecordedSpeed,
+    kAsFastAsPossible
+};
+
+class InputRecorder
+/** InputRecorder captures the GLFW input events handled by DrawingLib into a compact binary log
+and replays them deterministically, either at the recorded speed or one recorded frame per rendered frame.
+Frame timings are collected during replay. */
+{
+public:
+    struct InputEvent
+    {
+        double timestamp{0};        // seconds since the start of recording
+        InputEventType type{kFrameEndEvent};
+        bool imgui_capture_mouse{false};
+        int code{0};                // mouse button or key
+        int action{0};
+        int mods{0};
+        double x{0}, y{0};          // cursor position or scroll offset
+    };
+
+    struct InitialState
+    /** Application state restored before replay, so the recorded deltas are applied to the same starting point. */
+    {
+        bool engineering_view{false};
+        bool grid{false};
+        bool dome_camera{false};
+        bool arcball_camera{false};
+        bool orthogonal_view{false};
+        int viewport_layout{0};         // ViewportLayoutType of engineering view
+        double cursor_x{0}, cursor_y{0};
+    };
+
+    struct ReplayReport
+    {
+        size_t frames{0};
+        double average_ms{0};
+        double median_ms{0};
+        double p95_ms{0};
+        double max_ms{0};
+    };
+
+    void startRecording(const InitialState& state);
+    void stopRecording();
+    bool saveLog(const std::string& filepath) const;
+
+    bool loadLog(const std::string& filepath);
+    void startReplay(ReplaySpeed speed);
+    void stopReplay();
+
+    bool isRecording() const {return recording_;}
+    bool isReplaying() const {return replaying_;}
+    size_t eventCount() const {return events_.size();}
+    const InitialState& initialState() const {return initial_state_;}
+    const std::vector<double>& frameTimings() const {return frame_timings_ms_;}
+
+    void recordMouseButton(int button, int action, int mods, bool imgui_capture_mouse);
+    void recordCursorPosition(double x, double y, bool imgui_capture_mouse);
+    void recordKey(int key, int action, int mods);
+    void recordScroll(double y_offset, bool imgui_capture_mouse);
+    void recordFrameEnd();
+
+    std::vector<InputEvent> nextReplayEvents();
+    double time() const;
+    ReplayReport replayReport() const;
+    bool saveFrameTimings(const std::string& filepath) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool recording_{false};
+    bool replaying_{false};
+    ReplaySpeed replay_speed_{kRecordedSpeed};
+
+    InitialState initial_state_;
+    std::vector<InputEvent> events_;
+    size_t replay_position_{0};
+    double replay_time_{0};         // recorded time of the events replayed last
+
+    Clock::time_point start_time_;
+    Clock::time_point last_frame_time_;
+    std::vector<double> frame_timings_ms_;
+
+    double elapsedSeconds() const;
+    void addEvent(InputEvent event);
+};
+
+#endif //PROJECT_2_INPUT_RECORDER_H
@@ -0,0 +1,39 @@
+#ifndef PROJECT_2_INSTANCE_RENDERER_H
+#define PROJECT_2_INSTANCE_RENDERER_H
+
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+class InstanceRenderer
+/** Shader program and buffer of per-instance transforms for drawing many copies of a mesh with one instanced call.
+The fixed-function pipeline has no per-instance state, so a small GLSL 1.30 program reads each instance's model matrix
+and normal matrix from vertex attributes advanced once per instance (ARB_instanced_arrays). The view and projection
+still come from the fixed-function matrix stacks, and solid shading is lit by a headlight like Object::draw.
+Transforms of all meshes are uploaded once per frame into one buffer, and each mesh is drawn from its own range of it
+in every viewport. */
+{
+public:
+    bool available();
+    void upload(const std::vector<glm::mat4>& transforms);
+    void begin(size_t first_instance, bool lighting) const;
+    void end() const;
+    void release();
+    size_t bufferBytes() const {return buffer_bytes_;}
+
+private:
+    bool initialized_{false};
+    bool available_{false};
+    GLuint program_{0};
+    GLuint instance_buffer_{0};
+    size_t buffer_bytes_{0};
+    GLint model_location_{-1};      // first of four attributes holding the columns of the model matrix
+    GLint normal_location_{-1};     // first of three attributes holding the columns of the normal matrix
+    GLint lighting_location_{-1};
+    std::vector<float> instance_data_;
+
+    bool createProgram();
+};
+
+#endif //PROJECT_2_INSTANCE_RENDERER_H
@@ -4,13 +4,22 @@
 #include <string>
 #include <vector>
 
+struct ShapeRange
+/** Range of a shape in the Object's contiguous index array. */
+{
+    size_t offset{0};
+    size_t count{0};
+    std::string name;
+};
 
 class ObjectLoader
 {
 public:
-    static void loadObFileData(const std::string &filepath,
-                               std::vector<float> &object_vertices,
-                               std::vector<std::vector<unsigned int>> &object_shapes);
+    static size_t loadObFileData(const std::string &filepath,
+                                 std::vector<float> &object_vertices,
+                                 std::vector<unsigned int> &object_indices,
+                                 std::vector<ShapeRange> &object_shapes,
+                                 std::vector<float> &object_normals);
 
 };
 
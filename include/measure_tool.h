@@ -0,0 +1,70 @@
+#ifndef PROJECT_2_MEASURE_TOOL_H
+#define PROJECT_2_MEASURE_TOOL_H
+
+#include <functional>
+#include <string>
+#include <glm/glm.hpp>
+#include "../include/bvh.h"
+#include "../include/object.h"
+
+
+enum SnapKind
+{
+    kSnapNone,
+    kSnapVertex,
+    kSnapEdge,
+    kSnapSurface,
+    kSnapFree       // point off the surface, on the plane through the start point facing the camera
+};
+
+class MeasureTool
+/** MeasureTool measures 3D distances between points snapped to the surface of an Object.
+The cursor ray is intersected with the Object's BVH, then the hit point is snapped to the nearest vertex
+(found in the Object's vertex grid) or to the nearest edge of the hit triangle within the snap radius.
+For the end point of a measurement it also computes the distance to the mesh or the mesh section along the view ray.
+All points and distances are in object coordinates, so lengths are shown in model units. */
+{
+public:
+    struct SnapPoint
+    {
+        SnapKind kind{kSnapNone};
+        glm::vec3 point{0.0, 0.0, 0.0};
+    };
+
+    struct Measurement
+    {
+        SnapPoint start;
+        SnapPoint end;
+        float length{0};
+        float mesh_distance{-1};            // free end point to the closest point of the mesh, negative if not computed
+        glm::vec3 mesh_point{0.0, 0.0, 0.0};
+        float section{-1};                  // thickness of the mesh behind the end point along the view ray, negative if not computed
+    };
+
+    // Returns the snap radius in object coordinates for a point, so the radius stays constant in pixels.
+    using SnapRadius = std::function<float(const glm::vec3&)>;
+
+    void start(const Object& object, const Ray& ray, const SnapRadius& snap_radius);
+    void update(const Object& object, const Ray& ray, const SnapRadius& snap_radius);
+    void finish(){measuring_ = false;}
+    void clear();
+    void draw() const;
+
+    bool isMeasuring() const {return measuring_;}
+    const Measurement& measurement() const {return measurement_;}
+    const SnapPoint& hover() const {return hover_;}
+    double queryTimeUs() const {return query_time_us_;}
+
+private:
+    bool measuring_{false};
+    SnapPoint hover_;
+    Measurement measurement_;
+    Ray view_ray_{};
+    double query_time_us_{0};
+
+    SnapPoint snap(const Object& object, const Ray& ray, const SnapRadius& snap_radius) const;
+    void measure(const Object& object);
+    static std::string snapKindToString(SnapKind kind);
+};
+
+#endif //PROJECT_2_MEASURE_TOOL_H
@@ -0,0 +1,34 @@
+#ifndef PROJECT_2_MEMORY_STATS_H
+#define PROJECT_2_MEMORY_STATS_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+struct MemoryStats
+/** Memory used by a loaded Object: CPU-side mesh data and normals, derived caches, GPU buffers and the peak reached during loading. */
+{
+    size_t vertex_bytes{0};
+    size_t index_bytes{0};
+    size_t normal_bytes{0};
+    size_t cache_bytes{0};          // shape tables and data derived from the mesh after loading
+    size_t gpu_bytes{0};            // data stored in GPU buffer objects
+    size_t submitted_bytes{0};      // data passed to OpenGL from client memory every frame
+    size_t peak_load_bytes{0};      // estimated peak of loader temporaries and resulting data during the last load
+
+    size_t cpuBytes() const {return vertex_bytes + index_bytes + normal_bytes + cache_bytes;}
+    void writeCsv(std::ostream& stream) const;
+};
+
+template <typename T>
+size_t vectorBytes(const std::vector<T>& vector)
+/** Returns the number of bytes allocated by a vector (its capacity, not its size). */
+{
+    return vector.capacity() * sizeof(T);
+}
+
+std::string formatBytes(size_t bytes);
+
+#endif //PROJECT_2_MEMORY_STATS_H
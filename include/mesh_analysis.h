@@ -0,0 +1,89 @@
+#ifndef PROJECT_2_MESH_ANALYSIS_H
+#define PROJECT_2_MESH_ANALYSIS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../include/task_scheduler.h"
+
+
+const int kHistogramBins{16};
+
+struct MeshStatistics
+/** Results of the mesh analysis. Volume is the signed sum of tetrahedra spanned by the origin and each triangle,
+so it is meaningful only for closed, consistently oriented meshes. */
+{
+    bool valid{false};
+    size_t triangles{0};
+    size_t vertices{0};
+    size_t shapes{0};
+    double surface_area{0};
+    double volume{0};
+    size_t degenerate_triangles{0};     // triangles with repeated vertices or (almost) zero area
+
+    size_t edges{0};
+    size_t boundary_edges{0};           // edges of one triangle
+    size_t non_manifold_edges{0};       // edges shared by more than two triangles
+    size_t boundary_components{0};      // connected groups of boundary edges; loops touching at a vertex are one group
+
+    // Triangle area histogram: bin i counts triangles with area in [2^(i-8), 2^(i-7)) times the mean area,
+    // the first and last bins also count smaller and larger triangles.
+    std::array<size_t, kHistogramBins> area_histogram{};
+    // Triangle quality histogram: 4 * sqrt(3) * area / sum of squared edge lengths, 1 for equilateral triangles.
+    std::array<size_t, kHistogramBins> quality_histogram{};
+
+    double analysis_ms{0};
+    size_t threads{0};
+
+    bool isClosed() const {return boundary_edges == 0 && non_manifold_edges == 0;}
+};
+
+class MeshAnalyzer
+/** MeshAnalyzer computes MeshStatistics of an Object in a background task of the TaskScheduler, with the stages
+themselves running on all workers. The render thread only reads the last published result, so it never waits for the
+analysis: a superseded analysis is cancelled and left to stop at its next check, and release() hands it the mesh it
+reads, which is freed when it stops. The analyzed vertices and indices must stay unchanged until then. */
+{
+public:
+    MeshAnalyzer() = default;
+    MeshAnalyzer(const MeshAnalyzer&) = delete;
+    MeshAnalyzer& operator=(const MeshAnalyzer&) = delete;
+    ~MeshAnalyzer();
+
+    void start(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t shape_count);
+    void cancel();
+    void release(std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+    bool isRunning() const {return run_ != nullptr && run_->running && !run_->token.isCancelled();}
+    MeshStatistics statistics() const;
+
+private:
+    struct Results
+    /** Published statistics, shared with the tasks, which do not refer to the analyzer. */
+    {
+        std::mutex mutex;
+        MeshStatistics statistics;
+    };
+
+    struct Run
+    /** One analysis, shared between the analyzer and its task. */
+    {
+        CancellationToken token;
+        TaskHandle task;
+        std::atomic<bool> running{true};
+        // Mesh released by the Object while the task was reading it, freed with the Run when the task ends.
+        std::vector<float> released_vertices;
+        std::vector<unsigned int> released_indices;
+    };
+
+    std::shared_ptr<Results> results_ = std::make_shared<Results>();
+    std::shared_ptr<Run> run_;
+
+    static bool analyze(const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count,
+                        size_t shape_count, const CancellationToken& token, MeshStatistics& result);
+};
+
+#endif //PROJECT_2_MESH_ANALYSIS_H
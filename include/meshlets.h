@@ -0,0 +1,55 @@
+#ifndef PROJECT_2_MESHLETS_H
+#define PROJECT_2_MESHLETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../include/loader.h"
+
+
+const size_t kMeshletMaxTriangles{124};
+const size_t kMeshletMaxVertices{64};
+
+struct MeshletCullStats
+{
+    size_t meshlets{0};
+    size_t frustum_rejected{0};
+    size_t backface_rejected{0};
+    double time_us{0};
+
+    size_t visible() const {return meshlets - frustum_rejected - backface_rejected;}
+};
+
+class Meshlets
+/** Clusters of neighbouring triangles with bounding spheres and normal cones, used to skip parts of the mesh outside
+the view frustum or facing away from the viewer before they are submitted. Triangles of each shape are reordered so every
+meshlet is a contiguous range of the index array. Bounds are stored as separate arrays padded to a multiple of four,
+so culling tests four meshlets at a time with SSE where available. */
+{
+public:
+    void build(const std::vector<float>& vertices, std::vector<unsigned int>& indices, const std::vector<ShapeRange>& shapes);
+    void clear();
+    MeshletCullStats cull(const glm::mat4& model_view, const glm::mat4& projection, bool cone_culling,
+                          std::vector<uint32_t>& visible) const;
+
+    size_t size() const {return first_index_.size();}
+    uint32_t firstIndex(size_t meshlet) const {return first_index_[meshlet];}
+    uint32_t indexCount(size_t meshlet) const {return index_count_[meshlet];}
+    double buildTimeMs() const {return build_time_ms_;}
+    size_t memoryBytes() const;
+    static bool simd();
+
+private:
+    std::vector<uint32_t> first_index_;    // position of the meshlet's first index in the Object's index array
+    std::vector<uint32_t> index_count_;
+    // Bounding spheres and normal cones, padded with spheres that are never visible.
+    std::vector<float> center_x_, center_y_, center_z_, radius_;
+    std::vector<float> axis_x_, axis_y_, axis_z_;
+    std::vector<float> cutoff_;             // sine of the cone's half-angle, 2 if the meshlet is never back-facing
+    double build_time_ms_{0};
+
+    void computeBounds(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t meshlet);
+};
+
+#endif //PROJECT_2_MESHLETS_H
@@ -0,0 +1,11 @@
+#ifndef PROJECT_2_NORMALS_H
+#define PROJECT_2_NORMALS_H
+
+#include <vector>
+
+
+void generateSmoothNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals);
+void gatherSmoothNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals);
+void generateSmoothNormalsSerial(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals);
+
+#endif //PROJECT_2_NORMALS_H
@@ -3,20 +3,130 @@
 
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include "../include/bounding_sphere.h"
+#include "../include/bvh.h"
+#include "../include/depth_bounds.h"
+#include "../include/feature_edges.h"
+#include "../include/instance_renderer.h"
+#include "../include/loader.h"
+#include "../include/memory_stats.h"
+#include "../include/mesh_analysis.h"
+#include "../include/meshlets.h"
+#include "../include/streaming_octree.h"
+#include "../include/task_scheduler.h"
+#include "../include/vertex_grid.h"
 
 
+const int kPartBoxLevels{4};    // levels of the BVH below the root whose boxes are kept, at most 16 boxes
+const size_t kSilhouetteViews{4};   // silhouette views cached at least, one per viewport of the 2x2 layout
 
 class Object{
 public:
+    struct IndexPackingReport
+    /** Result of the index-width selection stage: how many draw batches use 16-bit indices
+    and index bytes submitted per frame compared to 32-bit indices only. */
+    {
+        size_t short_batches{0};
+        size_t int_batches{0};
+        size_t full_bytes{0};
+        size_t packed_bytes{0};
+    };
+
+    struct QuantizationReport
+    /** Error and size of vertex positions stored as 16-bit integers compared to 32-bit floats. */
+    {
+        float max_error{0};     // maximum distance between original and decoded position, in model units
+        size_t float_bytes{0};
+        size_t quantized_bytes{0};
+    };
+
+    struct NormalsReport
+    {
+        bool from_file{false};
+        double generation_ms{0};
+    };
+
+    struct NormalsBenchmark
+    /** Normal generation time on one thread (scatter into vertices) and on all workers (gather per vertex). */
+    {
+        double serial_ms{0};
+        double parallel_ms{0};
+        size_t threads{0};
+    };
+
+    struct EdgeLineReport
+    /** Lines drawn by the last wireframe or hidden-line frame compared to the edges of all triangles (three per triangle). */
+    {
+        size_t edge_lines{0};
+        size_t silhouette_lines{0};
+        size_t triangle_edges{0};
+    };
+
+    struct MeshletReport
+    /** Meshlet culling of the last draw in a viewport. */
+    {
+        GLint viewport[4] = {0, 0, 0, 0};
+        MeshletCullStats stats;
+        size_t draw_calls{0};
+        size_t draw{0};             // number of the draw, 0 if the report is unused
+    };
+
     Object() = default;
+    ~Object(){cancelLoading();}
 
     void loadObjectFile(const std::string& filepath);
+    bool finishLoading(bool wait = false);
+    void cancelLoading();
+    bool isLoading() const {return load_task_.valid() && !load_task_.done();}
+    std::string takeLoadError();
+    void openStreamingFile(const std::string& filepath);
+    bool saveStreamingFile(const std::string& filepath) const;
     void draw();
+    size_t drawInstances(const std::vector<glm::mat4>& transforms, size_t first_instance, InstanceRenderer& renderer);
+    void beginSilhouetteFrame(size_t views);
+    bool drawsInstanced(InstanceRenderer& renderer) const;
+    glm::mat4 instanceDecode() const;
+    void drawShapeIds() const;
+    void drawShapeHighlight(size_t shape) const;
     float calculateScalingFactor(float reference_size) const;
+    float size() const {return max_length_;}       // diagonal of the bounding box
+    const BoundingSphere& boundingSphere() const {return bounding_sphere_;}
+    Aabb bounds() const {return {bounding_box_.min, bounding_box_.max};}
+    const std::vector<Aabb>& partBoxes() const {return part_boxes_;}
+    BoundingSphere shapeBoundingSphere(size_t shape) const;
     void rotateObjects(int i, int direction);
+    glm::mat4 rotation() const;
+    MemoryStats memoryStats() const;
+    IndexPackingReport indexPackingReport() const;
+    QuantizationReport quantizationReport() const;
+    NormalsReport normalsReport() const {return normals_report_;}
+    NormalsBenchmark benchmarkNormals() const;
+    EdgeLineReport edgeLineReport() const {return edge_line_report_;}
+    const FeatureEdges& featureEdges() const {return feature_edges_;}
+    const StreamingOctree& streamingOctree() const {return streaming_octree_;}
+    const Meshlets& meshlets() const {return meshlets_;}
+    std::vector<MeshletReport> meshletReports() const;
+    bool isStreaming() const {return streaming_octree_.isOpen();}
+    void uploadVertexBuffer();
+    void releaseBuffers();
+
+    const std::vector<GLfloat>& vertices() const {return vertices_;}
+    const std::vector<unsigned int>& indices() const {return indices_;}
+    const std::vector<GLfloat>& normals() const {return normals_;}
+    const std::vector<ShapeRange>& shapes() const {return shapes_;}
+    size_t version() const {return version_;}     // incremented on every load, so caches built for an Object can detect changes
+
+    bool pick(const Ray& ray, RayHit& hit) const {return bvh_.intersect(ray, hit);}
+    const Bvh& bvh() const {return bvh_;}
+    const VertexGrid& vertexGrid() const {return vertex_grid_;}
+    const MeshAnalyzer& meshAnalyzer() const {return mesh_analyzer_;}
+    glm::vec3 vertex(unsigned int index) const {return {vertices_[3 * size_t(index)], vertices_[3 * size_t(index) + 1], vertices_[3 * size_t(index) + 2]};}
+    glm::vec3 triangleVertex(uint32_t triangle, int corner) const {return vertex(indices_[3 * size_t(triangle) + corner]);}
+    Bvh::BenchmarkResult benchmarkPicking(size_t ray_count) {return bvh_.benchmark(vertices_, indices_, ray_count);}
 
 private:
     struct BoundingBox {
@@ -24,12 +134,128 @@ private:
         glm::vec3 max{0.0, 0.0, 0.0};
     };
 
+    struct LoadedMesh
+    /** Mesh parsed and preprocessed by a load task, before it replaces the mesh of the Object. */
+    {
+        std::vector<GLfloat> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<ShapeRange> shapes;
+        std::vector<GLfloat> normals;
+        NormalsReport normals_report;
+        Meshlets meshlets;
+        Bvh bvh;
+        VertexGrid vertex_grid;
+        FeatureEdges feature_edges;
+        BoundingSphere bounding_sphere;
+        size_t peak_load_bytes{0};
+        bool loaded{false};
+        std::string error;                    // why the load failed, reported by finishLoading
+    };
+
     std::vector<GLfloat> vertices_{};
-    std::vector<std::vector<unsigned int>> shapes_;
+    std::vector<unsigned int> indices_;       // indices of all shapes, stored one after another
+    std::vector<ShapeRange> shapes_;          // range of each shape in indices_
+    std::vector<GLfloat> normals_;            // one normal per vertex, from the file or generated
+    NormalsReport normals_report_;
+
+    struct IndexBatch
+    /** Consecutive shapes drawn with one call. 16-bit indices are stored relative to base_vertex. */
+    {
+        GLenum index_type{GL_UNSIGNED_INT};
+        size_t byte_offset{0};
+        size_t count{0};
+        unsigned int base_vertex{0};
+        size_t first_index{0};      // position of the batch's first index in indices_
+    };
+    std::vector<unsigned char> packed_indices_;   // indices of all batches, each batch in its own index width
+    std::vector<IndexBatch> index_batches_;
+
+    // Vertices and packed indices are stored in GPU buffers; the CPU copy of packed indices is released after upload.
+    GLuint vertex_buffer_{0};
+    GLuint index_buffer_{0};
+    GLuint normal_buffer_{0};
+    size_t vertex_buffer_bytes_{0};
+    size_t index_buffer_bytes_{0};
+    size_t normal_buffer_bytes_{0};
 
+    // Quantized positions are decoded as center + q * step by the modelview transform.
+    bool quantized_{false};
+    glm::vec3 quantization_center_{0.0, 0.0, 0.0};
+    glm::vec3 quantization_step_{1.0, 1.0, 1.0};
+    float quantization_error_{0.0};
+
+    Bvh bvh_;
+    FeatureEdges feature_edges_;
+
+    Meshlets meshlets_;
+    std::vector<uint32_t> meshlet_batches_;           // index of the batch containing each meshlet
+    std::vector<uint32_t> visible_meshlets_;          // scratch buffer of drawTriangles
+    std::vector<MeshletReport> meshlet_reports_ = std::vector<MeshletReport>(4);
+    size_t draw_count_{0};
+
+    // Wireframe and hidden-line modes: edges of the selected classes are kept in a GPU index buffer, rebuilt when the
+    // classes or the crease angle change. Silhouettes are cached per view in object coordinates, since the Object is
+    // drawn in every viewport and once per instance; views not drawn in the previous frame are dropped.
+    struct SilhouetteView
+    {
+        glm::vec3 eye;
+        bool orthographic;
+        bool operator==(const SilhouetteView& other) const {return eye == other.eye && orthographic == other.orthographic;}
+    };
+    struct SilhouetteViewHash
+    {
+        size_t operator()(const SilhouetteView& view) const;
+    };
+    struct SilhouetteCache
+    {
+        size_t frame{0};                // silhouette frame the view was last drawn in
+        std::vector<uint32_t> line_indices;
+    };
+    GLuint edge_line_buffer_{0};
+    size_t edge_line_count_{0};
+    GLenum edge_line_type_{GL_UNSIGNED_INT};   // 16-bit indices are used if all vertices are addressable with them
+    uint8_t edge_line_classes_{0};             // 0 if the buffer is not filled
+    std::unordered_map<SilhouetteView, SilhouetteCache, SilhouetteViewHash> silhouette_caches_;
+    size_t silhouette_frame_{0};
+    size_t silhouette_views_{kSilhouetteViews};     // views expected per frame, see beginSilhouetteFrame
+    EdgeLineReport edge_line_report_;
+    VertexGrid vertex_grid_;
+    MeshAnalyzer mesh_analyzer_;
+    // When a streaming file is open, the Object has no mesh of its own and draws the nodes paged in by the octree.
+    StreamingOctree streaming_octree_;
+    BoundingBox bounding_box_;
     float max_length_{0.0};
+    BoundingSphere bounding_sphere_;          // smallest sphere containing all vertices, computed by the load task
+    std::vector<Aabb> part_boxes_;            // boxes of the top BVH levels, used to fit the near and far planes
+    size_t peak_load_bytes_{0};
+    size_t version_{0};
+    // The load started last; a new load cancels it, since its result would be replaced anyway.
+    TaskHandle load_task_;
+    CancellationToken load_token_;
+    std::shared_ptr<LoadedMesh> loaded_mesh_;
+    std::string load_error_;                  // error of the last finished load, until the GUI takes it
     int rotation_[3] = {0,0,0};
 
+    static void prepareMesh(const std::string& filepath, const CancellationToken& token, LoadedMesh& mesh);
+    void installMesh(LoadedMesh& mesh);
+    void releaseMesh();
+    void beginDraw(bool with_normals = false) const;
+    void endDraw() const;
+    void drawIndexRange(const IndexBatch& batch, size_t first, size_t count, bool with_normals = false, GLsizei instances = 0) const;
+    void uploadNormalBuffer();
+    void drawMesh();
+    void drawSolid();
+    void drawTriangles(bool with_normals, bool cone_culling);
+    void assignMeshletBatches();
+    void drawHiddenLine();
+    void updateEdgeLines(uint8_t edge_classes, float crease_angle);
+    void drawEdgeLines() const;
+    const std::vector<uint32_t>& silhouetteLines(const glm::vec3& eye, bool orthographic);
+    void drawShapeElements(size_t shape) const;
+    void packIndices();
+    void uploadIndexBuffer();
+    std::vector<GLshort> quantizePositions();
+    void appendIndexBatch(size_t first_index, size_t count, GLenum index_type, unsigned int base_vertex);
     BoundingBox calculateBoundingBox();
     static float calculateObjectSize(Object::BoundingBox bounding_box) ;
 
@@ -0,0 +1,46 @@
+#ifndef PROJECT_2_PARALLEL_H
+#define PROJECT_2_PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+
+size_t workerCount();
+void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body, size_t min_chunk = 4096);
+
+template <typename T, typename Compare>
+void parallelSort(std::vector<T>& values, Compare compare)
+/** Sorts one chunk per worker in parallel, then merges neighbouring sorted chunks pairwise, each round in parallel. */
+{
+    const size_t min_chunk = 65536;
+    size_t count = values.size();
+    size_t chunks = std::max<size_t>(1, std::min(workerCount(), count / min_chunk));
+    size_t chunk_size = (count + chunks - 1) / chunks;
+
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            auto first = values.begin() + std::min(count, chunk * chunk_size);
+            auto last = values.begin() + std::min(count, (chunk + 1) * chunk_size);
+            std::sort(first, last, compare);
+        }
+    }, 1);
+
+    for (size_t width = chunk_size; width < count; width *= 2)
+    {
+        size_t pairs = (count + 2 * width - 1) / (2 * width);
+        parallelFor(pairs, [&](size_t begin, size_t end) {
+            for (size_t pair = begin; pair < end; pair++)
+            {
+                size_t first = pair * 2 * width;
+                size_t middle = std::min(count, first + width);
+                size_t last = std::min(count, first + 2 * width);
+                std::inplace_merge(values.begin() + first, values.begin() + middle, values.begin() + last, compare);
+            }
+        }, 1);
+    }
+}
+
+#endif //PROJECT_2_PARALLEL_H
@@ -0,0 +1,71 @@
+#ifndef PROJECT_2_RENDER_THREAD_H
+#define PROJECT_2_RENDER_THREAD_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <GLFW/glfw3.h>
+#include "../include/frame_snapshot.h"
+
+
+enum RenderTaskStage
+{
+    kBeforeFrame,
+    kAfterFrame
+};
+
+class RenderThread
+/** RenderThread draws frames on a thread that owns the window's OpenGL context, so the main thread handles events
+and the UI of the next frame while the current one is drawn and swapped. The main thread submits one FrameSnapshot
+per frame. Snapshots are double-buffered: one is drawn while at most one waits. Before it starts the next ImGui frame,
+the main thread waits until the last snapshot no longer reads the scene or the UI draw data, which is before the
+buffers are swapped. OpenGL work requested by the UI (loading files, reading the framebuffer) is posted as tasks and
+run on the render thread before or after the next frame is drawn. */
+{
+public:
+    using FrameFunction = std::function<void(FrameSnapshot&)>;
+
+    /** Times of the last frame, in milliseconds. */
+    struct Statistics
+    {
+        size_t frames{0};
+        double draw_ms{0};          // scene and UI drawing, including posted tasks
+        double swap_ms{0};
+        double wait_ms{0};          // time the main thread waited for the render thread
+    };
+
+    RenderThread() = default;
+    ~RenderThread(){stop();}
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void start(GLFWwindow* window, FrameFunction draw_frame);
+    void stop();
+    void submit(std::unique_ptr<FrameSnapshot> snapshot);
+    void waitForFrameData();
+    void post(std::function<void()> task, RenderTaskStage stage = kBeforeFrame);
+    bool isRunning() const {return thread_.joinable();}
+    Statistics statistics() const;
+
+private:
+    GLFWwindow* window_{nullptr};
+    FrameFunction draw_frame_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_{false};
+
+    std::unique_ptr<FrameSnapshot> pending_;                // submitted, not yet taken by the render thread
+    size_t submitted_frames_{0};
+    size_t drawn_frames_{0};                                // frames whose scene and UI are drawn
+    std::vector<std::function<void()>> tasks_before_;
+    std::vector<std::function<void()>> tasks_after_;
+    Statistics statistics_;
+
+    void run();
+};
+
+#endif //PROJECT_2_RENDER_THREAD_H
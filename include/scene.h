@@ -0,0 +1,85 @@
+#ifndef PROJECT_2_SCENE_H
+#define PROJECT_2_SCENE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../include/object.h"
+#include "../include/instance_renderer.h"
+
+
+/** Copy of one of the scene's meshes placed in the coordinates of the primary Object, after the primary Object's
+scaling is applied. Rotation is in degrees and applied along X, then Y, then Z, like Object::draw.*/
+struct Instance
+{
+    size_t mesh{0};
+    glm::vec3 position{0.0, 0.0, 0.0};
+    int rotation[3]{0, 0, 0};
+    float scale{1};
+};
+
+class Scene
+/** Scene holds mesh resources and instances placing copies of them. The primary Object (mesh 0) is the one loaded from
+the menu, drawn, picked and measured as before; instances are drawn around it. Each mesh's GPU buffers are shared by all
+of its instances, which are drawn together (see Object::drawInstances), so the number of draw calls depends on the
+number of unique meshes rather than on the number of instances. Instance transforms are computed and uploaded once per
+frame and drawn in every viewport. */
+{
+public:
+    /** Instances of the last frame and draw calls of all of its viewports. */
+    struct Statistics
+    {
+        size_t meshes{0};
+        size_t instances{0};
+        size_t draw_calls{0};
+        bool instanced{false};
+    };
+
+    explicit Scene(std::shared_ptr<Object> primary): meshes_{std::move(primary)}{};
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    Object& primary(){return *meshes_[0];}
+    const Object& primary() const {return *meshes_[0];}
+    void addMesh(const std::string& filepath, int copies);
+    void finishLoading();
+    bool isLoading() const;
+    std::string takeLoadError();
+    size_t addInstance(const Instance& instance);
+    void addGrid(size_t mesh, int count);
+    void removeInstance(size_t index);
+    void clearInstances();
+    void release();
+    Instance& instance(size_t index){return instances_[index];}
+    const std::vector<Instance>& instances() const {return instances_;}
+    size_t meshCount() const {return meshes_.size();}
+    const Object& mesh(size_t index) const {return *meshes_[index];}
+    BoundingSphere boundingSphere() const;
+    static glm::mat4 instanceTransform(const Instance& instance);
+
+    void prepareInstances(size_t viewports);
+    void drawInstances();
+    Statistics statistics() const {return statistics_;}
+
+private:
+    /** Mesh loaded in the background by addMesh, added with its copies once the load is finished. */
+    struct PendingMesh
+    {
+        std::shared_ptr<Object> mesh;
+        int copies{0};
+    };
+
+    std::vector<std::shared_ptr<Object>> meshes_;
+    std::vector<PendingMesh> pending_meshes_;
+    std::string load_error_;                          // error of a failed addMesh, until the GUI takes it
+    std::vector<Instance> instances_;
+    InstanceRenderer renderer_;
+    // Per-frame data of prepareInstances, reused by drawInstances in every viewport.
+    std::vector<std::vector<glm::mat4>> transforms_;  // one list per mesh
+    std::vector<glm::mat4> instance_models_;          // model matrices uploaded to the renderer, grouped by mesh
+    std::vector<size_t> first_instance_;              // index of each mesh's first model matrix in instance_models_
+    Statistics statistics_;
+};
+
+#endif //PROJECT_2_SCENE_H
@@ -0,0 +1,29 @@
+#ifndef PROJECT_2_SCENE_FRAMEBUFFER_H
+#define PROJECT_2_SCENE_FRAMEBUFFER_H
+
+#include <GL/glew.h>
+
+
+class SceneFramebuffer
+/** Offscreen framebuffer with a 32-bit floating-point depth buffer, used to draw the scene with reversed depth: the near
+plane is mapped to depth 1 and the far plane to 0 (ARB_clip_control with a zero-to-one depth range). Floating-point
+values are densest near 0, which balances the perspective division that puts most depth values near the near plane,
+so precision is almost uniform over the view. The default framebuffer has a fixed-point depth buffer, so the color
+of the scene is copied to it at the end. */
+{
+public:
+    static bool supported();
+    bool begin(int width, int height);
+    void end() const;
+    void release();
+
+private:
+    GLuint framebuffer_{0};
+    GLuint color_buffer_{0};
+    GLuint depth_buffer_{0};
+    int width_{0}, height_{0};
+
+    bool resize(int width, int height);
+};
+
+#endif //PROJECT_2_SCENE_FRAMEBUFFER_H
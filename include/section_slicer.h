@@ -0,0 +1,57 @@
+#ifndef PROJECT_2_SECTION_SLICER_H
+#define PROJECT_2_SECTION_SLICER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../include/object.h"
+
+
+class SectionSlicer
+/** SectionSlicer cuts an Object with a plane and chains the resulting segments into polylines (contours).
+Triangles crossing the plane are found through the Object's BVH, so the cost of moving the plane depends on the
+triangles near the plane rather than on the size of the mesh. Each intersection point lies on a mesh edge and is
+identified by its vertex pair, which makes chaining exact. Contours are cached until the plane or the Object changes. */
+{
+public:
+    struct Contour
+    {
+        size_t offset{0};       // first point in points()
+        size_t count{0};
+        bool closed{false};
+    };
+
+    struct Statistics
+    {
+        size_t visited_nodes{0};
+        size_t tested_triangles{0};
+        size_t segments{0};
+        size_t open_contours{0};
+        double time_us{0};
+    };
+
+    void update(const Object& object, const glm::vec3& normal, float position);
+    void clear();
+    void draw() const;
+
+    const std::vector<glm::vec3>& points() const {return points_;}
+    const std::vector<Contour>& contours() const {return contours_;}
+    const Statistics& statistics() const {return statistics_;}
+
+private:
+    // Plane the cached contours belong to.
+    bool valid_{false};
+    glm::vec3 normal_{0.0, 0.0, 1.0};
+    float position_{0};
+    size_t object_version_{0};
+
+    std::vector<uint32_t> triangles_;       // reused between updates to avoid reallocation
+    std::vector<glm::vec3> points_;
+    std::vector<Contour> contours_;
+    Statistics statistics_;
+
+    void slice(const Object& object, const glm::vec3& normal, float distance);
+};
+
+#endif //PROJECT_2_SECTION_SLICER_H
@@ -0,0 +1,124 @@
+#ifndef PROJECT_2_STREAMING_OCTREE_H
+#define PROJECT_2_STREAMING_OCTREE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+class StreamingOctree
+/** Out-of-core octree of a triangle mesh for view-dependent drawing of meshes that do not fit in memory.
+Leaves store the triangles inside their box, internal nodes store a simplified version of their subtree.
+Only the node table is read when a file is opened; node geometry is paged in by a loader thread, chosen by the
+screen-space error of nodes in the current view, and evicted in least recently used order to stay within a memory budget. */
+{
+public:
+    struct Node
+    /** Entry of the node table, stored in the file as is. */
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        float geometric_error;      // upper bound of the distance between the node's triangles and the full mesh, 0 for leaves
+        uint32_t children[8];       // indices of child nodes, 0 if absent (the root is node 0)
+        uint64_t offset;            // position of the node's vertices and indices in the file
+        uint32_t vertex_count;
+        uint32_t index_count;
+    };
+
+    struct Statistics
+    {
+        size_t nodes{0};
+        size_t resident_nodes{0};
+        size_t resident_bytes{0};
+        size_t budget_bytes{0};
+        size_t queued_nodes{0};
+        size_t drawn_nodes{0};          // by the last draw call
+        size_t drawn_triangles{0};
+        size_t loaded_nodes{0};         // since the file was opened
+        size_t evicted_nodes{0};
+        double load_ms{0};              // total time the loader thread spent reading nodes
+    };
+
+    StreamingOctree() = default;
+    StreamingOctree(const StreamingOctree&) = delete;
+    StreamingOctree& operator=(const StreamingOctree&) = delete;
+    ~StreamingOctree() {stopLoader();}     // GPU buffers are released with the OpenGL context
+
+    static bool writeFile(const std::string& filepath, const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                          size_t leaf_triangles = 16384);
+
+    bool open(const std::string& filepath);
+    void close();
+    void draw(float max_error_pixels, size_t budget_bytes);
+
+    bool isOpen() const {return !nodes_.empty();}
+    glm::vec3 boundsMin() const {return nodes_.empty() ? glm::vec3(0.0f) : nodes_[0].min;}
+    glm::vec3 boundsMax() const {return nodes_.empty() ? glm::vec3(0.0f) : nodes_[0].max;}
+    Statistics statistics() const;
+    size_t memoryBytes() const;
+
+private:
+    struct NodeData
+    {
+        uint32_t node{0};
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        double read_ms{0};
+    };
+
+    struct ResidentNode
+    {
+        bool resident{false};
+        bool in_flight{false};          // requested from the loader and not received yet
+        GLuint vertex_buffer{0};
+        GLuint index_buffer{0};
+        size_t bytes{0};
+        size_t last_used{0};            // traversal that last visited the node
+    };
+
+    struct Request
+    {
+        float priority{0};              // screen-space error of the parent, larger is loaded first
+        size_t traversal{0};
+    };
+
+    std::string filepath_;
+    std::vector<Node> nodes_;
+    std::vector<ResidentNode> resident_;    // accessed by the drawing thread only
+    size_t resident_bytes_{0};
+    size_t budget_bytes_{0};
+    size_t traversal_{0};
+    std::vector<uint32_t> draw_list_;
+    size_t drawn_triangles_{0};
+    size_t loaded_nodes_{0};
+    size_t evicted_nodes_{0};
+    double load_ms_{0};
+
+    // Shared with the loader thread.
+    std::thread loader_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    bool stop_{false};
+    std::unordered_map<uint32_t, Request> requests_;
+    std::vector<NodeData> completed_;
+
+    void stopLoader();
+    void loaderLoop();
+    static bool readNode(std::ifstream& file, const Node& entry, uint32_t node, NodeData& data);
+    void upload(NodeData& data);
+    void evict(uint32_t node);
+    void receiveCompleted();
+    void evictToBudget();
+    void traverse(uint32_t node, const glm::mat4& model_view_projection, const glm::vec3& eye, float error_scale,
+                  bool orthographic, float max_error_pixels, std::unordered_map<uint32_t, float>& wanted);
+};
+
+#endif //PROJECT_2_STREAMING_OCTREE_H
@@ -0,0 +1,158 @@
+#ifndef PROJECT_2_TASK_SCHEDULER_H
+#define PROJECT_2_TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ConfigSnapshot;
+
+enum TaskPriority
+{
+    kInteractivePriority,       // work a frame or the UI waits for
+    kBackgroundPriority,        // loading and preprocessing, nobody waits for it interactively
+    kTaskPriorityCount
+};
+
+class CancellationToken
+/** Shared flag asking tasks to stop. Copies refer to the same flag. A task whose token is cancelled before it starts
+is skipped; running tasks check isCancelled() between their stages. */
+{
+public:
+    CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+    void cancel() const {*cancelled_ = true;}
+    bool isCancelled() const {return *cancelled_;}
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+struct TaskTiming
+/** Passed to the timing hook after every task. */
+{
+    const char* name{""};
+    TaskPriority priority{kBackgroundPriority};
+    double queued_ms{0};        // from submission to start
+    double run_ms{0};
+    bool cancelled{false};      // skipped, since its token was cancelled before it started
+};
+
+class TaskHandle
+/** Refers to a submitted task. Waiting threads run other queued tasks meanwhile, so waiting inside a task does not
+block a worker. */
+{
+public:
+    TaskHandle() = default;
+
+    bool valid() const {return state_ != nullptr;}
+    bool done() const;
+    void wait() const;
+
+private:
+    friend class TaskScheduler;
+    struct State
+    {
+        std::atomic<bool> done{false};
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+    std::shared_ptr<State> state_;
+};
+
+class TaskScheduler
+/** Application-wide pool of worker threads shared by loading, preprocessing and parallelFor. Each worker has its own
+queue per priority: it takes its newest task first and steals the oldest tasks of other workers when its queue is
+empty. Threads outside the pool submit into a shared queue. A task reads the Config snapshot of the thread that
+submitted it, or the latest published one, so workers see consistent Parameters. Tasks are not interrupted, but every worker takes
+interactive tasks before background ones, and background tasks may occupy all workers but one, so interactive work
+starts on a free worker instead of waiting behind a long load. */
+{
+public:
+    using TimingHook = std::function<void(const TaskTiming&)>;
+
+    static TaskScheduler& instance();
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    TaskHandle submit(const char* name, std::function<void()> task, TaskPriority priority = kBackgroundPriority,
+                      CancellationToken token = CancellationToken());
+    bool runPendingTask(TaskPriority lowest_priority);
+    void setTimingHook(TimingHook hook);
+    size_t threadCount() const {return threads_.size();}
+    static TaskPriority currentPriority();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Task
+    {
+        const char* name{""};
+        std::function<void()> function;
+        TaskPriority priority{kBackgroundPriority};
+        CancellationToken token;
+        std::shared_ptr<const ConfigSnapshot> config;   // Parameters the task reads, see submit
+        Clock::time_point submitted;
+        std::shared_ptr<TaskHandle::State> state;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks[kTaskPriorityCount];
+    };
+
+    // One queue per worker, followed by the queue shared by threads outside the pool.
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> queued_[kTaskPriorityCount];
+    std::atomic<size_t> running_background_{0};
+    size_t max_running_background_{1};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_{false};
+
+    std::shared_ptr<const TimingHook> timing_hook_;
+
+    TaskScheduler();
+    void run(size_t worker);
+    bool takeTask(size_t queue, TaskPriority priority, bool newest, Task& task);
+    bool findTask(size_t own_queue, TaskPriority priority, Task& task);
+    void execute(Task& task);
+    void wakeWorkers();
+    bool hasWork() const;
+};
+
+class TaskProfiler
+/** Collects task timings from the scheduler's timing hook, summed up per task name, for the diagnostics panel. */
+{
+public:
+    struct Entry
+    {
+        size_t count{0};
+        size_t cancelled{0};
+        double total_run_ms{0};
+        double max_run_ms{0};
+        double total_queued_ms{0};
+        double last_run_ms{0};
+    };
+
+    void record(const TaskTiming& timing);
+    void clear();
+    std::map<std::string, Entry> entries() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+};
+
+#endif //PROJECT_2_TASK_SCHEDULER_H
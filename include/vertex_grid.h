@@ -0,0 +1,30 @@
+#ifndef PROJECT_2_VERTEX_GRID_H
+#define PROJECT_2_VERTEX_GRID_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+class VertexGrid
+/** Spatial hash grid over vertex positions of an Object, used to find the nearest vertex within a radius.
+Vertices are sorted by the hash of their cell, so each hash bucket is a contiguous range of vertex ids. */
+{
+public:
+    void build(const std::vector<float>& vertices);
+    void clear();
+    bool nearest(const glm::vec3& point, float radius, uint32_t& vertex, float& distance) const;
+    size_t memoryBytes() const;
+
+private:
+    const float* vertices_{nullptr};
+    glm::vec3 origin_{0.0, 0.0, 0.0};
+    float cell_size_{1.0};
+    std::vector<uint32_t> bucket_start_;    // first entry of each bucket in vertex_ids_, one extra entry at the end
+    std::vector<uint32_t> vertex_ids_;
+
+    size_t bucket(int x, int y, int z) const;
+    void cellOf(const glm::vec3& point, int& x, int& y, int& z) const;
+};
+
+#endif //PROJECT_2_VERTEX_GRID_H
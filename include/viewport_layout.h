@@ -0,0 +1,65 @@
+#ifndef PROJECT_2_VIEWPORT_LAYOUT_H
+#define PROJECT_2_VIEWPORT_LAYOUT_H
+
+#include <array>
+#include <vector>
+#include "../include/camera.h"
+
+
+enum ViewportLayoutType
+{
+    kGridLayout,        // Front, Side, Top and Free views in a 2x2 grid
+    kRowLayout,         // Front, Top and Free views side by side (1x3)
+    kSingleLayout,      // Free view only (1x1)
+    kCustomLayout,      // main view next to a column of up to three views, with views and split set in Config
+    kDualLayout,        // two Free views side by side, each with its own camera
+    kViewportLayoutCount
+};
+
+const int kNoView{-1};      // empty slot of the custom layout's column
+const std::array<int, 4> kDefaultCustomViews{{kFree, kFront, kSide, kTop}};
+
+struct Viewport
+/** One viewport of a layout: a rectangle in fractions of the window, measured from its bottom-left corner like
+glViewport, the view drawn in it and the camera it is drawn with. Front, Side and Top views share the engineering
+camera in orthogonal projection, so their pan and zoom stay aligned for the ruler. Free views have cameras of their
+own: camera 0 is the current camera, selected with the camera mode, and every further Free view gets the next index. */
+{
+    float x{0}, y{0}, width{1}, height{1};
+    DomeCameraRotate view{kFree};
+    int camera{0};              // index of the Free view's camera, set by ViewportLayout
+};
+
+struct ViewportRect
+/** Viewport in window pixels. */
+{
+    int x{0}, y{0}, width{0}, height{0};
+
+    float dimRatio() const {return width > 0 ? static_cast<float>(height) / static_cast<float>(width) : 1.0f;}
+};
+
+class ViewportLayout
+/** List of viewports the window is split into. The render pass draws them in order; input callbacks find the
+viewport under the cursor with viewportAt. Rectangles of neighbouring viewports share their edges, so they tile
+the window without gaps at any window size. */
+{
+public:
+    ViewportLayout() : ViewportLayout(kSingleLayout) {}
+    explicit ViewportLayout(ViewportLayoutType type);
+    explicit ViewportLayout(std::vector<Viewport> viewports);
+
+    size_t size() const {return viewports_.size();}
+    size_t freeCameraCount() const {return free_cameras_;}
+    const Viewport& operator[](size_t index) const {return viewports_[index];}
+    ViewportRect rect(size_t index, int window_width, int window_height) const;
+    int viewportAt(double x_screen, double y_screen, int window_width, int window_height) const;
+
+    static std::vector<Viewport> customViewports(float split, const std::array<int, 4>& views);
+    static const char* name(ViewportLayoutType type);
+
+private:
+    std::vector<Viewport> viewports_;
+    size_t free_cameras_{0};
+};
+
+#endif //PROJECT_2_VIEWPORT_LAYOUT_H
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "../include/bounding_sphere.h"
+
+namespace
+{
+    struct Point
+    {
+        double x, y, z;
+    };
+
+    Point operator-(const Point& a, const Point& b) {return {a.x - b.x, a.y - b.y, a.z - b.z};}
+    Point operator+(const Point& a, const Point& b) {return {a.x + b.x, a.y + b.y, a.z + b.z};}
+    Point operator*(const Point& a, double s) {return {a.x * s, a.y * s, a.z * s};}
+    double dot(const Point& a, const Point& b) {return a.x * b.x + a.y * b.y + a.z * b.z;}
+    Point cross(const Point& a, const Point& b) {return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};}
+
+    struct Sphere
+    {
+        Point center{0, 0, 0};
+        double radius_squared{-1};
+
+        bool contains(const Point& p) const
+        {
+            // Relative tolerance, so points on the boundary are not added again because of rounding.
+            Point d = p - center;
+            return dot(d, d) <= radius_squared * (1.0 + 1e-9) + 1e-18;
+        }
+    };
+
+    Sphere sphereOf(const Point& a, const Point& b)
+    {
+        Sphere sphere;
+        sphere.center = (a + b) * 0.5;
+        Point d = a - sphere.center;
+        sphere.radius_squared = dot(d, d);
+        return sphere;
+    }
+
+    Sphere sphereOf(const Point& a, const Point& b, const Point& c)
+    /** Smallest sphere through three points: their circumcircle. Collinear points give the sphere of the farthest pair. */
+    {
+        Point ab = b - a, ac = c - a;
+        Point n = cross(ab, ac);
+        double n_squared = dot(n, n);
+        if (n_squared <= 1e-24 * dot(ab, ab) * dot(ac, ac))
+        {
+            Sphere spheres[3] = {sphereOf(a, b), sphereOf(a, c), sphereOf(b, c)};
+            return *std::max_element(spheres, spheres + 3, [](const Sphere& s, const Sphere& t) {return s.radius_squared < t.radius_squared;});
+        }
+        Point offset = (cross(n, ab) * dot(ac, ac) + cross(ac, n) * dot(ab, ab)) * (0.5 / n_squared);
+        return {a + offset, dot(offset, offset)};
+    }
+
+    Sphere sphereOf(const Point& a, const Point& b, const Point& c, const Point& d)
+    /** Sphere through four points. Coplanar points give the smallest sphere through three of them containing the fourth. */
+    {
+        Point u = b - a, v = c - a, w = d - a;
+        double determinant = dot(u, cross(v, w));
+        if (std::abs(determinant) <= 1e-12 * std::sqrt(dot(u, u) * dot(v, v) * dot(w, w)))
+        {
+            Sphere spheres[4] = {sphereOf(a, b, c), sphereOf(a, b, d), sphereOf(a, c, d), sphereOf(b, c, d)};
+            const Point points[4] = {d, c, b, a};
+            Sphere best;
+            for (int i = 0; i < 4; i++)
+            {
+                if (spheres[i].contains(points[i]) && (best.radius_squared < 0 || spheres[i].radius_squared < best.radius_squared))
+                {
+                    best = spheres[i];
+                }
+            }
+            return best.radius_squared < 0 ? spheres[0] : best;
+        }
+        Point offset = (cross(v, w) * dot(u, u) + cross(w, u) * dot(v, v) + cross(u, v) * dot(w, w)) * (0.5 / determinant);
+        return {a + offset, dot(offset, offset)};
+    }
+
+    BoundingSphere minimalSphere(std::vector<Point>& points)
+    /** Randomized incremental algorithm (Welzl): points are shuffled and added one by one. When a point lies outside,
+    the sphere is rebuilt over the points before it with the new point on its boundary, recursively for up to four
+    boundary points. Expected time is linear in the number of points. */
+    {
+        BoundingSphere result;
+        if (points.empty())
+        {
+            return result;
+        }
+        // A fixed seed makes the result reproducible for the same mesh.
+        std::mt19937 random(1);
+        std::shuffle(points.begin(), points.end(), random);
+
+        Sphere sphere{points[0], 0};
+        for (size_t i = 1; i < points.size(); i++)
+        {
+            if (sphere.contains(points[i]))
+            {
+                continue;
+            }
+            sphere = {points[i], 0};
+            for (size_t j = 0; j < i; j++)
+            {
+                if (sphere.contains(points[j]))
+                {
+                    continue;
+                }
+                sphere = sphereOf(points[i], points[j]);
+                for (size_t k = 0; k < j; k++)
+                {
+                    if (sphere.contains(points[k]))
+                    {
+                        continue;
+                    }
+                    sphere = sphereOf(points[i], points[j], points[k]);
+                    for (size_t l = 0; l < k; l++)
+                    {
+                        if (!sphere.contains(points[l]))
+                        {
+                            sphere = sphereOf(points[i], points[j], points[k], points[l]);
+                        }
+                    }
+                }
+            }
+        }
+        result.center = glm::vec3(float(sphere.center.x), float(sphere.center.y), float(sphere.center.z));
+        result.radius = float(std::sqrt(sphere.radius_squared));
+        return result;
+    }
+}
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4& transform, float scale) const
+/** Returns the sphere moved by a transform whose linear part is a rotation scaled uniformly by scale. */
+{
+    if (empty())
+    {
+        return *this;
+    }
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(transform * glm::vec4(center, 1.0f));
+    sphere.radius = radius * scale;
+    return sphere;
+}
+
+BoundingSphere minimalBoundingSphere(const std::vector<float>& vertices)
+/** Returns the smallest sphere containing all vertices. */
+{
+    std::vector<Point> points(vertices.size() / 3);
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        points[i] = {vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]};
+    }
+    return minimalSphere(points);
+}
+
+BoundingSphere minimalBoundingSphere(const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                                     size_t first, size_t count)
+/** Returns the smallest sphere containing the vertices referenced by indices[first, first + count). */
+{
+    std::vector<unsigned int> ids(indices.begin() + static_cast<std::ptrdiff_t>(first),
+                                  indices.begin() + static_cast<std::ptrdiff_t>(first + count));
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<Point> points(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        size_t vertex = 3 * size_t(ids[i]);
+        points[i] = {vertices[vertex], vertices[vertex + 1], vertices[vertex + 2]};
+    }
+    return minimalSphere(points);
+}
+
+BoundingSphere mergeSpheres(const BoundingSphere& a, const BoundingSphere& b)
+/** Returns the smallest sphere containing both spheres. */
+{
+    if (a.empty())
+    {
+        return b;
+    }
+    if (b.empty())
+    {
+        return a;
+    }
+    glm::vec3 offset = b.center - a.center;
+    float distance = glm::length(offset);
+    if (distance + b.radius <= a.radius)
+    {
+        return a;
+    }
+    if (distance + a.radius <= b.radius)
+    {
+        return b;
+    }
+    BoundingSphere sphere;
+    sphere.radius = (distance + a.radius + b.radius) * 0.5f;
+    sphere.center = a.center + offset * ((sphere.radius - a.radius) / distance);
+    return sphere;
+}
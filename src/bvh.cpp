@@ -0,0 +1,662 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include "../include/bvh.h"
+#include "../include/memory_stats.h"
+#include "../include/parallel.h"
+#include "../include/task_scheduler.h"
+
+namespace
+{
+    const int kBinCount{16};
+    const uint32_t kMaxLeafTriangles{8};
+    const uint32_t kParallelBuildThreshold{16384};   // smaller subtrees are built on the thread of their parent
+    const int kMaxDepth{60};                         // traversal stack holds 64 nodes
+    const float kTraversalCost{1.0f};                // cost of visiting a node relative to intersecting a triangle
+
+    struct Bins
+    /** Triangle bounds and counts of each bin along each axis. */
+    {
+        glm::vec3 min[3][kBinCount];
+        glm::vec3 max[3][kBinCount];
+        uint32_t count[3][kBinCount];
+
+        Bins()
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                std::fill(min[axis], min[axis] + kBinCount, glm::vec3(FLT_MAX));
+                std::fill(max[axis], max[axis] + kBinCount, glm::vec3(-FLT_MAX));
+                std::fill(count[axis], count[axis] + kBinCount, 0);
+            }
+        }
+
+        void merge(const Bins& other)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                for (int bin = 0; bin < kBinCount; bin++)
+                {
+                    min[axis][bin] = glm::min(min[axis][bin], other.min[axis][bin]);
+                    max[axis][bin] = glm::max(max[axis][bin], other.max[axis][bin]);
+                    count[axis][bin] += other.count[axis][bin];
+                }
+            }
+        }
+    };
+
+    float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 extent = max - min;
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    float intersectBox(const Ray& ray, const glm::vec3& inverse_direction, const Bvh::Node& node, float closest)
+    /** Slab test. Returns the entry distance of the ray into the node's box, or FLT_MAX if the box is missed
+    or lies beyond the closest hit found so far. */
+    {
+        float tx1 = (node.min.x - ray.origin.x) * inverse_direction.x, tx2 = (node.max.x - ray.origin.x) * inverse_direction.x;
+        float ty1 = (node.min.y - ray.origin.y) * inverse_direction.y, ty2 = (node.max.y - ray.origin.y) * inverse_direction.y;
+        float tz1 = (node.min.z - ray.origin.z) * inverse_direction.z, tz2 = (node.max.z - ray.origin.z) * inverse_direction.z;
+
+        float t_min = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2));
+        float t_max = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+
+        if (t_max >= t_min && t_max > 0 && t_min < closest)
+        {
+            return t_min;
+        }
+        return FLT_MAX;
+    }
+
+    float boxDistanceSquared(const glm::vec3& point, const Bvh::Node& node)
+    /** Squared distance from the point to the node's box, 0 if the point is inside. */
+    {
+        glm::vec3 d = glm::max(glm::max(node.min - point, point - node.max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+}
+
+glm::vec3 closestPointOnTriangle(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+/** Finds the point of the triangle closest to the given point by checking its Voronoi regions
+(vertices, edges, face), as described in Real-Time Collision Detection by C. Ericson. */
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = point - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) return a;
+
+    glm::vec3 bp = point - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = point - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+glm::vec3 closestPointOnSegment(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b)
+{
+    glm::vec3 ab = b - a;
+    float length_squared = glm::dot(ab, ab);
+    if (length_squared == 0)
+    {
+        return a;
+    }
+    float t = glm::clamp(glm::dot(point - a, ab) / length_squared, 0.0f, 1.0f);
+    return a + ab * t;
+}
+
+void Bvh::clear()
+{
+    nodes_.clear();
+    nodes_.shrink_to_fit();
+    triangle_ids_.clear();
+    triangle_ids_.shrink_to_fit();
+    triangle_indices_.clear();
+    triangle_indices_.shrink_to_fit();
+    vertices_ = nullptr;
+}
+
+void Bvh::build(const std::vector<float>& vertices, const std::vector<unsigned int>& indices)
+/** Builds the tree over all triangles of an Object. The tree keeps a pointer to the vertices,
+so it has to be rebuilt whenever they are reallocated. */
+{
+    auto start = std::chrono::steady_clock::now();
+    clear();
+
+    auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (triangle_count == 0)
+    {
+        return;
+    }
+    vertices_ = vertices.data();
+
+    // Bounds and centroids of all triangles are computed once, in parallel.
+    std::vector<BuildTriangle> triangles(triangle_count);
+    parallelFor(triangle_count, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            const float* a = &vertices[3 * indices[3 * t]];
+            const float* b = &vertices[3 * indices[3 * t + 1]];
+            const float* c = &vertices[3 * indices[3 * t + 2]];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                triangles[t].min[axis] = std::min(a[axis], std::min(b[axis], c[axis]));
+                triangles[t].max[axis] = std::max(a[axis], std::max(b[axis], c[axis]));
+                triangles[t].centroid[axis] = (a[axis] + b[axis] + c[axis]) / 3.0f;
+            }
+        }
+    });
+
+    std::vector<uint32_t> ids(triangle_count);
+    std::iota(ids.begin(), ids.end(), 0);
+
+    // Each level of the tree doubles the number of subtrees built in parallel.
+    int parallel_depth = 0;
+    while ((size_t(1) << parallel_depth) < workerCount())
+    {
+        parallel_depth++;
+    }
+    nodes_.reserve(2 * triangle_count / kMaxLeafTriangles + 1);
+    buildNode(nodes_, ids, triangles, 0, triangle_count, parallel_depth, 0);
+
+    // Vertex indices are copied in leaf order, so triangles of a leaf are read from consecutive memory.
+    triangle_indices_.resize(3 * size_t(triangle_count));
+    parallelFor(triangle_count, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            triangle_indices_[3 * t]     = indices[3 * size_t(ids[t])];
+            triangle_indices_[3 * t + 1] = indices[3 * size_t(ids[t]) + 1];
+            triangle_indices_[3 * t + 2] = indices[3 * size_t(ids[t]) + 2];
+        }
+    });
+    triangle_ids_ = std::move(ids);
+    nodes_.shrink_to_fit();
+
+    build_time_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Bvh::buildNode(std::vector<Node>& nodes, std::vector<uint32_t>& ids, const std::vector<BuildTriangle>& triangles,
+                    uint32_t begin, uint32_t end, int parallel_depth, int depth) const
+/** Appends a node for triangles ids[begin, end) and, if splitting is cheaper by SAH, its left and right subtrees.
+Candidate splits are the borders of 16 bins along each axis of the centroid bounds. While parallel_depth > 0 the left
+subtree is built by a TaskScheduler task into its own array, which is then appended with right child indices shifted. */
+{
+    auto node_index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node());
+
+    uint32_t count = end - begin;
+    bool parallel = parallel_depth > 0 && count >= kParallelBuildThreshold;
+    size_t min_chunk = parallel ? kParallelBuildThreshold / 4 : count;
+    std::mutex merge_mutex;
+
+    // Bounds of triangles and of their centroids; large nodes at the top of the tree are reduced in parallel.
+    glm::vec3 bounds_min(FLT_MAX), bounds_max(-FLT_MAX);
+    glm::vec3 centroid_min(FLT_MAX), centroid_max(-FLT_MAX);
+    parallelFor(count, [&](size_t chunk_begin, size_t chunk_end) {
+        glm::vec3 local_min(FLT_MAX), local_max(-FLT_MAX), local_centroid_min(FLT_MAX), local_centroid_max(-FLT_MAX);
+        for (size_t i = begin + chunk_begin; i < begin + chunk_end; i++)
+        {
+            const BuildTriangle& triangle = triangles[ids[i]];
+            local_min = glm::min(local_min, triangle.min);
+            local_max = glm::max(local_max, triangle.max);
+            local_centroid_min = glm::min(local_centroid_min, triangle.centroid);
+            local_centroid_max = glm::max(local_centroid_max, triangle.centroid);
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        bounds_min = glm::min(bounds_min, local_min);
+        bounds_max = glm::max(bounds_max, local_max);
+        centroid_min = glm::min(centroid_min, local_centroid_min);
+        centroid_max = glm::max(centroid_max, local_centroid_max);
+    }, min_chunk);
+
+    nodes[node_index].min = bounds_min;
+    nodes[node_index].max = bounds_max;
+    nodes[node_index].right_or_first = begin;
+    nodes[node_index].count = count;
+
+    if (count <= 2 || depth >= kMaxDepth)
+    {
+        return;
+    }
+
+    // Triangles are sorted into bins along all three axes in a single pass.
+    glm::vec3 bin_scale;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float extent = centroid_max[axis] - centroid_min[axis];
+        bin_scale[axis] = extent > 0 ? kBinCount / extent : 0;
+    }
+    Bins bins;
+    parallelFor(count, [&](size_t chunk_begin, size_t chunk_end) {
+        Bins local_bins;
+        for (size_t i = begin + chunk_begin; i < begin + chunk_end; i++)
+        {
+            const BuildTriangle& triangle = triangles[ids[i]];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                int bin = std::min(kBinCount - 1, static_cast<int>((triangle.centroid[axis] - centroid_min[axis]) * bin_scale[axis]));
+                local_bins.count[axis][bin]++;
+                local_bins.min[axis][bin] = glm::min(local_bins.min[axis][bin], triangle.min);
+                local_bins.max[axis][bin] = glm::max(local_bins.max[axis][bin], triangle.max);
+            }
+        }
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        bins.merge(local_bins);
+    }, min_chunk);
+
+    // Binned SAH: cost of a split is the cost of traversing the node plus the number of triangles on each side
+    // times the area of its bounds, relative to the cost of intersecting one triangle.
+    float node_area = surfaceArea(bounds_min, bounds_max);
+    float best_cost = FLT_MAX;
+    int best_axis = -1, best_split = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (bin_scale[axis] == 0)
+        {
+            continue;
+        }
+
+        // Sweep from the right to get area and count of every right side, then from the left to evaluate splits.
+        float right_area[kBinCount];
+        uint32_t right_count[kBinCount];
+        glm::vec3 sweep_min(FLT_MAX), sweep_max(-FLT_MAX);
+        uint32_t sweep_count = 0;
+        for (int bin = kBinCount - 1; bin > 0; bin--)
+        {
+            sweep_count += bins.count[axis][bin];
+            sweep_min = glm::min(sweep_min, bins.min[axis][bin]);
+            sweep_max = glm::max(sweep_max, bins.max[axis][bin]);
+            right_count[bin] = sweep_count;
+            right_area[bin] = sweep_count > 0 ? surfaceArea(sweep_min, sweep_max) : 0;
+        }
+
+        sweep_min = glm::vec3(FLT_MAX);
+        sweep_max = glm::vec3(-FLT_MAX);
+        sweep_count = 0;
+        for (int split = 1; split < kBinCount; split++)
+        {
+            sweep_count += bins.count[axis][split - 1];
+            sweep_min = glm::min(sweep_min, bins.min[axis][split - 1]);
+            sweep_max = glm::max(sweep_max, bins.max[axis][split - 1]);
+            if (sweep_count == 0 || right_count[split] == 0)
+            {
+                continue;
+            }
+            float cost = kTraversalCost * node_area +
+                         sweep_count * surfaceArea(sweep_min, sweep_max) + right_count[split] * right_area[split];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    // A small node stays a leaf when no split is cheaper than intersecting all of its triangles.
+    float leaf_cost = count * node_area;
+    if (best_axis < 0 || (count <= kMaxLeafTriangles && best_cost >= leaf_cost))
+    {
+        return;
+    }
+
+    auto middle = std::partition(ids.begin() + begin, ids.begin() + end, [&](uint32_t id) {
+        int bin = std::min(kBinCount - 1, static_cast<int>((triangles[id].centroid[best_axis] - centroid_min[best_axis]) * bin_scale[best_axis]));
+        return bin < best_split;
+    });
+    auto mid = static_cast<uint32_t>(middle - ids.begin());
+    if (mid == begin || mid == end)
+    {
+        return;
+    }
+
+    nodes[node_index].count = 0;
+    if (parallel)
+    {
+        std::vector<Node> left_nodes, right_nodes;
+        // The left subtree is built by a pool task with the caller's priority; waiting runs queued tasks meanwhile.
+        TaskHandle left_task = TaskScheduler::instance().submit("BVH subtree", [&]() {
+            buildNode(left_nodes, ids, triangles, begin, mid, parallel_depth - 1, depth + 1);
+        }, TaskScheduler::currentPriority());
+        buildNode(right_nodes, ids, triangles, mid, end, parallel_depth - 1, depth + 1);
+        left_task.wait();
+
+        auto append = [&nodes](const std::vector<Node>& subtree) {
+            auto offset = static_cast<uint32_t>(nodes.size());
+            for (Node node : subtree)
+            {
+                if (node.count == 0)
+                {
+                    node.right_or_first += offset;
+                }
+                nodes.push_back(node);
+            }
+        };
+        append(left_nodes);
+        nodes[node_index].right_or_first = static_cast<uint32_t>(nodes.size());
+        append(right_nodes);
+    }
+    else
+    {
+        buildNode(nodes, ids, triangles, begin, mid, 0, depth + 1);
+        auto right_index = static_cast<uint32_t>(nodes.size());
+        buildNode(nodes, ids, triangles, mid, end, 0, depth + 1);
+        nodes[node_index].right_or_first = right_index;
+    }
+}
+
+glm::vec3 Bvh::triangleVertex(uint32_t leaf_triangle, int corner) const
+/** Returns a corner of a triangle given by its position in leaf order. */
+{
+    const float* vertex = vertices_ + 3 * size_t(triangle_indices_[3 * size_t(leaf_triangle) + corner]);
+    return {vertex[0], vertex[1], vertex[2]};
+}
+
+bool Bvh::intersectTriangle(const Ray& ray, uint32_t leaf_triangle, float& distance) const
+/** Möller–Trumbore ray-triangle intersection, both sides of the triangle are hit. */
+{
+    const float epsilon = 1e-9f;
+    glm::vec3 a = triangleVertex(leaf_triangle, 0);
+    glm::vec3 edge_1 = triangleVertex(leaf_triangle, 1) - a;
+    glm::vec3 edge_2 = triangleVertex(leaf_triangle, 2) - a;
+
+    glm::vec3 p = glm::cross(ray.direction, edge_2);
+    float determinant = glm::dot(edge_1, p);
+    if (std::fabs(determinant) < epsilon)
+    {
+        return false;
+    }
+    float inverse_determinant = 1.0f / determinant;
+
+    glm::vec3 s = ray.origin - a;
+    float u = glm::dot(s, p) * inverse_determinant;
+    if (u < 0 || u > 1)
+    {
+        return false;
+    }
+    glm::vec3 q = glm::cross(s, edge_1);
+    float v = glm::dot(ray.direction, q) * inverse_determinant;
+    if (v < 0 || u + v > 1)
+    {
+        return false;
+    }
+    distance = glm::dot(edge_2, q) * inverse_determinant;
+    return distance > 0;
+}
+
+bool Bvh::intersect(const Ray& ray, RayHit& hit) const
+/** Finds the closest triangle hit by the ray. Children are visited nearest first, and subtrees farther than
+the closest hit found so far are skipped. Returns false if no triangle is hit. */
+{
+    if (nodes_.empty())
+    {
+        return false;
+    }
+
+    glm::vec3 inverse_direction(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+    float closest = FLT_MAX;
+    uint32_t closest_triangle = 0;
+
+    uint32_t stack[64];
+    int stack_size = 0;
+    uint32_t node_index = 0;
+    if (intersectBox(ray, inverse_direction, nodes_[0], closest) == FLT_MAX)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        const Node& node = nodes_[node_index];
+        if (node.count > 0)
+        {
+            for (uint32_t t = node.right_or_first; t < node.right_or_first + node.count; t++)
+            {
+                float distance;
+                if (intersectTriangle(ray, t, distance) && distance < closest)
+                {
+                    closest = distance;
+                    closest_triangle = t;
+                }
+            }
+        }
+        else
+        {
+            uint32_t near_child = node_index + 1, far_child = node.right_or_first;
+            float near_distance = intersectBox(ray, inverse_direction, nodes_[near_child], closest);
+            float far_distance = intersectBox(ray, inverse_direction, nodes_[far_child], closest);
+            if (far_distance < near_distance)
+            {
+                std::swap(near_child, far_child);
+                std::swap(near_distance, far_distance);
+            }
+            if (near_distance != FLT_MAX)
+            {
+                if (far_distance != FLT_MAX)
+                {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+
+        if (stack_size == 0)
+        {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+
+    if (closest == FLT_MAX)
+    {
+        return false;
+    }
+    hit.distance = closest;
+    hit.triangle = triangle_ids_[closest_triangle];
+    hit.point = ray.origin + ray.direction * closest;
+    return true;
+}
+
+bool Bvh::closestPoint(const glm::vec3& point, float max_distance, RayHit& hit) const
+/** Finds the point of the mesh closest to the given point, no farther than max_distance.
+Children are visited nearest box first, and boxes farther than the closest point found so far are skipped.
+On success hit.distance holds the distance between the points. */
+{
+    if (nodes_.empty())
+    {
+        return false;
+    }
+
+    float closest = max_distance * max_distance;
+    bool found = false;
+    uint32_t stack[64];
+    int stack_size = 0;
+    uint32_t node_index = 0;
+    if (boxDistanceSquared(point, nodes_[0]) > closest)
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        const Node& node = nodes_[node_index];
+        if (node.count > 0)
+        {
+            for (uint32_t t = node.right_or_first; t < node.right_or_first + node.count; t++)
+            {
+                glm::vec3 candidate = closestPointOnTriangle(point, triangleVertex(t, 0), triangleVertex(t, 1), triangleVertex(t, 2));
+                glm::vec3 d = candidate - point;
+                float distance_squared = glm::dot(d, d);
+                if (distance_squared <= closest)
+                {
+                    closest = distance_squared;
+                    found = true;
+                    hit.triangle = triangle_ids_[t];
+                    hit.point = candidate;
+                }
+            }
+        }
+        else
+        {
+            uint32_t near_child = node_index + 1, far_child = node.right_or_first;
+            float near_distance = boxDistanceSquared(point, nodes_[near_child]);
+            float far_distance = boxDistanceSquared(point, nodes_[far_child]);
+            if (far_distance < near_distance)
+            {
+                std::swap(near_child, far_child);
+                std::swap(near_distance, far_distance);
+            }
+            if (near_distance <= closest)
+            {
+                if (far_distance <= closest)
+                {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+
+        // Boxes on the stack may have become farther than the closest point found after they were pushed.
+        while (stack_size > 0 && boxDistanceSquared(point, nodes_[stack[stack_size - 1]]) > closest)
+        {
+            stack_size--;
+        }
+        if (stack_size == 0)
+        {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+
+    if (found)
+    {
+        hit.distance = std::sqrt(closest);
+    }
+    return found;
+}
+
+size_t Bvh::queryPlane(const glm::vec3& normal, float distance, std::vector<uint32_t>& triangles) const
+/** Collects triangles whose bounds cross the plane dot(normal, p) = distance, visiting only nodes whose boxes
+the plane passes through. Returns the number of visited nodes. Triangles are appended as original triangle indices. */
+{
+    if (nodes_.empty())
+    {
+        return 0;
+    }
+
+    glm::vec3 absolute_normal = glm::abs(normal);
+    size_t visited = 0;
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const Node& node = nodes_[stack[--stack_size]];
+        visited++;
+
+        // The box is crossed if the distance of its center from the plane is within its projected half-extent.
+        glm::vec3 center = (node.min + node.max) * 0.5f;
+        glm::vec3 half_extent = (node.max - node.min) * 0.5f;
+        if (std::abs(glm::dot(normal, center) - distance) > glm::dot(absolute_normal, half_extent))
+        {
+            continue;
+        }
+
+        if (node.count > 0)
+        {
+            for (uint32_t t = node.right_or_first; t < node.right_or_first + node.count; t++)
+            {
+                triangles.push_back(triangle_ids_[t]);
+            }
+        }
+        else
+        {
+            stack[stack_size++] = node.right_or_first;
+            stack[stack_size++] = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+        }
+    }
+    return visited;
+}
+
+size_t Bvh::memoryBytes() const
+{
+    return vectorBytes(nodes_) + vectorBytes(triangle_ids_) + vectorBytes(triangle_indices_);
+}
+
+Bvh::BenchmarkResult Bvh::benchmark(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t ray_count)
+/** Rebuilds the tree and measures build time and picking throughput. Rays start on a sphere around the bounding box
+of the tree and point to random points inside it; the same rays are traced on one thread and on all workers. */
+{
+    BenchmarkResult result;
+    build(vertices, indices);
+    result.build_ms = build_time_ms_;
+    if (nodes_.empty())
+    {
+        return result;
+    }
+
+    glm::vec3 center = (nodes_[0].min + nodes_[0].max) * 0.5f;
+    glm::vec3 extent = nodes_[0].max - nodes_[0].min;
+    float radius = glm::length(extent);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(ray_count);
+    for (auto& ray : rays)
+    {
+        glm::vec3 direction(unit(generator), unit(generator), unit(generator));
+        if (glm::length(direction) < 1e-3f)
+        {
+            direction = glm::vec3(0.0f, 0.0f, 1.0f);
+        }
+        ray.origin = center + glm::normalize(direction) * radius;
+        glm::vec3 target = center + extent * 0.5f * glm::vec3(unit(generator), unit(generator), unit(generator));
+        ray.direction = glm::normalize(target - ray.origin);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto const& ray : rays)
+    {
+        RayHit hit;
+        result.hits += intersect(ray, hit) ? 1 : 0;
+    }
+    double single_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::atomic<size_t> parallel_hits{0};
+    start = std::chrono::steady_clock::now();
+    parallelFor(ray_count, [&](size_t begin, size_t end) {
+        size_t hits = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            RayHit hit;
+            hits += intersect(rays[i], hit) ? 1 : 0;
+        }
+        parallel_hits += hits;
+    }, 1024);
+    double parallel_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.rays = ray_count;
+    result.single_thread_rays_per_second = single_seconds > 0 ? ray_count / single_seconds : 0;
+    result.parallel_rays_per_second = parallel_seconds > 0 ? ray_count / parallel_seconds : 0;
+    return result;
+}
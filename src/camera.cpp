@@ -1,4 +1,6 @@
 
+#include <algorithm>
+#include <cmath>
 #include <GL/glew.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,35 +17,103 @@ void ViewCamera::applyMatrix()
 /** Constructs the view matrix using the camera's position, target position, and up direction,
 then applies this matrix to the current OpenGL matrix using `glMultMatrixf`. */
 {
-    glm::mat4 view_matrix =
-            glm::lookAt(camera_position_, target_position_, up_direction_);
+    glm::mat4 view_matrix = viewMatrix();
     GLfloat* matrix_data = glm::value_ptr(view_matrix);
     glMultMatrixf(matrix_data);
 }
 
-void ViewCamera::setView(float dim_ration)
-/**  * Sets the camera's view projection to either orthogonal or perspective based on the current view mode. */
+glm::mat4 ViewCamera::viewMatrix() const
 {
+    return glm::lookAt(camera_position_, target_position_, up_direction_);
+}
+
+void ViewCamera::setView(float dim_ration, bool reversed_depth)
+/**  * Sets the camera's view projection to either orthogonal or perspective based on the current view mode.
+With reversed depth the near plane is mapped to depth 1 and the far plane to 0, for a zero-to-one depth range
+(see SceneFramebuffer). The matrix is built in double precision, since the small near / far ratios reversed depth
+allows would lose their precision in a product with the standard matrix. */
+{
+    ViewFrustum sides = frustum(dim_ration);
+    double near = view_params_.near;
+    double far = view_params_.far;
     if (view_ == kOrthogonal)
     {
-        auto ortho_c = Config::getParameters().ortho_coefficient_;
-
-        glOrtho(view_params_.left * ortho_c,
-                view_params_.right * ortho_c,
-                view_params_.bottom*dim_ration * ortho_c,
-                view_params_.top*dim_ration * ortho_c,
-                view_params_.near,
-                view_params_.far);
+        if (!reversed_depth)
+        {
+            glOrtho(sides.left, sides.right, sides.bottom, sides.top, near, far);
+            return;
+        }
+        GLdouble matrix[16] = {2 / (sides.right - sides.left), 0, 0, 0,
+                               0, 2 / (sides.top - sides.bottom), 0, 0,
+                               0, 0, 1 / (far - near), 0,
+                               -(sides.right + sides.left) / (sides.right - sides.left),
+                               -(sides.top + sides.bottom) / (sides.top - sides.bottom), far / (far - near), 1};
+        glMultMatrixd(matrix);
     }
     else
     {
-        glFrustum(view_params_.left,
-                  view_params_.right,
-                  view_params_.bottom*dim_ration,
-                  view_params_.top*dim_ration,
-                  view_params_.near,
-                  view_params_.far);
+        if (!reversed_depth)
+        {
+            glFrustum(sides.left * near, sides.right * near, sides.bottom * near, sides.top * near, near, far);
+            return;
+        }
+        GLdouble matrix[16] = {2 / (sides.right - sides.left), 0, 0, 0,
+                               0, 2 / (sides.top - sides.bottom), 0, 0,
+                               (sides.right + sides.left) / (sides.right - sides.left),
+                               (sides.top + sides.bottom) / (sides.top - sides.bottom), near / (far - near), -1,
+                               0, 0, far * near / (far - near), 0};
+        glMultMatrixd(matrix);
+    }
+}
+
+ViewFrustum ViewCamera::frustum(float dim_ratio) const
+/** Returns the sides of the view: tangents of the view angles for perspective views, view coordinates for orthogonal ones. */
+{
+    ViewFrustum sides;
+    double scale = 1;
+    if (view_ == kOrthogonal)
+    {
+        sides.orthographic = true;
+        scale = Config::getParameters().ortho_coefficient_ * ortho_scale_;
+    }
+    sides.left = view_params_.left * scale;
+    sides.right = view_params_.right * scale;
+    sides.bottom = view_params_.bottom * dim_ratio * scale;
+    sides.top = view_params_.top * dim_ratio * scale;
+    return sides;
+}
+
+DepthRange ViewCamera::fitDepthRange(const DepthBounds& bounds, float dim_ratio, bool reversed_depth)
+/** Moves the near and far planes to the depths of the scene's boxes inside the view, with a small margin. The near
+plane of perspective views is kept above a fraction of the far plane, which is smaller with reversed depth. If no box
+is in view, the planes are not changed. */
+{
+    DepthRange range = bounds.depthRange(viewMatrix(), frustum(dim_ratio));
+    if (!range.empty())
+    {
+        double margin = (range.max_depth - range.min_depth) * kDepthMargin + kMinFitRadius;
+        double far = range.max_depth + margin;
+        double near = range.min_depth - margin;
+        if (view_ == kPerspective)
+        {
+            near = std::max(near, far * (reversed_depth ? kReversedMinNearRatio : kMinNearRatio));
+        }
+        view_params_.near = near;
+        view_params_.far = far;
     }
+    range.near = view_params_.near;
+    range.far = view_params_.far;
+    return range;
+}
+
+glm::mat4 ViewCamera::standardDepthProjection(const glm::mat4& reversed_projection)
+/** Returns the projection with the standard depth mapping (near plane at -1, far plane at 1 in normalized device
+coordinates) for a projection with reversed depth. Clip z of reversed depth is (w - z) / 2 of the standard one. */
+{
+    glm::mat4 inverse_remap(1.0f);
+    inverse_remap[2][2] = -2.0f;
+    inverse_remap[3][2] = 1.0f;
+    return inverse_remap * reversed_projection;
 }
 
 void ViewCamera::zoom(float zooming_factor)
@@ -56,20 +126,49 @@ void ViewCamera::zoom(float zooming_factor)
 }
 
 void ViewCamera::resetView()
-/** Resets the camera's view boundaries to their initial default values. */
+/** Resets the camera's view boundaries, near and far planes and orthographic scale to their initial default values. */
 {
     view_params_.left = -1;
     view_params_.right = 1;
     view_params_.bottom = -1;
     view_params_.top = 1;
+    view_params_.near = 1;
+    view_params_.far = 50;
+    ortho_scale_ = 1;
+}
+
+void ViewCamera::fitSphere(const glm::vec3& center, float radius, float dim_ratio)
+/** Frames a sphere: the view is reset and the camera is placed at the distance at which the sphere, with a small
+margin, fills the narrower side of the perspective view. The near and far planes enclose the sphere tightly, which
+keeps depth precision high for any model size, and the orthographic extents are scaled to fit the sphere the same way. */
+{
+    resetView();
+    radius = std::max(radius * kFitMargin, kMinFitRadius);
+    // Tangent of the half angle of the narrower side of the view, see setView.
+    double tangent = std::min(1.0, double(dim_ratio));
+    double distance = radius / std::sin(std::atan(tangent));
+
+    view_params_.near = distance - radius;
+    view_params_.far = distance + radius;
+    ortho_scale_ = static_cast<float>(radius / (Config::getParameters().ortho_coefficient_ * tangent));
+    placeCamera(center, static_cast<float>(distance));
+}
+
+void ViewCamera::placeCamera(const glm::vec3& center, float distance)
+/** Moves the camera to the given distance from the center, looking at it in the current view direction. */
+{
+    glm::vec3 direction = glm::normalize(target_position_ - camera_position_);
+    target_position_ = center;
+    camera_position_ = center - direction * distance;
 }
 
 std::string ViewCamera::getCameraMode()
-/** Checks the camera mode and returns a corresponding string representation: "Dome Camera" or "First Person Camera". */
+/** Checks the camera mode and returns a corresponding string representation: "Dome Camera", "First Person Camera" or "Arcball Camera". */
 {
     switch (mode_) {
         case kDome: return "Dome Camera";
         case kFirstPerson: return "First Person Camera";
+        case kArcball: return "Arcball Camera";
         default: return "Unknown";
     }
 }
@@ -85,11 +184,15 @@ std::string ViewCamera::getCameraView()
 }
 
 void ViewCamera::resetCamera()
-/** Resets the camera's position, target position, and up direction to their initial coordinates. */
+/** Resets the camera's position, target position, and up direction to their initial coordinates,
+as well as yaw and pitch angles, so the next rotation starts from the initial orientation. */
 {
     camera_position_ = initial_coordinates_[0];
     target_position_ = initial_coordinates_[1];
     up_direction_ = initial_coordinates_[2];
+
+    yaw_   = glm::radians(90.0f);
+    pitch_ = glm::radians(0.0f);
 }
 
 FirstPersonCamera::FirstPersonCamera(glm::vec3 camera_position, glm::vec3 target_position, glm::vec3 up_direction) : ViewCamera(kFirstPerson, camera_position, target_position, up_direction) {}
@@ -121,28 +224,32 @@ y-axis and x-axis respectively, ensuring the camera remains focused on the targe
     target_position_ += camera_position_;
 }
 
-DomeCamera::DomeCamera(glm::vec3 camera_position, glm::vec3 target_position, glm::vec3 up_direction,  double radius): ViewCamera (kDome, camera_position, target_position, up_direction), radius_(radius){
+DomeCamera::DomeCamera(glm::vec3 camera_position, glm::vec3 target_position, glm::vec3 up_direction,  double radius): ViewCamera (kDome, camera_position, target_position, up_direction), radius_(radius), initial_radius_(radius){
     camera_position_.z = radius_;
 }
 
 void DomeCamera::changeElevation()
-/** Updates the camera's position based on its current pitch (elevation angle) and radius (distance from the origin). */
+/** Updates the camera's position based on its current pitch (elevation angle) and radius (distance from the center). */
 {
-    camera_position_.y = sin(pitch_) * radius_;
+    camera_position_.y = center_.y + sin(pitch_) * radius_;
 
-    // radius_ represents the distance from the camera to the origin.
+    // radius_ represents the distance from the camera to the center.
     // When the pitch changes, the vertical component of this distance changes, and consequently, the horizontal distance
     // must also change to maintain the SAME overall distance from the origin.
     double new_r            = radius_ * cos(pitch_);
-    camera_position_.x = new_r * cos(yaw_);
-    camera_position_.z = new_r * sin(yaw_);
+    camera_position_.x = center_.x + new_r * cos(yaw_);
+    camera_position_.z = center_.z + new_r * sin(yaw_);
+
+    // The up direction is tangent to the dome towards its top, so it is never parallel to the view direction,
+    // even when looking straight down. Below the top it leads to the same image as the Y-axis.
+    up_direction_ = glm::vec3(-cos(yaw_) * sin(pitch_), cos(pitch_), -sin(yaw_) * sin(pitch_));
 }
 
 void DomeCamera::changeAzimuth()
-/** Updates the camera's position based on its current yaw (horizontal angle) and radius (distance from the origin). */
+/** Updates the camera's position based on its current yaw (horizontal angle) and radius (distance from the center). */
 {
-    camera_position_.x = cos(yaw_) * radius_;
-    camera_position_.z = sin(yaw_) * radius_;
+    camera_position_.x = center_.x + cos(yaw_) * radius_;
+    camera_position_.z = center_.z + sin(yaw_) * radius_;
 }
 
 void DomeCamera::rotate(float delta_x, float delta_y)
@@ -163,22 +270,75 @@ then recalculates the camera's position by calling `changeAzimuth` and `changeEl
     changeElevation();
 }
 
+void DomeCamera::resetCamera()
+/** Restores the initial position, radius and the dome centered at the origin. */
+{
+    ViewCamera::resetCamera();
+    radius_ = initial_radius_;
+    center_ = glm::vec3(0.0f, 0.0f, 0.0f);
+    ortho_distance_ = 10;
+}
+
+void DomeCamera::placeCamera(const glm::vec3& center, float distance)
+/** Centers the dome at the framed sphere with the distance as its radius, keeping the camera's yaw and pitch. */
+{
+    center_ = center;
+    radius_ = distance;
+    ortho_distance_ = distance;
+    target_position_ = center;
+    changeAzimuth();
+    changeElevation();
+}
+
+void DomeCamera::setAngles(float yaw, float pitch)
+/** Places the camera on the dome at the given yaw and pitch angles. */
+{
+    yaw_ = yaw;
+    pitch_ = glm::clamp(pitch, -glm::pi<float>() / 2.0f, glm::pi<float>() / 2.0f);
+    changeAzimuth();
+    changeElevation();
+}
+
+void DomeCamera::presetAngles(DomeCameraRotate direction, float& yaw, float& pitch)
+/** Returns the yaw and pitch angles of the dome position in the direction of an orthographic view (see viewOrtho).
+The Free view keeps the given angles. */
+{
+    switch (direction)
+    {
+        case kFront:
+            yaw = glm::radians(90.0f);
+            pitch = 0;
+            break;
+        case kSide:
+            yaw = 0;
+            pitch = 0;
+            break;
+        case kTop:
+            yaw = glm::radians(90.0f);
+            pitch = glm::radians(90.0f);
+            break;
+        default:
+            break;
+    }
+}
+
 void DomeCamera::viewOrtho(DomeCameraRotate direction)
 /** Sets the camera's position and orientation to predefined orthographic views (front, top, side).
 This function updates the camera position and up direction based on the specified direction,
 then applies the transformation matrix. */
 {
+    // All views look at the center, so the Front view does not depend on the views drawn before it.
+    target_position_ = center_;
     if (direction == kFront){
-        camera_position_ = glm::vec3(0.0f, 0.0f, 10.0);
+        camera_position_ = center_ + glm::vec3(0.0f, 0.0f, ortho_distance_);
         up_direction_ = glm::vec3(0.0f, 1.0f, 0.0f);
     }
     if (direction == kTop){
-        camera_position_ = glm::vec3(0.0f, 10.0f, 0.0);
+        camera_position_ = center_ + glm::vec3(0.0f, ortho_distance_, 0.0);
         up_direction_ = glm::vec3(0.0f, 0.0f, -1.0f);
     }
     if (direction == kSide){
-        camera_position_ = glm::vec3(10.0f, 0.0f, 0.0);
-        target_position_ = glm::vec3 (0,0,0);
+        camera_position_ = center_ + glm::vec3(ortho_distance_, 0.0f, 0.0);
         up_direction_ = glm::vec3(0.0f, 1.0f, 0.0f);
     }
     applyMatrix();
@@ -195,3 +355,55 @@ scaled by an orthographic coefficient.*/
     view_params_.top    -= delta_z/ortho_c;
     view_params_.bottom -= delta_z/ortho_c;
 }
+
+ArcballCamera::ArcballCamera(glm::vec3 target_position, float radius) :
+ViewCamera(kArcball, target_position + glm::vec3(0.0f, 0.0f, radius), target_position, glm::vec3(0.0f, 1.0f, 0.0f)),
+radius_(radius), initial_radius_(radius) {}
+
+void ArcballCamera::updatePosition()
+/** Places the camera at the radius from the target along the camera's +Z axis, with the camera's +Y axis as up direction. */
+{
+    camera_position_ = target_position_ + orientation_ * glm::vec3(0.0f, 0.0f, radius_);
+    up_direction_ = orientation_ * glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+void ArcballCamera::rotate(float delta_x, float delta_y)
+/** Turns the camera around the target: horizontal drags around the camera's up axis, vertical drags around its right
+axis, in the same directions as the Dome camera. The orientation is normalized after each composition, so rounding
+errors do not accumulate over long drags. */
+{
+    orientation_ = glm::normalize(orientation_ * glm::angleAxis(-delta_x, glm::vec3(0.0f, 1.0f, 0.0f))
+                                               * glm::angleAxis(-delta_y, glm::vec3(1.0f, 0.0f, 0.0f)));
+    updatePosition();
+}
+
+void ArcballCamera::move(float delta_x, float delta_z)
+/** Pans the camera and its target in the view plane, by a distance proportional to the radius. */
+{
+    float step = radius_ / 20.0f;
+    glm::vec3 offset = orientation_ * glm::vec3(delta_x * step, delta_z * step, 0.0f);
+    target_position_ += offset;
+    camera_position_ += offset;
+}
+
+void ArcballCamera::resetCamera()
+/** Restores the initial target, radius and orientation. */
+{
+    ViewCamera::resetCamera();
+    orientation_ = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    radius_ = initial_radius_;
+    updatePosition();
+}
+
+void ArcballCamera::setOrbit(const glm::vec3& target_position, float radius)
+/** Orbits another target at another distance, keeping the orientation. */
+{
+    target_position_ = target_position;
+    radius_ = radius;
+    updatePosition();
+}
+
+void ArcballCamera::placeCamera(const glm::vec3& center, float distance)
+{
+    setOrbit(center, distance);
+}
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include "../include/camera_controller.h"
+#include "../include/config.h"
+
+namespace
+{
+    const float kRotationDamping{6.0f};         // per second: the drag velocity falls to 1/e in 1/6 s
+    const float kMoveSpeed{8.0f};               // units of ViewCamera::move per second with an arrow key held
+    const float kMoveResponse{8.0f};            // per second: how fast the speed follows the keys
+    const float kStopSpeed{1e-3f};
+    const double kTransitionSeconds{0.4};
+
+    float shortestAngle(float from, float to)
+    /** Returns the angle to add to from to reach to, in [-pi, pi]. */
+    {
+        float delta = std::fmod(to - from, glm::two_pi<float>());
+        if (delta > glm::pi<float>())
+        {
+            delta -= glm::two_pi<float>();
+        }
+        else if (delta < -glm::pi<float>())
+        {
+            delta += glm::two_pi<float>();
+        }
+        return delta;
+    }
+}
+
+void CameraController::addRotation(float delta_x, float delta_y)
+/** Adds a cursor drag, applied by the next update together with all other cursor events of the frame. */
+{
+    pending_rotation_ += glm::vec2(delta_x, delta_y);
+    pending_events_++;
+}
+
+void CameraController::setDragging(bool dragging)
+/** Starting a drag stops the glide of the previous one and a running preset interpolation. */
+{
+    dragging_ = dragging;
+    if (dragging)
+    {
+        rotation_velocity_ = glm::vec2(0.0f);
+        transition_ = false;
+    }
+}
+
+void CameraController::setMoveKey(int key, bool pressed)
+/** Records a press or release of an arrow key. A press gives the camera full speed at once, so a short tap moves it
+by about one unit like a step did, even when the key is released before the next frame. */
+{
+    int index;
+    glm::vec2 direction;
+    switch (key)
+    {
+        case GLFW_KEY_LEFT: index = 0; direction = glm::vec2(1, 0); break;
+        case GLFW_KEY_RIGHT: index = 1; direction = glm::vec2(-1, 0); break;
+        case GLFW_KEY_UP: index = 2; direction = glm::vec2(0, 1); break;
+        case GLFW_KEY_DOWN: index = 3; direction = glm::vec2(0, -1); break;
+        default: return;
+    }
+    move_keys_[index] = pressed;
+    if (!pressed)
+    {
+        return;
+    }
+    if (Config::getParameters().smooth_camera_)
+    {
+        int axis = direction.x != 0 ? 0 : 1;
+        move_velocity_[axis] = direction[axis] * kMoveSpeed;
+    }
+    else
+    {
+        pending_move_ += direction;
+    }
+}
+
+void CameraController::turnToPreset(DomeCameraRotate preset)
+/** Starts turning the Dome camera to the position of an orthographic view, looking at the origin. */
+{
+    transition_ = true;
+    transition_progress_ = 0;
+    transition_preset_ = preset;
+    rotation_velocity_ = glm::vec2(0.0f);
+}
+
+void CameraController::update(ViewCamera& camera, double time)
+/** Called once per frame with the current time in seconds: applies the drag since the last update and integrates
+velocities in fixed steps over the time elapsed since then. The camera is rotated and moved at most once per frame,
+however many events and steps there were. */
+{
+    bool smooth = Config::getParameters().smooth_camera_;
+    if (clock_ < 0 || time < clock_)
+    {
+        clock_ = time;
+    }
+    double elapsed = std::min(time - clock_, kCameraMaxFrameTime);
+    clock_ = time;
+
+    glm::vec2 rotation = pending_rotation_;
+    pending_rotation_ = glm::vec2(0.0f);
+    statistics_.last_frame_events = pending_events_;
+    if (pending_events_ > 0)
+    {
+        statistics_.cursor_events += pending_events_;
+        statistics_.camera_updates++;
+        statistics_.max_frame_events = std::max(statistics_.max_frame_events, pending_events_);
+        pending_events_ = 0;
+    }
+    glm::vec2 move = pending_move_;
+    pending_move_ = glm::vec2(0.0f);
+
+    // While dragging the velocity follows the cursor, averaged over two frames against jitter of event timing.
+    if (dragging_ && elapsed > 0)
+    {
+        rotation_velocity_ = smooth ? 0.5f * (rotation_velocity_ + rotation / static_cast<float>(elapsed)) : glm::vec2(0.0f);
+    }
+
+    // Without smooth camera a key press moves by one unit (see setMoveKey) and holding the key does nothing more.
+    glm::vec2 target_velocity = smooth ? moveInput() * kMoveSpeed : glm::vec2(0.0f);
+    float rotation_decay = std::exp(-kRotationDamping * static_cast<float>(kCameraTimeStep));
+    float move_response = smooth ? 1.0f - std::exp(-kMoveResponse * static_cast<float>(kCameraTimeStep)) : 1.0f;
+    accumulator_ += elapsed;
+    int steps = 0;
+    while (accumulator_ >= kCameraTimeStep)
+    {
+        accumulator_ -= kCameraTimeStep;
+        steps++;
+        if (!dragging_)
+        {
+            rotation += rotation_velocity_ * static_cast<float>(kCameraTimeStep);
+            rotation_velocity_ *= rotation_decay;
+        }
+        move_velocity_ += (target_velocity - move_velocity_) * move_response;
+        move += move_velocity_ * static_cast<float>(kCameraTimeStep);
+    }
+    if (glm::length(rotation_velocity_) < kStopSpeed)
+    {
+        rotation_velocity_ = glm::vec2(0.0f);
+    }
+    if (target_velocity == glm::vec2(0.0f) && glm::length(move_velocity_) < kStopSpeed)
+    {
+        move_velocity_ = glm::vec2(0.0f);
+    }
+
+    if (rotation != glm::vec2(0.0f))
+    {
+        camera.rotate(rotation.x, rotation.y);
+    }
+    if (move != glm::vec2(0.0f))
+    {
+        camera.move(move.x, move.y);
+    }
+    if (transition_)
+    {
+        if (camera.mode() == kDome)
+        {
+            updateTransition(static_cast<DomeCamera&>(camera), steps * kCameraTimeStep, smooth);
+        }
+        else
+        {
+            transition_ = false;
+        }
+    }
+}
+
+void CameraController::reset()
+/** Stops all motion and restarts the clock, e.g. before an input replay. Statistics are kept. */
+{
+    Statistics statistics = statistics_;
+    *this = CameraController();
+    statistics_ = statistics;
+}
+
+bool CameraController::isMoving() const
+{
+    return transition_ || rotation_velocity_ != glm::vec2(0.0f) || move_velocity_ != glm::vec2(0.0f)
+           || pending_rotation_ != glm::vec2(0.0f) || pending_move_ != glm::vec2(0.0f);
+}
+
+CameraController::CoalescingBenchmark CameraController::benchmark(FirstPersonCamera fps, DomeCamera dome, ArcballCamera arcball,
+                                                                  size_t frames, size_t events_per_frame)
+/** Simulates a fast drag on copies of the cameras: frames with events_per_frame cursor events each, as a mouse polled
+at 1000 Hz gives about 16 events per frame at 60 frames per second. The cameras are rotated once per event, as the
+cursor callback did before, and once per frame by the summed deltas, as update() does. */
+{
+    CoalescingBenchmark result;
+    result.frames = frames;
+    result.events_per_frame = events_per_frame;
+    auto delta = [](size_t event) {return glm::vec2(1e-4f * static_cast<float>(event % 7), -1e-4f * static_cast<float>(event % 5));};
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        for (size_t event = 0; event < events_per_frame; event++)
+        {
+            glm::vec2 d = delta(frame * events_per_frame + event);
+            fps.rotate(d.x, d.y);
+            dome.rotate(d.x, d.y);
+            arcball.rotate(d.x, d.y);
+        }
+    }
+    result.per_event_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        glm::vec2 sum(0.0f);
+        for (size_t event = 0; event < events_per_frame; event++)
+        {
+            sum += delta(frame * events_per_frame + event);
+        }
+        fps.rotate(sum.x, sum.y);
+        dome.rotate(sum.x, sum.y);
+        arcball.rotate(sum.x, sum.y);
+    }
+    result.per_frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+glm::vec2 CameraController::moveInput() const
+{
+    return {(move_keys_[0] ? 1.0f : 0.0f) - (move_keys_[1] ? 1.0f : 0.0f),
+            (move_keys_[2] ? 1.0f : 0.0f) - (move_keys_[3] ? 1.0f : 0.0f)};
+}
+
+void CameraController::updateTransition(DomeCamera& camera, double elapsed, bool smooth)
+/** Interpolates yaw, pitch and target of the camera from where the transition started to the preset and the dome's
+center, eased in and out with smoothstep. Yaw takes the shorter way around the dome. */
+{
+    if (transition_progress_ == 0)
+    {
+        from_yaw_ = camera.yaw();
+        from_pitch_ = camera.pitch();
+        from_target_ = camera.targetPosition();
+    }
+    transition_progress_ = smooth ? std::min(1.0, transition_progress_ + elapsed / kTransitionSeconds) : 1.0;
+
+    float to_yaw = from_yaw_, to_pitch = from_pitch_;
+    DomeCamera::presetAngles(transition_preset_, to_yaw, to_pitch);
+    float t = static_cast<float>(transition_progress_);
+    t = t * t * (3.0f - 2.0f * t);
+    camera.setAngles(from_yaw_ + shortestAngle(from_yaw_, to_yaw) * t, from_pitch_ + (to_pitch - from_pitch_) * t);
+    camera.setTargetPosition(from_target_ + (camera.center() - from_target_) * t);
+    if (transition_progress_ >= 1.0)
+    {
+        transition_ = false;
+    }
+}
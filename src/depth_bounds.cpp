@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../include/depth_bounds.h"
+#include "../include/bvh.h"
+#include "../include/scene.h"
+
+namespace
+{
+    glm::vec3 corner(const Aabb& box, int i)
+    {
+        return {(i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z};
+    }
+}
+
+Aabb Aabb::transformed(const glm::mat4& transform) const
+/** Returns the box around the transformed corners of this box. */
+{
+    Aabb box;
+    box.min = glm::vec3(std::numeric_limits<float>::max());
+    box.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 point = glm::vec3(transform * glm::vec4(corner(*this, i), 1.0f));
+        box.min = glm::min(box.min, point);
+        box.max = glm::max(box.max, point);
+    }
+    return box;
+}
+
+void DepthBounds::collectBvhBoxes(const Bvh& bvh, int levels, std::vector<Aabb>& boxes)
+/** Appends the boxes of the BVH nodes at the given depth below the root, and of leaves above it. Nodes are stored in
+depth-first order, so the left child of a node follows it and the right child is stored in the node. */
+{
+    auto const& nodes = bvh.nodes();
+    if (nodes.empty())
+    {
+        return;
+    }
+    std::vector<std::pair<uint32_t, int>> stack = {{0, 0}};
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back().first;
+        int level = stack.back().second;
+        stack.pop_back();
+        const Bvh::Node& node = nodes[index];
+        if (node.count > 0 || level == levels)
+        {
+            boxes.push_back({node.min, node.max});
+            continue;
+        }
+        stack.push_back({node.right_or_first, level + 1});
+        stack.push_back({index + 1, level + 1});
+    }
+}
+
+void DepthBounds::update(const Scene& scene, float model_scale, bool grid, float grid_end)
+/** Collects the boxes of the scene in world coordinates: parts of the rotated primary Object and instances scaled
+by the model scale, and the grid, which is drawn before the scaling. */
+{
+    boxes_.clear();
+    glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(model_scale));
+
+    const Object& primary = scene.primary();
+    glm::mat4 primary_transform = scale * primary.rotation();
+    for (auto const& box : primary.partBoxes())
+    {
+        boxes_.push_back(box.transformed(primary_transform));
+    }
+    for (auto const& instance : scene.instances())
+    {
+        boxes_.push_back(scene.mesh(instance.mesh).bounds().transformed(scale * Scene::instanceTransform(instance)));
+    }
+    if (grid)
+    {
+        boxes_.push_back({glm::vec3(0.0f, 0.0f, -grid_end), glm::vec3(grid_end, grid_end, 0.0f)});
+    }
+}
+
+DepthRange DepthBounds::depthRange(const glm::mat4& view, const ViewFrustum& frustum) const
+/** Returns the range of depths of the boxes not entirely outside one side of the view, or behind a perspective camera.
+A box partly inside contributes all of its depths, so the range is never too short. */
+{
+    DepthRange range;
+    range.boxes = boxes_.size();
+    range.min_depth = std::numeric_limits<double>::max();
+    range.max_depth = std::numeric_limits<double>::lowest();
+    for (auto const& box : boxes_)
+    {
+        // Bits of the sides each corner is outside of; a box is culled if all corners are outside the same side.
+        int outside_all = 0x1f;
+        double min_depth = std::numeric_limits<double>::max();
+        double max_depth = std::numeric_limits<double>::lowest();
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec4 point = view * glm::vec4(corner(box, i), 1.0f);
+            double depth = -point.z;
+            // Perspective sides are scaled by the depth, orthogonal sides are not.
+            double extent = frustum.orthographic ? 1.0 : depth;
+            int outside = 0;
+            outside |= point.x < frustum.left * extent ? 1 : 0;
+            outside |= point.x > frustum.right * extent ? 2 : 0;
+            outside |= point.y < frustum.bottom * extent ? 4 : 0;
+            outside |= point.y > frustum.top * extent ? 8 : 0;
+            // Orthogonal views may show boxes behind the camera, their near plane can be negative.
+            outside |= !frustum.orthographic && depth <= 0 ? 16 : 0;
+            outside_all &= outside;
+            min_depth = std::min(min_depth, depth);
+            max_depth = std::max(max_depth, depth);
+        }
+        if (outside_all != 0)
+        {
+            continue;
+        }
+        range.visible++;
+        range.min_depth = std::min(range.min_depth, min_depth);
+        range.max_depth = std::max(range.max_depth, max_depth);
+    }
+    if (range.empty())
+    {
+        range.min_depth = range.max_depth = 0;
+    }
+    return range;
+}
@@ -1,7 +1,11 @@
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <tuple>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "stb_image_write.h"
 #include "../include/drawing_lib.h"
 #include "../include/font.h"
@@ -24,128 +28,224 @@ void DrawingLib::getWindowSize(GLFWwindow* window)
     dim_ratio_ = static_cast<float>(window_height_) / static_cast<float>(window_width_);
 }
 
-void DrawingLib::drawScene(GLFWwindow* window, Object &object, bool imGuiCaptureMouse)
-/** Renders the scene based on the current configuration, either in engineering or regular view. */
+std::unique_ptr<FrameSnapshot> DrawingLib::makeSnapshot(Scene& scene, bool imGuiCaptureMouse)
+/** Called on the main thread once the frame's events and UI are processed: copies cameras, Parameters and the input
+requests collected since the previous frame into a snapshot for the render thread, and clears the requests. */
 {
     imgui_capture_mouse_ = imGuiCaptureMouse;
-
     if (Config::getParameters().engineering_view_)
     {
-        drawEngineeringScene(window, object);
+        // Free view uses Dome camera by default, or the Arcball camera if it is selected.
+        if (current_camera_->mode() != kArcball)
+        {
+            turnOnDomeCamera();
+        }
+        // Engineering view assumes orthogonal projection.
+        engineering_camera_.orthogonalView();
     }
-    else
+    layout_ = layoutOf(Config::getParameters());
+    // Free views after the first get cameras of their own, starting where the Dome camera is.
+    size_t extra_cameras = layout_.freeCameraCount() > 0 ? layout_.freeCameraCount() - 1 : 0;
+    if (free_cameras_.size() > extra_cameras)
+    {
+        free_cameras_.erase(free_cameras_.begin() + static_cast<std::ptrdiff_t>(extra_cameras), free_cameras_.end());
+    }
+    while (free_cameras_.size() < extra_cameras)
+    {
+        free_cameras_.push_back(dome_);
+    }
+    if (static_cast<size_t>(controlled_camera_) > free_cameras_.size())
     {
-        drawRegularScene(window, object);
+        controlled_camera_ = 0;
+        camera_controller_.reset();
     }
+    camera_controller_.update(freeCamera(controlled_camera_), inputTime());
+
+    auto frame = std::unique_ptr<FrameSnapshot>(new FrameSnapshot(fps_, dome_, arcball_, engineering_camera_));
+    frame->config = Config::publish();
+    frame->window_width = window_width_;
+    frame->window_height = window_height_;
+    frame->camera_mode = current_camera_->mode();
+    frame->layout = layout_;
+    frame->free_cameras = free_cameras_;
+
+    frame->imgui_capture_mouse = imgui_capture_mouse_;
+    frame->cursor_x = current_pos_x_;
+    frame->cursor_y = current_pos_y_;
+    frame->select_requested = select_requested_;
+    frame->pick_requested = pick_requested_;
+    frame->pick_x = pick_pos_x_;
+    frame->pick_y = pick_pos_y_;
+    frame->measure_start_requested = measure_start_requested_;
+    frame->measure_update_requested = measure_update_requested_;
+    frame->measure_finish_requested = measure_finish_requested_;
+    frame->ruler = ruler_;
+    frame->ruler_start_x = start_pos_x_;
+    frame->ruler_start_y = start_pos_y_;
+    frame->ruler_viewport = current_viewport_;
+    frame->scene = &scene;
+
+    select_requested_ = false;
+    pick_requested_ = false;
+    measure_start_requested_ = false;
+    measure_update_requested_ = false;
+    measure_finish_requested_ = false;
+    return frame;
 }
 
-void DrawingLib::drawRegularScene(GLFWwindow* window, Object &object)
-/** Renders the scene using the regular view configuration. */
+void DrawingLib::drawScene(GLFWwindow* window, FrameSnapshot& frame)
+/** Called on the render thread: renders the scene of the snapshot in each viewport of its layout. Selection, picking
+and measurement work on the primary Object of the scene. */
 {
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    // Viewport is the region of the window where the rendered image is displayed.
-    //It's specified in screen coordinates, with (0, 0) being the bottom-left corner of the window
-    glViewport(0, 0, window_width_, window_height_);
-
-    // Switches the current matrix mode to the projection matrix.
-    // It indicates that subsequent matrix operations (like glLoadIdentity(), glOrtho(), glFrustum(), etc.)
-    // will affect the projection matrix.
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    current_camera_->setView(dim_ratio_);
+    Object& object = frame.scene->primary();
+    // Meshes loaded in the background replace the drawn one or join the scene at the start of a frame.
+    frame.scene->finishLoading();
 
-    // After setting up the projection matrix, switches to GL_MODELVIEW mode to handle model transformations.
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    current_camera_->applyMatrix();
+    auto const& params = frame.parameters();
+    if (params.adaptive_depth_)
+    {
+        depth_bounds_.update(*frame.scene, modelScale(object, params), params.grid_, params.grid_end_);
+    }
+    reversed_depth_ = params.reversed_depth_ && scene_framebuffer_.begin(frame.window_width, frame.window_height);
 
-    if (Config::getParameters().grid_)
+    drawViewports(frame);
+    if (reversed_depth_)
     {
-        drawGrid();
+        scene_framebuffer_.end();
     }
 
-    float scalingFactor = object.calculateScalingFactor(reference_size_);
-    glScalef(scalingFactor, scalingFactor, scalingFactor);
+    // The shape read back from the ID buffer on the previous frame becomes the selection.
+    uint32_t shape;
+    if (id_buffer_.readResult(shape))
+    {
+        selected_shape_ = shape;
+        selection_version_ = object.version();
+    }
+    if (selection_version_ != object.version())
+    {
+        selected_shape_ = IdBuffer::kNoShape;
+    }
 
-    object.draw();
+    // Picking is resolved after drawing, when matrices of all viewports are up to date.
+    if (frame.select_requested)
+    {
+        selectShape(frame, object);
+    }
+    if (frame.pick_requested)
+    {
+        pickSurface(frame, object);
+    }
+    if (frame.parameters().measure_mode_)
+    {
+        updateMeasurement(frame, object);
+    }
 }
 
-void DrawingLib::drawEngineeringScene(GLFWwindow* window, Object &object)
-/** Renders the scene using the Engineering view configuration. */
+void DrawingLib::drawViewports(FrameSnapshot& frame)
+/** Renders the scene in each viewport of the snapshot's layout. Work that does not depend on the view is done once
+per frame before the viewports are drawn: instance transforms are uploaded, section contours are computed, and the
+boxes fitting the depth ranges are gathered in drawScene. Front, Top and Side views use the engineering camera, which
+is orthogonal, and each Free view uses its own camera, the first one the current camera (see makeSnapshot). */
 {
+    Scene& scene = *frame.scene;
+    Object& object = scene.primary();
+    auto const& params = frame.parameters();
     glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
+    glDepthFunc(reversed_depth_ ? GL_GEQUAL : GL_LEQUAL);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Free view uses Dome camera by default.
-    turnOnDomeCamera();
-    // Engineering view assumes orthogonal projection.
-    engineering_camera_.orthogonalView();
-
-    // each view (Front, Top, Side and Free) is rendered individually.
-    for (int i = 0; i< 2; i++)
-        {
-        for (int j = 0; j< 2; j++)
-            {
-            DomeCameraRotate ortho_view;
-            dim_ratio_ = static_cast<float>(window_height_/2) / static_cast<float>(window_width_/2);
-            glViewport(i * (window_width_/2), j * (window_height_/2), window_width_/2, window_height_/2);
-            glMatrixMode(GL_PROJECTION);
-            glLoadIdentity();
+    // Section contours are computed once per frame for all views, and only if the plane or the object changed.
+    bool section = params.engineering_view_ && params.section_;
+    if (section)
+    {
+        section_slicer_.update(object, sectionNormal(), params.section_position_);
+    }
+    scene.prepareInstances(frame.layout.size());
 
-            if (i == 0 && j == 0)
-            {
-                ortho_view = kFront;
-            }
-            else if (i == 1 && j == 0){
-                ortho_view = kSide;
-            }
-            else if (i == 0 && j == 1){
-                ortho_view = kTop;
-            }
-            else{
-                ortho_view = kFree;
-            }
+    viewport_transforms_.resize(frame.layout.size());
+    depth_ranges_.resize(frame.layout.size());
+    float scalingFactor = modelScale(object, params);
+    for (size_t i = 0; i < frame.layout.size(); i++)
+    {
+        DomeCameraRotate view = frame.layout[i].view;
+        ViewportRect rect = frame.layout.rect(i, frame.window_width, frame.window_height);
+        float dim_ratio = rect.dimRatio();
 
-            if (ortho_view == kFree)
-            {
-                current_camera_ ->setView(dim_ratio_);
-                glMatrixMode(GL_MODELVIEW);
-                glLoadIdentity();
-                current_camera_-> applyMatrix();
-            }
-            else {
-                engineering_camera_.setView(dim_ratio_);
-                glMatrixMode(GL_MODELVIEW);
-                glLoadIdentity();
-                engineering_camera_.viewOrtho(ortho_view);
-            }
-            // ruler cannot be used in Free view section.
-            if ((std::get<0>(current_viewport_) == i && std::get<1>(current_viewport_) == j) || (i==1 && j == 1)){
-                if (ruler_){
-                    drawRuler();
-                }
-            }
+        // Viewport is the region of the window where the rendered image is displayed.
+        // It's specified in window coordinates, with (0, 0) being the bottom-left corner of the window.
+        glViewport(rect.x, rect.y, rect.width, rect.height);
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
 
-            if (Config::getParameters().grid_)
-            {
-                drawGrid();
-            }
+        if (view == kFree)
+        {
+            ViewCamera& camera = frame.camera(frame.layout[i].camera);
+            setProjection(frame, camera, dim_ratio, static_cast<int>(i));
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            camera.applyMatrix();
+        }
+        else
+        {
+            // The camera is moved to the orthogonal view first, so its depth range is fitted from there.
+            glMatrixMode(GL_MODELVIEW);
+            glLoadIdentity();
+            frame.engineering.viewOrtho(view);
+            glMatrixMode(GL_PROJECTION);
+            setProjection(frame, frame.engineering, dim_ratio, static_cast<int>(i));
+            glMatrixMode(GL_MODELVIEW);
+        }
+        // The ruler is drawn in the view it was started in and in Free views.
+        if (frame.ruler && (static_cast<int>(i) == frame.ruler_viewport || view == kFree))
+        {
+            drawRuler(frame);
+        }
 
-            float scalingFactor = object.calculateScalingFactor(reference_size_);
-            glScalef(scalingFactor, scalingFactor, scalingFactor);
+        if (params.grid_)
+        {
+            drawGrid();
+        }
 
-            object.draw();
+        glScalef(scalingFactor, scalingFactor, scalingFactor);
 
-            printOrthoViewType(i, j, ortho_view);
+        // Instances are drawn before the primary Object, whose rotation stays on the matrix stack for the selection and markers.
+        scene.drawInstances();
+        object.draw();
+        captureViewportTransform(static_cast<int>(i));
+        if (section)
+        {
+            section_slicer_.draw();
+        }
+        drawSelection(object);
+        drawPickMarker();
+        if (params.measure_mode_)
+        {
+            measure_tool_.draw();
         }
 
+        if (params.engineering_view_)
+        {
+            printOrthoViewType(view, dim_ratio);
+        }
     }
 }
 
+void DrawingLib::setProjection(const FrameSnapshot& frame, ViewCamera& camera, float dim_ratio, int viewport)
+/** Multiplies the current matrix by the camera's projection. With adaptive depth, the near and far planes of the
+snapshot's camera are first fitted to the boxes of the scene in its view. */
+{
+    if (frame.parameters().adaptive_depth_)
+    {
+        depth_ranges_[viewport] = camera.fitDepthRange(depth_bounds_, dim_ratio, reversed_depth_);
+    }
+    else
+    {
+        depth_ranges_[viewport] = DepthRange();
+        depth_ranges_[viewport].near = camera.getCameraViewParams().near;
+        depth_ranges_[viewport].far = camera.getCameraViewParams().far;
+    }
+    camera.setView(dim_ratio, reversed_depth_);
+}
 
 void DrawingLib::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 /** Handles mouse button events in a GLFW window. If the cursor position is not on any of ImGui elements,
@@ -154,31 +254,61 @@ it performs actions on left-click, double left-click and right-click. */
     // this boolean is initialized in main.py and checks if mouse position is on any of ImGui elements
     if (!imgui_capture_mouse_)
     {
-        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        // Ctrl + left click picks a point on the object's surface instead of rotating the camera.
+        if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL))
         {
+            pick_requested_ = true;
+            pick_pos_x_ = current_pos_x_;
+            pick_pos_y_ = current_pos_y_;
+        }
+        else if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        {
+            // Dragging in a Free view turns that view's camera; orthogonal views turn the current camera.
+            int viewport = layout_.viewportAt(current_pos_x_, current_pos_y_, window_width_, window_height_);
+            int camera = viewport >= 0 && layout_[viewport].view == kFree ? layout_[viewport].camera : 0;
+            if (camera != controlled_camera_)
+            {
+                controlled_camera_ = camera;
+                camera_controller_.reset();
+            }
             left_button_down_ = true;
+            camera_controller_.setDragging(true);
             glfwGetCursorPos(window, &cursor_pos_x_, &cursor_pos_y_);
+            press_pos_x_ = current_pos_x_;
+            press_pos_y_ = current_pos_y_;
         }
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE)
         {
+            // A click without dragging the camera selects a shape.
+            if (left_button_down_ && std::abs(current_pos_x_ - press_pos_x_) <= 2 && std::abs(current_pos_y_ - press_pos_y_) <= 2)
+            {
+                select_requested_ = true;
+            }
             left_button_down_   = false;
+            camera_controller_.setDragging(false);
+        }
+        // In measurement mode right mouse button measures between points snapped to the object instead of the ruler.
+        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS && Config::getParameters().measure_mode_)
+        {
+            measure_start_requested_ = true;
         }
-        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
+        else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
         {
             right_button_down_ = true;
             glfwGetCursorPos(window, &cursor_pos_x_, &cursor_pos_y_);
-            current_viewport_ = getCurrentViewport(current_pos_x_, current_pos_y_);
+            current_viewport_ = layout_.viewportAt(current_pos_x_, current_pos_y_, window_width_, window_height_);
         }
         if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
         {
             right_button_down_   = false;
             ruler_ = false;
+            measure_finish_requested_ = true;
         }
     }
 }
 
 
-void DrawingLib::printOrthoViewType(int i, int j, DomeCameraRotate ortho_view)
+void DrawingLib::printOrthoViewType(DomeCameraRotate ortho_view, float dim_ratio)
 /** Prints the name of the view (Front, Top, Side) when Engineering view is on. */
 {
     glClear(GL_DEPTH_BUFFER_BIT);
@@ -187,7 +317,7 @@ void DrawingLib::printOrthoViewType(int i, int j, DomeCameraRotate ortho_view)
     glLoadIdentity();
 
     glOrtho(-1, 1,
-            -1 * dim_ratio_, 1 * dim_ratio_,
+            -1 * dim_ratio, 1 * dim_ratio,
             -1.0, 1.0);
 
     glMatrixMode(GL_MODELVIEW);
@@ -195,7 +325,7 @@ void DrawingLib::printOrthoViewType(int i, int j, DomeCameraRotate ortho_view)
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     glColor3f(1,1,1);  // Sets the colour to white.
-    glRasterPos2f(0.8*dim_ratio_ , -0.8*dim_ratio_);
+    glRasterPos2f(0.8*dim_ratio , -0.8*dim_ratio);
     print_string(OrthViewToString(ortho_view).c_str());
 }
 
@@ -210,17 +340,20 @@ void DrawingLib::cursorPositionCallback(GLFWwindow* window,
     current_pos_x_ = input_cursor_pos_x;
     current_pos_y_ = input_cursor_pos_y;
 
+    measure_update_requested_ = true;
+
     if (left_button_down_)
     {
         auto delta_coordinates = calculateCoordinatesOnMouseMove(2);
-        current_camera_->rotate(std::get<0>(delta_coordinates), std::get<1>(delta_coordinates));
+        camera_controller_.addRotation(std::get<0>(delta_coordinates), std::get<1>(delta_coordinates));
     }
     if (right_button_down_)
     {
         // ruler is turned on only in engineering view and for Front, Top, Side views (not Free view).
         if (!ruler_)
         {
-            if (current_camera_->mode() == kDome && !(std::get<0>(current_viewport_) == 1 && std::get<1>(current_viewport_) == 1))
+            if (current_camera_->mode() != kFirstPerson && current_viewport_ >= 0 &&
+                current_viewport_ < static_cast<int>(layout_.size()) && layout_[current_viewport_].view != kFree)
             {
                 ruler_ = true;
                 start_pos_x_ = current_pos_x_;
@@ -231,43 +364,31 @@ void DrawingLib::cursorPositionCallback(GLFWwindow* window,
 }
 
 void DrawingLib::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
-/** Handles keyboard events in a GLFW window.*/
+/** Handles keyboard events in a GLFW window. Arrow keys are passed to the camera controller, which moves the camera
+while they are held.*/
 {
+    if (action == GLFW_PRESS || action == GLFW_RELEASE)
+    {
+        camera_controller_.setMoveKey(key, action == GLFW_PRESS);
+    }
     if (action == GLFW_PRESS)
     {
-        auto shortcut_keys = Config::getShortcuts();
-        char key_char = static_cast<char>(key);
-        if (shortcut_keys["SwitchCameraMode"] == key_char)
-        {
-            switchPerspectiveCameraMode();  // switch between First person camera and Dome camera
-        }
-        if (shortcut_keys["SwitchCameraView"] == key_char)
-        {
-            switchCameraView();  // switch between Orthogonal view and Perspective view
-        }
-        if (shortcut_keys["EnableGrid"] == key_char)
-        {
-            Config::switchGrid();  // enable/disable grid
-        }
-        if (shortcut_keys["SwitchEngineeringView"] == key_char)
-        {
-            Config::switchEngineeringView(); // enable/disable Engineering view
-        }
-        if (key == GLFW_KEY_LEFT)
-        {
-            current_camera_->move(1,0);
-        }
-        if (key == GLFW_KEY_RIGHT)
+        switch (Config::shortcutAction(key))
         {
-            current_camera_->move(-1,0);
-        }
-        if (key == GLFW_KEY_UP)
-        {
-            current_camera_->move(0,1);
-        }
-        if (key == GLFW_KEY_DOWN)
-        {
-            current_camera_->move(0,-1);
+            case kSwitchCameraModeShortcut:
+                switchPerspectiveCameraMode();  // switch between First person camera and Dome camera
+                break;
+            case kSwitchCameraViewShortcut:
+                switchCameraView();  // switch between Orthogonal view and Perspective view
+                break;
+            case kEnableGridShortcut:
+                Config::switchGrid();  // enable/disable grid
+                break;
+            case kSwitchEngineeringViewShortcut:
+                Config::switchEngineeringView(); // enable/disable Engineering view
+                break;
+            default:
+                break;
         }
         if (key == GLFW_KEY_HOME)
         {
@@ -282,7 +403,13 @@ If ImGui is not capturing the mouse input and the zoom level is adjusted based o
 {
     if (!imgui_capture_mouse_)
         {
-            if (yoffset > 0)
+            // Free views with a camera of their own zoom alone; the other views zoom together.
+            int viewport = layout_.viewportAt(current_pos_x_, current_pos_y_, window_width_, window_height_);
+            if (viewport >= 0 && layout_[viewport].view == kFree && layout_[viewport].camera > 0)
+            {
+                freeCamera(layout_[viewport].camera).zoom(yoffset > 0 ? 0.1 : -0.1);
+            }
+            else if (yoffset > 0)
             {
                 current_camera_->zoom(0.1);   // zoom-in
                 engineering_camera_.zoom(0.1);
@@ -304,27 +431,150 @@ void DrawingLib::defineCallbackFunction(GLFWwindow* window)
     glfwSetWindowUserPointer(window, this);
 
     // These callbacks enable interaction with the window using the mouse for actions such as clicking, dragging, and scrolling.
+    // Every event is passed to the input recorder first; live input is ignored while a recorded log is replayed.
     glfwSetMouseButtonCallback(window, [](GLFWwindow* win, int button, int action, int mods) {
         auto* drawing_lib = static_cast<DrawingLib*>(glfwGetWindowUserPointer(win));
+        if (drawing_lib->input_recorder_.isReplaying()) return;
+        drawing_lib->input_recorder_.recordMouseButton(button, action, mods, drawing_lib->imgui_capture_mouse_);
         drawing_lib->mouseButtonCallback(win, button, action, mods);
     });
 
     glfwSetCursorPosCallback(window, [](GLFWwindow* win, double xpos, double ypos) {
         auto* drawing_lib = static_cast<DrawingLib*>(glfwGetWindowUserPointer(win));
+        if (drawing_lib->input_recorder_.isReplaying()) return;
+        drawing_lib->input_recorder_.recordCursorPosition(xpos, ypos, drawing_lib->imgui_capture_mouse_);
         drawing_lib->cursorPositionCallback(win, xpos, ypos);
     });
 
     glfwSetKeyCallback(window, [](GLFWwindow* win, int key, int scancode, int action, int mods) {
         auto* drawing_lib = static_cast<DrawingLib*>(glfwGetWindowUserPointer(win));
+        if (drawing_lib->input_recorder_.isReplaying()) return;
+        drawing_lib->input_recorder_.recordKey(key, action, mods);
         drawing_lib->keyCallback(win, key, scancode, action, mods);
     });
 
     glfwSetScrollCallback(window, [](GLFWwindow* win, double xoffset, double yoffset) {
         auto* drawing_lib = static_cast<DrawingLib*>(glfwGetWindowUserPointer(win));
+        if (drawing_lib->input_recorder_.isReplaying()) return;
+        drawing_lib->input_recorder_.recordScroll(yoffset, drawing_lib->imgui_capture_mouse_);
         drawing_lib->scrollCallback(win, yoffset);
     });
 }
 
+void DrawingLib::dispatchInputEvent(GLFWwindow* window, const InputRecorder::InputEvent& event)
+/** Passes a recorded event to the corresponding callback. Mouse events are handled with the ImGui capture state
+stored at recording time, so clicks on ImGui elements are not applied to the scene during replay. */
+{
+    switch (event.type)
+    {
+        case kMouseButtonEvent:
+            imgui_capture_mouse_ = event.imgui_capture_mouse;
+            mouseButtonCallback(window, event.code, event.action, event.mods);
+            break;
+        case kCursorPositionEvent:
+            imgui_capture_mouse_ = event.imgui_capture_mouse;
+            cursorPositionCallback(window, event.x, event.y);
+            break;
+        case kKeyEvent:
+            keyCallback(window, event.code, 0, event.action, event.mods);
+            break;
+        case kScrollEvent:
+            imgui_capture_mouse_ = event.imgui_capture_mouse;
+            scrollCallback(window, event.y);
+            break;
+        default:
+            break;
+    }
+}
+
+void DrawingLib::processRecordedInput(GLFWwindow* window)
+/** Called once per frame after events are polled: marks the end of the frame while recording,
+dispatches events recorded for this frame while replaying. */
+{
+    if (input_recorder_.isRecording())
+    {
+        input_recorder_.recordFrameEnd();
+    }
+    if (input_recorder_.isReplaying())
+    {
+        for (auto const& event : input_recorder_.nextReplayEvents())
+        {
+            dispatchInputEvent(window, event);
+        }
+    }
+}
+
+void DrawingLib::resetInputState()
+/** Resets all cameras and mouse state, so recording and replay start from the same point. */
+{
+    fps_.resetCamera();
+    fps_.resetView();
+    dome_.resetCamera();
+    dome_.resetView();
+    arcball_.resetCamera();
+    arcball_.resetView();
+    engineering_camera_.resetCamera();
+    engineering_camera_.resetView();
+    free_cameras_.clear();
+    controlled_camera_ = 0;
+
+    left_button_down_ = false;
+    right_button_down_ = false;
+    camera_controller_.reset();
+    ruler_ = false;
+    measure_tool_.clear();
+    select_requested_ = false;
+    measure_start_requested_ = false;
+    measure_update_requested_ = false;
+    measure_finish_requested_ = false;
+}
+
+void DrawingLib::startInputRecording()
+/** Stores the current view configuration as the initial state of the recording, resets cameras and starts recording. */
+{
+    InputRecorder::InitialState state;
+    state.engineering_view = Config::getParameters().engineering_view_;
+    state.grid = Config::getParameters().grid_;
+    state.dome_camera = current_camera_->mode() == kDome;
+    state.arcball_camera = current_camera_->mode() == kArcball;
+    state.orthogonal_view = current_camera_->view() == kOrthogonal;
+    state.viewport_layout = Config::getParameters().viewport_layout_;
+    state.cursor_x = current_pos_x_;
+    state.cursor_y = current_pos_y_;
+
+    resetInputState();
+    input_recorder_.startRecording(state);
+}
+
+void DrawingLib::startInputReplay(ReplaySpeed speed)
+/** Restores the view configuration stored in the loaded log, resets cameras and starts replaying recorded events. */
+{
+    auto const& state = input_recorder_.initialState();
+
+    if (Config::getParameters().engineering_view_ != state.engineering_view)
+    {
+        Config::switchEngineeringView();
+    }
+    Config::editParameters().grid_ = state.grid;
+    Config::editParameters().viewport_layout_ = state.viewport_layout;
+
+    current_camera_ = state.dome_camera ? static_cast<ViewCamera*>(&dome_) : static_cast<ViewCamera*>(&fps_);
+    if (state.arcball_camera)
+    {
+        current_camera_ = &arcball_;
+    }
+    if ((current_camera_->view() == kOrthogonal) != state.orthogonal_view)
+    {
+        current_camera_->switchView();
+    }
+
+    resetInputState();
+    current_pos_x_ = state.cursor_x;
+    current_pos_y_ = state.cursor_y;
+
+    input_recorder_.startReplay(speed);
+}
+
 
 void DrawingLib::drawGrid()
 /** Draws grid in steps: xz-plane with grid frequency defined in Config class, arrow for X-, Y-, Z-axis,
@@ -359,6 +609,15 @@ coordinates of the maximum coordinate of xz-plane.*/
 }
 
 
+glm::vec3 DrawingLib::sectionNormal()
+/** Returns the normal of the section plane from its azimuth (around the Y-axis) and elevation set in Config. */
+{
+    auto const& params = Config::getParameters();
+    float azimuth = glm::radians(params.section_azimuth_);
+    float elevation = glm::radians(params.section_elevation_);
+    return {std::cos(elevation) * std::sin(azimuth), std::sin(elevation), std::cos(elevation) * std::cos(azimuth)};
+}
+
 void DrawingLib::drawAxisArrow(float x, float y, float z, const std::string& axis_name)
 /** Draws axis arrow in steps: axis line, arrow and prints axis name.*/
 {
@@ -410,6 +669,17 @@ void DrawingLib::drawAxisArrow(float x, float y, float z, const std::string& axi
     print_string(axis_name.c_str());
 }
 
+double DrawingLib::inputTime() const
+/** Returns the time the camera controller is updated with: the recorder's clock while input is recorded or replayed,
+so replayed camera motion does not depend on the replay speed, and GLFW time otherwise. */
+{
+    if (input_recorder_.isRecording() || input_recorder_.isReplaying())
+    {
+        return input_recorder_.time();
+    }
+    return glfwGetTime();
+}
+
 std::tuple<double, double> DrawingLib::calculateCoordinatesOnMouseMove(int correction_factor) const
 /** Calculates the change in object coordinates of mouse cursor, converting screen space coordinates to
  normalized device coordinates (NDC) and then to frustum coordinates, with depth correction applied. */
@@ -437,21 +707,31 @@ std::tuple<double, double> DrawingLib::calculateCoordinatesOnMouseMove(int corre
 }
 
 
-void DrawingLib::drawRuler()
+void DrawingLib::drawRuler(FrameSnapshot& frame)
 /** Draws ruler in Engineering view. In any of Front, Top, Side views ruler is turned on with right mouse click.
 Start, end coordinates and length of the draw vector are displayed as well.*/
 {
-    auto start = convertCoordinates(start_pos_x_, start_pos_y_);
+    if (frame.ruler_viewport < 0 || frame.ruler_viewport >= static_cast<int>(frame.layout.size()))
+    {
+        return;
+    }
+    DomeCameraRotate view = frame.layout[frame.ruler_viewport].view;
+    if (view == kFree)
+    {
+        return;
+    }
+    ViewportRect rect = frame.layout.rect(frame.ruler_viewport, frame.window_width, frame.window_height);
+    auto start = convertCoordinates(frame, frame.ruler_start_x, frame.ruler_start_y, rect);
     double adjusted_start_x = std::get<0>(start);
     double adjusted_start_y = std::get<1>(start);
 
-    auto end = convertCoordinates(current_pos_x_, current_pos_y_);
+    auto end = convertCoordinates(frame, frame.cursor_x, frame.cursor_y, rect);
     double adjusted_current_x = std::get<0>(end);
     double adjusted_current_y = std::get<1>(end);
 
     // depends on the view and which plane (xy, xz or yz) is nor displayed, the corresponding coordinate is set to 0.
     double x1,y1,z1, x2, y2, z2;
-    if (std::get<0>(current_viewport_) == 0 && std::get<1>(current_viewport_) == 0){
+    if (view == kFront){
         x1 =adjusted_start_x;
         x2 = adjusted_current_x;
         y1 = adjusted_start_y;
@@ -459,7 +739,7 @@ Start, end coordinates and length of the draw vector are displayed as well.*/
         z1 = 0;
         z2 = 0;
     }
-    if (std::get<0>(current_viewport_) == 0 && std::get<1>(current_viewport_) == 1){
+    if (view == kTop){
         x1 = adjusted_start_x;
         x2 = adjusted_current_x;
         y1 = 0;
@@ -467,7 +747,7 @@ Start, end coordinates and length of the draw vector are displayed as well.*/
         z1 = -adjusted_start_y;
         z2 = -adjusted_current_y;
     }
-    if (std::get<0>(current_viewport_) == 1 && std::get<1>(current_viewport_) == 0){
+    if (view == kSide){
         x1 = 0;
         x2 = 0;
         y1 = adjusted_start_y;
@@ -476,6 +756,15 @@ Start, end coordinates and length of the draw vector are displayed as well.*/
         z2 = -adjusted_current_x;
     }
 
+    // Views look at the center of the engineering camera, which is the origin until a sphere is framed.
+    const glm::vec3& center = frame.engineering.center();
+    x1 += center.x;
+    x2 += center.x;
+    y1 += center.y;
+    y2 += center.y;
+    z1 += center.z;
+    z2 += center.z;
+
     glColor3f(1,1,0);
     glBegin(GL_LINES);
     glVertex3f(x1, y1, z1);
@@ -505,39 +794,168 @@ Start, end coordinates and length of the draw vector are displayed as well.*/
     print_string(string_length.c_str());
 }
 
-std::tuple<int, int>  DrawingLib::getCurrentViewport(double x_screen, double y_screen) const
-/** Determines the viewport indices (i, j) by dividing the screen coordinates by half the window width and height,
-effectively identifying the viewport quadrant where the given screen coordinates reside. It is applied when
-Engineering view is turned on. */
+void DrawingLib::captureViewportTransform(int index)
+/** Stores current modelview and projection matrices and the viewport. Called right after the Object is drawn,
+so the modelview matrix includes the Object's scaling and rotation. */
+{
+    ViewportTransform& transform = viewport_transforms_[index];
+    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(transform.model_view));
+    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(transform.projection));
+    // Picking and the ID buffer work with standard depth.
+    if (reversed_depth_)
+    {
+        transform.projection = ViewCamera::standardDepthProjection(transform.projection);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    transform.viewport = glm::vec4(viewport[0], viewport[1], viewport[2], viewport[3]);
+    transform.valid = true;
+}
+
+const DrawingLib::ViewportTransform* DrawingLib::viewportTransformAt(const FrameSnapshot& frame, double x_screen, double y_screen) const
+/** Returns matrices of the viewport under the cursor, or nullptr if that viewport has not been drawn yet. */
+{
+    int index = frame.layout.viewportAt(x_screen, y_screen, frame.window_width, frame.window_height);
+    if (index < 0 || index >= static_cast<int>(viewport_transforms_.size()))
+    {
+        return nullptr;
+    }
+    const ViewportTransform& transform = viewport_transforms_[index];
+    return transform.valid ? &transform : nullptr;
+}
+
+bool DrawingLib::cursorRay(const FrameSnapshot& frame, double x_screen, double y_screen, Ray& ray) const
+/** Builds a ray in object coordinates through the cursor position by unprojecting it onto the near and far planes
+of the viewport under the cursor. Works for perspective and orthogonal projections of any camera. */
+{
+    const ViewportTransform* viewport_transform = viewportTransformAt(frame, x_screen, y_screen);
+    if (viewport_transform == nullptr)
+    {
+        return false;
+    }
+    const ViewportTransform& transform = *viewport_transform;
+
+    // Window coordinates of OpenGL start at the bottom-left corner, cursor coordinates at the top-left corner.
+    auto x_window = static_cast<float>(x_screen);
+    auto y_window = static_cast<float>(frame.window_height - y_screen);
+    glm::vec3 near_point = glm::unProject(glm::vec3(x_window, y_window, 0.0f), transform.model_view, transform.projection, transform.viewport);
+    glm::vec3 far_point = glm::unProject(glm::vec3(x_window, y_window, 1.0f), transform.model_view, transform.projection, transform.viewport);
+
+    ray.origin = near_point;
+    ray.direction = glm::normalize(far_point - near_point);
+    return true;
+}
+
+void DrawingLib::pickSurface(const FrameSnapshot& frame, const Object& object)
+/** Finds the point of the Object's surface under the cursor using its BVH and measures the query time. */
+{
+    Ray ray;
+    if (!cursorRay(frame, frame.pick_x, frame.pick_y, ray))
+    {
+        return;
+    }
+
+    RayHit hit;
+    auto start = std::chrono::steady_clock::now();
+    last_pick_.hit = object.pick(ray, hit);
+    last_pick_.time_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    last_pick_.point = hit.point;
+    last_pick_.triangle = hit.triangle;
+}
+
+void DrawingLib::updateMeasurement(const FrameSnapshot& frame, const Object& object)
+/** Applies measurement requests collected from mouse events since the last frame. The snap radius is
+kSnapPixels in the viewport under the cursor, converted to object coordinates at the depth of the snapped point. */
 {
-    int viewport_width = window_width_ / 2;
-    int viewport_height = window_height_ / 2;
+    const float kSnapPixels{8.0f};
+
+    if (!frame.measure_start_requested && !frame.measure_update_requested && !frame.measure_finish_requested)
+    {
+        return;
+    }
 
-    int i = static_cast<int>(x_screen) / viewport_width;
-    int j = static_cast<int>(window_height_ - y_screen) / viewport_height;
+    Ray ray;
+    const ViewportTransform* transform = viewportTransformAt(frame, frame.cursor_x, frame.cursor_y);
+    if (!frame.imgui_capture_mouse && transform != nullptr && cursorRay(frame, frame.cursor_x, frame.cursor_y, ray))
+    {
+        auto snap_radius = [transform, kSnapPixels](const glm::vec3& point) {
+            glm::vec3 window = glm::project(point, transform->model_view, transform->projection, transform->viewport);
+            glm::vec3 offset = glm::unProject(window + glm::vec3(kSnapPixels, 0.0f, 0.0f),
+                                              transform->model_view, transform->projection, transform->viewport);
+            return glm::distance(point, offset);
+        };
+
+        if (frame.measure_start_requested)
+        {
+            measure_tool_.start(object, ray, snap_radius);
+        }
+        else if (frame.measure_update_requested)
+        {
+            measure_tool_.update(object, ray, snap_radius);
+        }
+    }
+    if (frame.measure_finish_requested)
+    {
+        measure_tool_.finish();
+    }
+}
 
-    return std::make_tuple(i, j);
+void DrawingLib::selectShape(const FrameSnapshot& frame, const Object& object)
+/** Renders shape IDs for the viewport under the cursor, if its matrices changed since the last selection,
+and requests the ID under the cursor. The result is applied on the next frame. */
+{
+    const ViewportTransform* transform = viewportTransformAt(frame, frame.cursor_x, frame.cursor_y);
+    if (transform == nullptr)
+    {
+        return;
+    }
+    id_buffer_.render(object, transform->model_view, transform->projection, transform->viewport, frame.window_width, frame.window_height);
+    id_buffer_.requestPixel(static_cast<int>(frame.cursor_x), static_cast<int>(frame.window_height - frame.cursor_y));
 }
 
-std::tuple<double, double> DrawingLib::convertCoordinates(double x, double y)
-/** Converts screen coordinates to world coordinates based on the camera view parameters and orthographic coefficient. */
+void DrawingLib::drawSelection(const Object& object) const
+/** Draws the selected shape highlighted. Expects the modelview matrix the Object was drawn with. */
 {
-    auto orth_c = Config::getParameters().ortho_coefficient_;
-    if (x > window_width_/2)
+    if (selected_shape_ != IdBuffer::kNoShape)
     {
-        x = x- window_width_/2;
+        object.drawShapeHighlight(selected_shape_);
     }
-    if (y > window_height_/2)
+}
+
+void DrawingLib::drawPickMarker() const
+/** Draws the last picked point on top of the Object. Expects the modelview matrix the Object was drawn with. */
+{
+    if (!last_pick_.hit)
     {
-        y = y- window_height_/2;
+        return;
     }
 
+    glDisable(GL_DEPTH_TEST);
+    glColor3f(1, 0, 1);
+    glPointSize(7.0f);
+    glBegin(GL_POINTS);
+    glVertex3f(last_pick_.point.x, last_pick_.point.y, last_pick_.point.z);
+    glEnd();
+    glEnable(GL_DEPTH_TEST);
+}
+
+std::tuple<double, double> DrawingLib::convertCoordinates(FrameSnapshot& frame, double x, double y, const ViewportRect& rect)
+/** Converts screen coordinates inside a viewport to world coordinates based on the camera view parameters and
+orthographic coefficient. */
+{
+    auto orth_c = frame.parameters().ortho_coefficient_ * frame.engineering.orthoScale();
+    // Screen coordinates start at the top-left corner of the window, viewports at the bottom-left one.
+    double top = frame.window_height - (rect.y + rect.height);
+
     double a,b,p,q;
-    p = 2*x / window_width_;
-    q = 2*y / window_height_;
+    p = (x - rect.x) / rect.width;
+    q = (y - top) / rect.height;
 
-    a = (1-p)*engineering_camera_.getCameraViewParams().left * orth_c +p*engineering_camera_.getCameraViewParams().right * orth_c;
-    b = (1-q)*(engineering_camera_.getCameraViewParams().top* orth_c * dim_ratio_) + q*(engineering_camera_.getCameraViewParams().bottom* orth_c * dim_ratio_);
+    auto const& view_params = frame.engineering.getCameraViewParams();
+    float dim_ratio = rect.dimRatio();
+    a = (1-p)*view_params.left * orth_c +p*view_params.right * orth_c;
+    b = (1-q)*(view_params.top* orth_c * dim_ratio) + q*(view_params.bottom* orth_c * dim_ratio);
 
     return std::make_tuple(a , b);
 }
@@ -555,6 +973,73 @@ std::string DrawingLib::OrthViewToString(DomeCameraRotate view)
     }
 }
 
+float DrawingLib::modelScale(const Object& object, const Parameters& parameters) const
+/** Returns the scale the scene is drawn with: 1 in world units, otherwise the scale that gives the primary Object
+the reference size. */
+{
+    return parameters.world_units_ ? 1.0f : object.calculateScalingFactor(reference_size_);
+}
+
+void DrawingLib::frameSphere(const BoundingSphere& sphere, float model_scale)
+/** Fits the current camera, the engineering camera and the cameras of further Free views to a sphere given in the
+coordinates of the primary Object. */
+{
+    if (sphere.empty())
+    {
+        return;
+    }
+    float dim_ratio = static_cast<float>(window_height_) / static_cast<float>(window_width_);
+    glm::vec3 center = sphere.center * model_scale;
+    float radius = sphere.radius * model_scale;
+    current_camera_->fitSphere(center, radius, dim_ratio);
+    engineering_camera_.fitSphere(center, radius, dim_ratio);
+    for (auto& camera : free_cameras_)
+    {
+        camera.fitSphere(center, radius, dim_ratio);
+    }
+    camera_controller_.reset();
+}
+
+void DrawingLib::frameAll(const Scene& scene)
+/** Moves the cameras so the primary Object and all instances fill the view. */
+{
+    const Object& object = scene.primary();
+    frameSphere(scene.boundingSphere(), modelScale(object, Config::getParameters()));
+}
+
+void DrawingLib::frameSelection(const Scene& scene)
+/** Moves the cameras so the selected shape fills the view, or frames everything if no shape is selected. */
+{
+    const Object& object = scene.primary();
+    if (selected_shape_ == IdBuffer::kNoShape || selection_version_ != object.version())
+    {
+        frameAll(scene);
+        return;
+    }
+    BoundingSphere sphere = object.shapeBoundingSphere(selected_shape_).transformed(object.rotation(), 1.0f);
+    frameSphere(sphere, modelScale(object, Config::getParameters()));
+}
+
+ViewportLayout DrawingLib::layoutOf(const Parameters& parameters)
+/** Returns the layout selected in Config. Without engineering view the current camera fills the window. */
+{
+    if (!parameters.engineering_view_)
+    {
+        return ViewportLayout(kSingleLayout);
+    }
+    if (parameters.viewport_layout_ == kCustomLayout)
+    {
+        return ViewportLayout(ViewportLayout::customViewports(parameters.custom_split_, parameters.custom_views_));
+    }
+    return ViewportLayout(static_cast<ViewportLayoutType>(parameters.viewport_layout_));
+}
+
+ViewCamera& DrawingLib::freeCamera(int index)
+/** Returns the camera of a Free view of the layout (see Viewport::camera). */
+{
+    return index > 0 && static_cast<size_t>(index) <= free_cameras_.size() ? free_cameras_[index - 1] : *current_camera_;
+}
+
 void DrawingLib::reset()
 /** Resets Camera settings to its initial values.*/
 {
@@ -563,4 +1048,10 @@ void DrawingLib::reset()
 
     engineering_camera_.resetCamera();
     engineering_camera_.resetView();
+    for (auto& camera : free_cameras_)
+    {
+        camera.resetCamera();
+        camera.resetView();
+    }
+    camera_controller_.reset();
 }
@@ -0,0 +1,80 @@
+#include "../include/edge_table.h"
+#include "../include/memory_stats.h"
+#include "../include/parallel.h"
+
+void EdgeTable::build(const unsigned int* indices, size_t index_count, const CancellationToken& token)
+/** Creates an edge record for each side of each triangle and sorts records by key; triangles sharing an edge
+are ordered by triangle index. If the token is cancelled before the sort, the table is left empty. */
+{
+    size_t triangle_count = index_count / 3;
+    records_.resize(triangle_count * 3);
+    parallelFor(triangle_count, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end && !token.isCancelled(); t++)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                records_[3 * t + corner] = {edgeKey(indices[3 * t + corner], indices[3 * t + (corner + 1) % 3]),
+                                            static_cast<uint32_t>(t)};
+            }
+        }
+    });
+    if (token.isCancelled())
+    {
+        clear();
+        return;
+    }
+    parallelSort(records_, [](const EdgeRecord& a, const EdgeRecord& b) {
+        return a.key < b.key || (a.key == b.key && a.triangle < b.triangle);
+    });
+}
+
+void EdgeTable::clear()
+{
+    records_.clear();
+    records_.shrink_to_fit();
+}
+
+size_t EdgeTable::runEnd(size_t begin) const
+/** Returns the end of the run of records with the same edge as the record at begin. */
+{
+    size_t end = begin + 1;
+    while (end < records_.size() && records_[end].key == records_[begin].key)
+    {
+        end++;
+    }
+    return end;
+}
+
+void EdgeTable::parallelForEdges(const std::function<void(size_t begin, size_t end)>& body) const
+/** Calls body for ranges of records on all workers. Range boundaries are moved to the start of a run,
+so every edge is processed by exactly one call. */
+{
+    size_t count = records_.size();
+    size_t chunks = std::max<size_t>(1, std::min(workerCount(), count / 65536));
+    std::vector<size_t> boundaries(chunks + 1, count);
+    boundaries[0] = 0;
+    for (size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t boundary = std::max(boundaries[chunk - 1], count * chunk / chunks);
+        while (boundary > 0 && boundary < count && records_[boundary].key == records_[boundary - 1].key)
+        {
+            boundary++;
+        }
+        boundaries[chunk] = boundary;
+    }
+
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            if (boundaries[chunk] < boundaries[chunk + 1])
+            {
+                body(boundaries[chunk], boundaries[chunk + 1]);
+            }
+        }
+    }, 1);
+}
+
+size_t EdgeTable::memoryBytes() const
+{
+    return vectorBytes(records_);
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include "../include/feature_edges.h"
+#include "../include/edge_table.h"
+#include "../include/memory_stats.h"
+#include "../include/parallel.h"
+
+namespace
+{
+    void appendLines(std::mutex& mutex, std::vector<uint32_t>& line_indices, const std::vector<uint32_t>& lines)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        line_indices.insert(line_indices.end(), lines.begin(), lines.end());
+    }
+}
+
+void FeatureEdges::build(const std::vector<float>& vertices, const std::vector<unsigned int>& indices)
+/** Computes face normals and centers, sorts triangle edges in an EdgeTable and turns each run of equal keys into one edge.
+Runs are converted on all workers; the resulting chunks are concatenated in key order. */
+{
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    size_t triangle_count = indices.size() / 3;
+
+    face_normals_.resize(triangle_count);
+    face_centers_.resize(triangle_count);
+    parallelFor(triangle_count, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            glm::vec3 corners[3];
+            for (int corner = 0; corner < 3; corner++)
+            {
+                const float* vertex = vertices.data() + 3 * size_t(indices[3 * t + corner]);
+                corners[corner] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+            }
+            glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+            float length = glm::length(normal);
+            face_normals_[t] = length > 0 ? normal / length : glm::vec3(0.0f);
+            face_centers_[t] = (corners[0] + corners[1] + corners[2]) / 3.0f;
+        }
+    });
+
+    EdgeTable edge_table;
+    edge_table.build(indices);
+    auto const& records = edge_table.records();
+
+    std::mutex mutex;
+    std::vector<std::pair<size_t, std::vector<Edge>>> chunks;
+    edge_table.parallelForEdges([&](size_t begin, size_t end) {
+        std::vector<Edge> chunk_edges;
+        for (size_t i = begin; i < end;)
+        {
+            size_t run_end = edge_table.runEnd(i);
+            Edge edge;
+            edge.vertices[0] = EdgeTable::firstVertex(records[i].key);
+            edge.vertices[1] = EdgeTable::secondVertex(records[i].key);
+            edge.triangles[0] = records[i].triangle;
+            edge.triangles[1] = run_end - i > 1 ? records[i + 1].triangle : records[i].triangle;
+            edge.triangle_count = static_cast<uint32_t>(run_end - i);
+            chunk_edges.push_back(edge);
+            i = run_end;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.emplace_back(begin, std::move(chunk_edges));
+    });
+
+    std::sort(chunks.begin(), chunks.end(), [](const std::pair<size_t, std::vector<Edge>>& a, const std::pair<size_t, std::vector<Edge>>& b) {
+        return a.first < b.first;
+    });
+    size_t edge_count = 0;
+    for (auto const& chunk : chunks)
+    {
+        edge_count += chunk.second.size();
+    }
+    edges_.reserve(edge_count);
+    for (auto const& chunk : chunks)
+    {
+        edges_.insert(edges_.end(), chunk.second.begin(), chunk.second.end());
+    }
+    build_time_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FeatureEdges::clear()
+{
+    edges_.clear();
+    edges_.shrink_to_fit();
+    face_normals_.clear();
+    face_normals_.shrink_to_fit();
+    face_centers_.clear();
+    face_centers_.shrink_to_fit();
+    front_facing_.clear();
+    front_facing_.shrink_to_fit();
+    classes_.clear();
+    classes_.shrink_to_fit();
+    std::fill(class_counts_, class_counts_ + 4, 0);
+    crease_angle_ = -1;
+}
+
+void FeatureEdges::classify(float crease_angle)
+/** Assigns an EdgeClass to every edge on all workers and counts edges of each class. */
+{
+    float cos_threshold = std::cos(glm::radians(crease_angle));
+    classes_.resize(edges_.size());
+    std::mutex mutex;
+    std::fill(class_counts_, class_counts_ + 4, 0);
+    parallelFor(edges_.size(), [&](size_t begin, size_t end) {
+        size_t counts[4] = {0, 0, 0, 0};
+        for (size_t e = begin; e < end; e++)
+        {
+            const Edge& edge = edges_[e];
+            int bit;
+            if (edge.triangle_count == 1)
+            {
+                bit = 0;
+            }
+            else if (edge.triangle_count > 2)
+            {
+                bit = 3;
+            }
+            else
+            {
+                float cos_angle = glm::dot(face_normals_[edge.triangles[0]], face_normals_[edge.triangles[1]]);
+                bit = cos_angle < cos_threshold ? 1 : 2;
+            }
+            classes_[e] = static_cast<uint8_t>(1 << bit);
+            counts[bit]++;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int bit = 0; bit < 4; bit++)
+        {
+            class_counts_[bit] += counts[bit];
+        }
+    });
+    crease_angle_ = crease_angle;
+}
+
+size_t FeatureEdges::classCount(EdgeClass edge_class) const
+{
+    for (int bit = 0; bit < 4; bit++)
+    {
+        if (edge_class == 1 << bit)
+        {
+            return class_counts_[bit];
+        }
+    }
+    return 0;
+}
+
+void FeatureEdges::lineIndices(uint8_t class_mask, std::vector<uint32_t>& line_indices) const
+/** Appends pairs of vertex indices of edges whose class is in class_mask. Expects the edges to be classified.
+Chunks are collected in parallel and appended in order, so the result does not depend on thread timing. */
+{
+    size_t chunk_size = std::max<size_t>(65536, (edges_.size() + workerCount() - 1) / workerCount());
+    size_t chunks = (edges_.size() + chunk_size - 1) / chunk_size;
+    std::vector<std::vector<uint32_t>> chunk_lines(chunks);
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            for (size_t e = chunk * chunk_size; e < std::min(edges_.size(), (chunk + 1) * chunk_size); e++)
+            {
+                if (classes_[e] & class_mask)
+                {
+                    chunk_lines[chunk].push_back(edges_[e].vertices[0]);
+                    chunk_lines[chunk].push_back(edges_[e].vertices[1]);
+                }
+            }
+        }
+    }, 1);
+    for (auto const& lines : chunk_lines)
+    {
+        line_indices.insert(line_indices.end(), lines.begin(), lines.end());
+    }
+}
+
+void FeatureEdges::silhouetteEdges(const glm::vec3& eye, bool orthographic, std::vector<uint32_t>& line_indices) const
+/** Appends pairs of vertex indices of silhouette edges: manifold edges between a triangle facing the viewer and one
+facing away. For an orthographic view eye is the viewing direction, otherwise the camera position, both in object
+coordinates. Facing of each triangle is computed once before the edges are checked. */
+{
+    front_facing_.resize(face_normals_.size());
+    parallelFor(face_normals_.size(), [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++)
+        {
+            glm::vec3 to_eye = orthographic ? -eye : eye - face_centers_[t];
+            front_facing_[t] = glm::dot(face_normals_[t], to_eye) > 0 ? 1 : 0;
+        }
+    });
+
+    std::mutex mutex;
+    parallelFor(edges_.size(), [&](size_t begin, size_t end) {
+        std::vector<uint32_t> lines;
+        for (size_t e = begin; e < end; e++)
+        {
+            const Edge& edge = edges_[e];
+            if (edge.triangle_count == 2 && front_facing_[edge.triangles[0]] != front_facing_[edge.triangles[1]])
+            {
+                lines.push_back(edge.vertices[0]);
+                lines.push_back(edge.vertices[1]);
+            }
+        }
+        appendLines(mutex, line_indices, lines);
+    });
+}
+
+size_t FeatureEdges::memoryBytes() const
+{
+    return vectorBytes(edges_) + vectorBytes(face_normals_) + vectorBytes(face_centers_) + vectorBytes(front_facing_)
+           + vectorBytes(classes_);
+}
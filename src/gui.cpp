@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cfloat>
 #include <iostream>
 #include <ctime>
 #include <fstream>
@@ -20,11 +22,11 @@ If corresponding booleans are true, saves image of the screen in the selected fo
     {
         if (ImGui::BeginMenu("File"))
         {
-            addMenuItem("Open", "OpenFile", dummy_bool_, [this](){openFile();});
-            addMenuItem("Save image", "SaveImage", save_image_);
-            addMenuItem("Hide / Show panel", "Animate", animate_);
-            addMenuItem("Help", "Help", help_window_);
-            addMenuItem("Exit", "Exit", dummy_bool_, [this](){exitConfirmMessage();});
+            addMenuItem("Open", kOpenFileShortcut, dummy_bool_, [this](){openFile();});
+            addMenuItem("Save image", kSaveImageShortcut, save_image_);
+            addMenuItem("Hide / Show panel", kAnimateShortcut, animate_);
+            addMenuItem("Help", kHelpShortcut, help_window_);
+            addMenuItem("Exit", kExitShortcut, dummy_bool_, [this](){exitConfirmMessage();});
             ImGui::EndMenu();
         }
         ImGui::EndMainMenuBar();
@@ -37,7 +39,7 @@ If corresponding booleans are true, saves image of the screen in the selected fo
     }
 }
 
-void GuiWindow::addMenuItem(const std::string &item, const std::string &shortcut, bool &bool_to_update,  const std::function<void()>& func)
+void GuiWindow::addMenuItem(const std::string &item, ShortcutAction shortcut, bool &bool_to_update,  const std::function<void()>& func)
 /** Creates a Main menu item with shortcut. If boolean is provided, switches it to true.
 If function object is provided, calls it.*/
 {
@@ -58,7 +60,8 @@ void GuiWindow::drawMainPanel(DrawingLib &drawing_lib)
 /** Draws Settings window with x_position = 0 (the most left) and y_position calculated at the center of left side.
 Whenever animation is called via Main menu or short-cut (Ctrl+A), Settings is moved out/in. */
 {
-    auto& gui_params = Config::getParameters();
+    reportLoadError();
+    auto& gui_params = Config::editParameters();
 
     ImGuiViewport* viewport = ImGui::GetMainViewport();
     float menu_bar_height = ImGui::GetFrameHeight();
@@ -100,13 +103,15 @@ Whenever animation is called via Main menu or short-cut (Ctrl+A), Settings is mo
     ImGui::Text("%s", drawing_lib.getCameraMetadata().c_str());
     ImGui::Spacing();
 
-    std::string camera_button = (drawing_lib.getCameraMetadata().find("Dome")!= std::string::npos) ? "FP camera" : "Dome camera";
+    // The button switches to the next camera of the cycle First person -> Dome -> Arcball.
+    CameraMode camera_mode = drawing_lib.cameraMode();
+    std::string camera_button = camera_mode == kFirstPerson ? "Dome camera" : (camera_mode == kDome ? "Arcball camera" : "FP camera");
     if (ImGui::Button(camera_button.c_str(), button_size_))
     {
         drawing_lib.switchPerspectiveCameraMode();
     }
 
-    if (camera_button == "FP camera")
+    if (camera_mode != kFirstPerson)
     {
         ImGui::SameLine();
         std::string view_button = (drawing_lib.getCameraMetadata().find("Orthogonal")!= std::string::npos) ? "Perspective" : "Orthogonal";
@@ -115,6 +120,38 @@ Whenever animation is called via Main menu or short-cut (Ctrl+A), Settings is mo
             drawing_lib.switchCameraView();
         }
     }
+    if (camera_mode == kDome)
+    {
+        // The Dome camera turns to the position of an orthographic view with a short animation.
+        ImVec2 preset_button_size = ImVec2(button_size_.x * 2 / 3 - 4, 0);
+        if (ImGui::Button("Front", preset_button_size)) {drawing_lib.turnToPreset(kFront);}
+        ImGui::SameLine();
+        if (ImGui::Button("Side", preset_button_size)) {drawing_lib.turnToPreset(kSide);}
+        ImGui::SameLine();
+        if (ImGui::Button("Top", preset_button_size)) {drawing_lib.turnToPreset(kTop);}
+    }
+    ImGui::Checkbox(" smooth camera", &gui_params.smooth_camera_);
+
+    // Framing moves the camera to the bounding sphere and fits the near and far planes to it.
+    if (ImGui::Button("Frame all", button_size_))
+    {
+        drawing_lib.frameAll(scene_);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Frame selection", button_size_))
+    {
+        drawing_lib.frameSelection(scene_);
+    }
+    // The scene changes its size by the model's scaling factor, so it is framed again.
+    if (ImGui::Checkbox(" world units", &gui_params.world_units_))
+    {
+        drawing_lib.frameAll(scene_);
+    }
+    ImGui::Checkbox(" adaptive depth", &gui_params.adaptive_depth_);
+    if (SceneFramebuffer::supported())
+    {
+        ImGui::Checkbox(" reversed depth", &gui_params.reversed_depth_);
+    }
 
     ImGui::Spacing();
     std::string viewport_button = (Config::getParameters().engineering_view_) ? "Regular view" : "Engineering view";
@@ -122,6 +159,32 @@ Whenever animation is called via Main menu or short-cut (Ctrl+A), Settings is mo
     {
         Config::switchEngineeringView();
     }
+    if (Config::getParameters().engineering_view_)
+    {
+        const char* layouts[kViewportLayoutCount];
+        for (int type = 0; type < kViewportLayoutCount; type++)
+        {
+            layouts[type] = ViewportLayout::name(static_cast<ViewportLayoutType>(type));
+        }
+        ImGui::Combo("##viewport layout", &gui_params.viewport_layout_, layouts, kViewportLayoutCount);
+        if (gui_params.viewport_layout_ == kCustomLayout)
+        {
+            ImGui::SliderFloat("##custom split", &gui_params.custom_split_, 0.1f, 0.9f, "main view = %.2f");
+            // Items follow DomeCameraRotate; the column slots start with an empty entry for kNoView.
+            const char* views[] = {"Front", "Side", "Top", "Free"};
+            const char* slots[] = {"None", "Front", "Side", "Top", "Free"};
+            ImGui::Combo("main view", &gui_params.custom_views_[0], views, 4);
+            for (size_t slot = 1; slot < gui_params.custom_views_.size(); slot++)
+            {
+                int item = gui_params.custom_views_[slot] + 1;
+                std::string label = "view " + std::to_string(slot);
+                if (ImGui::Combo(label.c_str(), &item, slots, 5))
+                {
+                    gui_params.custom_views_[slot] = item - 1;
+                }
+            }
+        }
+    }
 
     ImGui::Spacing();
     if (ImGui::Button("Reset camera", button_size_))
@@ -152,29 +215,610 @@ Whenever animation is called via Main menu or short-cut (Ctrl+A), Settings is mo
     if (ImGui::ArrowButton("##right", ImGuiDir_Right))
     { object_.rotateObjects(axis_, -1);}
 
+    if (ImGui::Checkbox(" quantized positions", &gui_params.quantize_positions_))
+    {
+        render_thread_.post([this](){object_.uploadVertexBuffer();});
+    }
+    frame_time_ms_[gui_params.quantize_positions_ ? 1 : 0] = 1000.0f / ImGui::GetIO().Framerate;
+    ImGui::Checkbox(" surface measurement", &gui_params.measure_mode_);
+    ImGui::Checkbox(" solid shading", &gui_params.solid_shading_);
+    ImGui::Checkbox(" hidden lines", &gui_params.hidden_line_);
+    ImGui::Checkbox(" meshlet culling", &gui_params.meshlet_culling_);
+    if (gui_params.meshlet_culling_)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox(" back-facing", &gui_params.meshlet_cone_culling_);
+        ImGui::Text("%zu meshlets, built in %.1f ms (%s)", object_.meshlets().size(), object_.meshlets().buildTimeMs(),
+                    Meshlets::simd() ? "SSE" : "scalar");
+        for (auto const& report : object_.meshletReports())
+        {
+            auto const& stats = report.stats;
+            float total = static_cast<float>(std::max<size_t>(stats.meshlets, 1));
+            ImGui::Text("Viewport %d,%d: %.0f%% frustum, %.0f%% back-facing, %zu calls, %.0f us", report.viewport[0],
+                        report.viewport[1], 100.0f * stats.frustum_rejected / total, 100.0f * stats.backface_rejected / total,
+                        report.draw_calls, stats.time_us);
+        }
+    }
+    if (!gui_params.solid_shading_)
+    {
+        ImGui::Text("Edges: ");
+        ImGui::CheckboxFlags(" boundary", &gui_params.edge_classes_, kBoundaryEdge); ImGui::SameLine();
+        ImGui::CheckboxFlags(" crease", &gui_params.edge_classes_, kCreaseEdge);
+        ImGui::CheckboxFlags(" smooth", &gui_params.edge_classes_, kSmoothEdge); ImGui::SameLine();
+        ImGui::CheckboxFlags(" non-manifold", &gui_params.edge_classes_, kNonManifoldEdge);
+        ImGui::SliderFloat("##crease angle", &gui_params.crease_angle_, 1.0f, 90.0f, "crease angle = %.0f");
+
+        auto const& feature_edges = object_.featureEdges();
+        ImGui::Text("%zu boundary, %zu crease, %zu smooth, %zu non-manifold", feature_edges.classCount(kBoundaryEdge),
+                    feature_edges.classCount(kCreaseEdge), feature_edges.classCount(kSmoothEdge),
+                    feature_edges.classCount(kNonManifoldEdge));
+        auto edge_lines = object_.edgeLineReport();
+        ImGui::Text("Lines: %zu edge + %zu silhouette", edge_lines.edge_lines, edge_lines.silhouette_lines);
+        ImGui::Text("Triangle edges: %zu", edge_lines.triangle_edges);
+    }
+
+    ImGui::Spacing();
+    ImGui::SeparatorText("Section");
+    ImGui::Checkbox(" section in engineering view", &gui_params.section_);
+    if (ImGui::Button("X")) { gui_params.section_azimuth_ = 90; gui_params.section_elevation_ = 0; }
+    ImGui::SameLine();
+    if (ImGui::Button("Y")) { gui_params.section_azimuth_ = 0; gui_params.section_elevation_ = 90; }
+    ImGui::SameLine();
+    if (ImGui::Button("Z")) { gui_params.section_azimuth_ = 0; gui_params.section_elevation_ = 0; }
+    ImGui::SliderFloat("##section azimuth", &gui_params.section_azimuth_, -180.0f, 180.0f, "azimuth = %.0f");
+    ImGui::SliderFloat("##section elevation", &gui_params.section_elevation_, -90.0f, 90.0f, "elevation = %.0f");
+    ImGui::SliderFloat("##section position", &gui_params.section_position_, 0.0f, 1.0f, "position = %.3f");
+    if (gui_params.section_)
+    {
+        auto const& section_statistics = drawing_lib.sectionSlicer().statistics();
+        ImGui::Text("Contours: %zu (%zu open)", drawing_lib.sectionSlicer().contours().size(), section_statistics.open_contours);
+        ImGui::Text("Triangles tested: %zu of %zu", section_statistics.tested_triangles, object_.indices().size() / 3);
+        ImGui::Text("Slice: %.1f us", section_statistics.time_us);
+    }
+
     ImGui::Spacing();
     ImGui::SeparatorText("Shortcuts");
     if (ImGui::TreeNode("General"))
     {
-        shortcutInput("Open file: CTRL + ", "OpenFile");
-        shortcutInput("Save image: CTRL + ", "SaveImage");
-        shortcutInput("Hide/Show panel: CTRL + ", "Animate");
-        shortcutInput("Help: CTRL + ", "Help");
-        shortcutInput("Exit: CTRL + ", "Exit");
+        shortcutInput("Open file: CTRL + ", kOpenFileShortcut);
+        shortcutInput("Save image: CTRL + ", kSaveImageShortcut);
+        shortcutInput("Hide/Show panel: CTRL + ", kAnimateShortcut);
+        shortcutInput("Help: CTRL + ", kHelpShortcut);
+        shortcutInput("Exit: CTRL + ", kExitShortcut);
         ImGui::TreePop();
     }
     if (ImGui::TreeNode("Camera"))
     {
-        shortcutInput("Switch camera mode: ", "SwitchCameraMode");
-        shortcutInput("Switch camera view: ", "SwitchCameraView");
-        shortcutInput("Grid: ", "EnableGrid");
-        shortcutInput("Engineering view: ", "SwitchEngineeringView");
+        shortcutInput("Switch camera mode: ", kSwitchCameraModeShortcut);
+        shortcutInput("Switch camera view: ", kSwitchCameraViewShortcut);
+        shortcutInput("Grid: ", kEnableGridShortcut);
+        shortcutInput("Engineering view: ", kSwitchEngineeringViewShortcut);
+
+        ImGui::TreePop();
+    }
+
+    if (replay_in_progress_ && !drawing_lib.inputRecorder().isReplaying())
+    {
+        finishInputReplay(drawing_lib.inputRecorder());
+    }
 
+    ImGui::Spacing();
+    ImGui::SeparatorText("Diagnostics");
+    if (ImGui::TreeNode("Input recording"))
+    {
+        drawInputRecordingPanel(drawing_lib);
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Cursor events"))
+    {
+        drawCursorEventsPanel(drawing_lib);
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Depth range"))
+    {
+        drawDepthRangePanel(drawing_lib);
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Render thread"))
+    {
+        drawRenderThreadPanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Tasks"))
+    {
+        drawTasksPanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Memory"))
+    {
+        drawMemoryPanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Mesh analysis"))
+    {
+        drawMeshAnalysisPanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Scene"))
+    {
+        drawScenePanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Streaming"))
+    {
+        drawStreamingPanel();
+        ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Picking"))
+    {
+        drawPickingPanel(drawing_lib);
         ImGui::TreePop();
     }
     ImGui::End();
 }
 
+void GuiWindow::drawInputRecordingPanel(DrawingLib &drawing_lib)
+/** Draws controls to record mouse and keyboard input into a binary log and to replay a saved log,
+either at the recorded speed or as fast as possible. Shows frame timings of the last replay. */
+{
+    auto& recorder = drawing_lib.inputRecorder();
+
+    if (recorder.isRecording())
+    {
+        ImGui::Text("Recording: %zu events", recorder.eventCount());
+        if (ImGui::Button("Stop recording", button_size_))
+        {
+            recorder.stopRecording();
+            saveInputLog(recorder);
+        }
+    }
+    else if (recorder.isReplaying())
+    {
+        ImGui::Text("Replaying: %zu frames", recorder.frameTimings().size());
+        if (ImGui::Button("Stop replay", button_size_))
+        {
+            recorder.stopReplay();
+        }
+    }
+    else
+    {
+        if (ImGui::Button("Record", button_size_))
+        {
+            drawing_lib.startInputRecording();
+        }
+        ImGui::RadioButton("recorded speed", &replay_speed_, kRecordedSpeed);
+        ImGui::RadioButton("as fast as possible", &replay_speed_, kAsFastAsPossible);
+        if (ImGui::Button("Replay", button_size_))
+        {
+            openInputLog(drawing_lib);
+        }
+    }
+
+    if (last_replay_report_.frames > 0)
+    {
+        ImGui::Text("Last replay: %zu frames", last_replay_report_.frames);
+        ImGui::Text("avg %.2f ms, median %.2f ms", last_replay_report_.average_ms, last_replay_report_.median_ms);
+        ImGui::Text("p95 %.2f ms, max %.2f ms", last_replay_report_.p95_ms, last_replay_report_.max_ms);
+    }
+}
+
+void GuiWindow::drawCursorEventsPanel(DrawingLib &drawing_lib)
+/** Prints how many cursor events of camera drags were coalesced into one camera update per frame, and compares CPU time
+of rotating the cameras per event and per frame in a simulated fast drag. */
+{
+    auto const& statistics = drawing_lib.cameraController().statistics();
+    ImGui::Text("Drag events: %zu, camera updates: %zu", statistics.cursor_events, statistics.camera_updates);
+    ImGui::Text("Coalesced: %zu (last frame %zu, max %zu per frame)", statistics.coalesced(), statistics.last_frame_events,
+                statistics.max_frame_events);
+
+    if (ImGui::Button("Benchmark", button_size_))
+    {
+        coalescing_benchmark_ = drawing_lib.benchmarkCursorCoalescing();
+        std::cout << "Cursor coalescing benchmark: " << coalescing_benchmark_.frames << " frames x "
+                  << coalescing_benchmark_.events_per_frame << " events, per event " << coalescing_benchmark_.per_event_ms
+                  << " ms, per frame " << coalescing_benchmark_.per_frame_ms << " ms" << std::endl;
+    }
+    if (coalescing_benchmark_.frames > 0)
+    {
+        ImGui::Text("%zu frames x %zu events:", coalescing_benchmark_.frames, coalescing_benchmark_.events_per_frame);
+        ImGui::Text("Per event: %.3f ms, per frame: %.3f ms", coalescing_benchmark_.per_event_ms, coalescing_benchmark_.per_frame_ms);
+    }
+}
+
+void GuiWindow::drawDepthRangePanel(DrawingLib &drawing_lib) const
+/** Prints the near and far planes of each viewport of the last frame, their ratio, and how many of the scene's boxes
+were in view when they were fitted. */
+{
+    ImGui::Text("Depth buffer: %s", drawing_lib.reversedDepth() ? "reversed, 32-bit float" : "standard");
+    for (size_t i = 0; i < drawing_lib.depthRanges().size(); i++)
+    {
+        auto const& range = drawing_lib.depthRanges()[i];
+        ImGui::Text("Viewport %zu: near %.4g, far %.4g (far / near %.3g)", i, range.near, range.far,
+                    range.near > 0 ? range.far / range.near : 0.0);
+        if (range.boxes > 0)
+        {
+            ImGui::Text("  boxes in view: %zu of %zu", range.visible, range.boxes);
+        }
+    }
+}
+
+void GuiWindow::drawRenderThreadPanel() const
+/** Prints how long the render thread took to draw and swap the last frame and how long the main thread waited for it. */
+{
+    auto stats = render_thread_.statistics();
+    ImGui::Text("Frames: %zu", stats.frames);
+    ImGui::Text("Draw: %.2f ms, swap: %.2f ms", stats.draw_ms, stats.swap_ms);
+    ImGui::Text("Main thread waited: %.2f ms", stats.wait_ms);
+}
+
+void GuiWindow::drawTasksPanel()
+/** Prints the number of workers of the TaskScheduler and, per task name, how many tasks ran or were cancelled,
+their average and longest run time and their average time in the queue. */
+{
+    ImGui::Text("Workers: %zu", TaskScheduler::instance().threadCount());
+    if (scene_.isLoading())
+    {
+        ImGui::Text("Loading a file...");
+    }
+    auto entries = task_profiler_.entries();
+    if (!entries.empty() && ImGui::BeginTable("tasks", 5))
+    {
+        ImGui::TableSetupColumn("Task");
+        ImGui::TableSetupColumn("Runs");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("Queued");
+        ImGui::TableHeadersRow();
+        for (auto const& entry : entries)
+        {
+            size_t runs = entry.second.count - entry.second.cancelled;
+            ImGui::TableNextColumn(); ImGui::Text("%s", entry.first.c_str());
+            ImGui::TableNextColumn(); ImGui::Text("%zu (%zu cancelled)", runs, entry.second.cancelled);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f ms", runs > 0 ? entry.second.total_run_ms / static_cast<double>(runs) : 0.0);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f ms", entry.second.max_run_ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f ms", entry.second.total_queued_ms / static_cast<double>(entry.second.count));
+        }
+        ImGui::EndTable();
+    }
+    if (ImGui::Button("Reset", button_size_))
+    {
+        task_profiler_.clear();
+    }
+}
+
+void GuiWindow::drawMemoryPanel() const
+/** Prints memory used by the loaded object and the number of active ImGui allocations, compares memory and frame time
+of float and quantized vertex positions. Updated every frame.*/
+{
+    MemoryStats stats = object_.memoryStats();
+
+    ImGui::Text("Vertices: %s", formatBytes(stats.vertex_bytes).c_str());
+    ImGui::Text("Indices: %s", formatBytes(stats.index_bytes).c_str());
+    ImGui::Text("Normals: %s", formatBytes(stats.normal_bytes).c_str());
+    ImGui::Text("Caches: %s", formatBytes(stats.cache_bytes).c_str());
+    ImGui::Text("CPU total: %s", formatBytes(stats.cpuBytes()).c_str());
+    ImGui::Text("GPU buffers: %s", formatBytes(stats.gpu_bytes).c_str());
+    ImGui::Text("Submitted per frame: %s", formatBytes(stats.submitted_bytes).c_str());
+    ImGui::Text("Peak of last load: %s", formatBytes(stats.peak_load_bytes).c_str());
+    ImGui::Text("ImGui allocations: %d", ImGui::GetIO().MetricsActiveAllocations);
+
+    Object::IndexPackingReport packing = object_.indexPackingReport();
+    if (packing.full_bytes > 0)
+    {
+        double saved = 100.0 * (1.0 - static_cast<double>(packing.packed_bytes) / static_cast<double>(packing.full_bytes));
+        ImGui::Spacing();
+        ImGui::Text("Draw batches: %zu x 16-bit, %zu x 32-bit", packing.short_batches, packing.int_batches);
+        ImGui::Text("Draw indices: %s of %s (-%.0f%%)", formatBytes(packing.packed_bytes).c_str(),
+                    formatBytes(packing.full_bytes).c_str(), saved);
+    }
+
+    // Frame time of a mode is the last one measured while that mode was on.
+    Object::QuantizationReport quantization = object_.quantizationReport();
+    ImGui::Spacing();
+    if (ImGui::BeginTable("##positions", 3, ImGuiTableFlags_Borders))
+    {
+        ImGui::TableSetupColumn("Positions");
+        ImGui::TableSetupColumn("float");
+        ImGui::TableSetupColumn("16-bit");
+        ImGui::TableHeadersRow();
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Memory");
+        ImGui::TableNextColumn(); ImGui::Text("%s", formatBytes(quantization.float_bytes).c_str());
+        ImGui::TableNextColumn(); ImGui::Text("%s", formatBytes(quantization.quantized_bytes).c_str());
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("Frame");
+        ImGui::TableNextColumn(); ImGui::Text("%.2f ms", frame_time_ms_[0]);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f ms", frame_time_ms_[1]);
+        ImGui::EndTable();
+    }
+    if (Config::getParameters().quantize_positions_)
+    {
+        ImGui::Text("Max error: %.2e model units", quantization.max_error);
+    }
+}
+
+void GuiWindow::drawPickingPanel(DrawingLib &drawing_lib)
+/** Prints the selected shape, the last picked surface point, the current measurement and statistics of the object's BVH. Runs the picking benchmark:
+BVH build time and ray queries per second on one thread and on all threads.*/
+{
+    ImGui::TextWrapped("Left click selects a shape, Ctrl + left click picks a point on the surface. With surface measurement on, "
+                       "right mouse drag measures between points snapped to vertices, edges or the surface.");
+
+    auto const& pick = drawing_lib.lastPick();
+    if (pick.hit)
+    {
+        ImGui::Text("Point: %.3f, %.3f, %.3f", pick.point.x, pick.point.y, pick.point.z);
+        ImGui::Text("Triangle: %u, query: %.1f us", pick.triangle, pick.time_us);
+    }
+
+    auto selected_shape = drawing_lib.selectedShape();
+    if (selected_shape != IdBuffer::kNoShape && selected_shape < object_.shapes().size())
+    {
+        auto const& shape = object_.shapes()[selected_shape];
+        ImGui::Spacing();
+        ImGui::Text("Shape %u: %s", selected_shape, shape.name.empty() ? "(unnamed)" : shape.name.c_str());
+        ImGui::Text("Triangles: %zu", shape.count / 3);
+    }
+    ImGui::Text("ID buffer: %zu renders, last %.2f ms", drawing_lib.idBuffer().renderCount(), drawing_lib.idBuffer().lastRenderMs());
+
+    auto const& measure_tool = drawing_lib.measureTool();
+    auto const& measurement = measure_tool.measurement();
+    if (Config::getParameters().measure_mode_ && measurement.start.kind != kSnapNone)
+    {
+        ImGui::Spacing();
+        ImGui::Text("Length: %.3f", measurement.length);
+        if (measurement.mesh_distance >= 0)
+        {
+            ImGui::Text("To mesh: %.3f", measurement.mesh_distance);
+        }
+        if (measurement.section >= 0)
+        {
+            ImGui::Text("Section: %.3f", measurement.section);
+        }
+        ImGui::Text("Snap query: %.1f us", measure_tool.queryTimeUs());
+    }
+
+    auto const& bvh = object_.bvh();
+    ImGui::Spacing();
+    ImGui::Text("BVH: %zu nodes, %s", bvh.nodeCount(), formatBytes(bvh.memoryBytes()).c_str());
+    ImGui::Text("Build: %.1f ms", bvh.buildTimeMs());
+
+    if (ImGui::Button("Run benchmark", button_size_))
+    {
+        picking_benchmark_ = object_.benchmarkPicking(1000000);
+        std::cout << "Picking benchmark: " << object_.bvh().triangleCount() << " triangles, build "
+                  << picking_benchmark_.build_ms << " ms, " << picking_benchmark_.rays << " rays, "
+                  << picking_benchmark_.single_thread_rays_per_second / 1e6 << " Mrays/s on one thread, "
+                  << picking_benchmark_.parallel_rays_per_second / 1e6 << " Mrays/s on all threads" << std::endl;
+    }
+    if (picking_benchmark_.rays > 0)
+    {
+        ImGui::Text("Build: %.1f ms", picking_benchmark_.build_ms);
+        ImGui::Text("1 thread: %.2f Mrays/s", picking_benchmark_.single_thread_rays_per_second / 1e6);
+        ImGui::Text("All threads: %.2f Mrays/s", picking_benchmark_.parallel_rays_per_second / 1e6);
+    }
+}
+
+void GuiWindow::drawStreamingPanel()
+/** Saves the loaded mesh as an octree file and opens octree files for streaming. Sets the screen-space error and
+the memory budget of streaming and prints statistics of resident and drawn nodes.*/
+{
+    auto& gui_params = Config::editParameters();
+
+    if (!object_.isStreaming() && !object_.indices().empty() && ImGui::Button("Save octree", button_size_))
+    {
+        auto filepath = pfd::save_file("Save octree", "object.octree", {"Octree files", "*.octree"}).result();
+        if (!filepath.empty() && !object_.saveStreamingFile(filepath))
+        {
+            pfd::message("Problem", "Error: Unable to save octree file '" + filepath + "'.",
+                         pfd::choice::ok, pfd::icon::error);
+        }
+        ImGui::SameLine();
+    }
+    if (ImGui::Button("Open octree", button_size_))
+    {
+        auto selection = pfd::open_file("Select an octree file", ".", {"Octree files", "*.octree"}).result();
+        if (!selection.empty())
+        {
+            std::string filepath = selection[0];
+            render_thread_.post([this, filepath](){object_.openStreamingFile(filepath);});
+        }
+    }
+
+    ImGui::SliderFloat("##streaming error", &gui_params.streaming_error_pixels_, 0.5f, 16.0f, "max error = %.1f px");
+    ImGui::SliderInt("##streaming budget", &gui_params.streaming_budget_mb_, 64, 4096, "budget = %d MB");
+    if (!object_.isStreaming())
+    {
+        return;
+    }
+    auto stats = object_.streamingOctree().statistics();
+    ImGui::Text("Nodes: %zu resident of %zu, %zu queued", stats.resident_nodes, stats.nodes, stats.queued_nodes);
+    ImGui::Text("Resident: %s of %s", formatBytes(stats.resident_bytes).c_str(), formatBytes(stats.budget_bytes).c_str());
+    ImGui::Text("Drawn: %zu nodes, %zu triangles", stats.drawn_nodes, stats.drawn_triangles);
+    ImGui::Text("Loaded: %zu nodes in %.0f ms, evicted: %zu", stats.loaded_nodes, stats.load_ms, stats.evicted_nodes);
+}
+
+void GuiWindow::drawScenePanel()
+/** Adds copies of the loaded Object or of other .obj files to the scene and edits the placement of each copy.
+Prints how many draw calls the copies took in the last frame.*/
+{
+    auto& gui_params = Config::editParameters();
+    ImGui::Checkbox("Instanced rendering", &gui_params.instanced_rendering_);
+
+    ImGui::SliderInt("##grid instances", &grid_instances_, 1, 1024, "copies = %d");
+    if (ImGui::Button("Add copies", button_size_))
+    {
+        scene_.addGrid(0, grid_instances_);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Add mesh", button_size_))
+    {
+        auto selection = pfd::open_file("Select a file", ".", { "Object Files", "*.obj"}).result();
+        if (!selection.empty())
+        {
+            std::string filepath = selection[0];
+            int count = grid_instances_;
+            render_thread_.post([this, filepath, count](){scene_.addMesh(filepath, count);});
+        }
+    }
+    if (scene_.instances().empty())
+    {
+        return;
+    }
+    if (ImGui::Button("Clear scene", button_size_))
+    {
+        render_thread_.post([this](){scene_.clearInstances();});
+        selected_instance_ = 0;
+        return;
+    }
+
+    auto last_instance = static_cast<int>(scene_.instances().size()) - 1;
+    selected_instance_ = std::min(selected_instance_, last_instance);
+    ImGui::SliderInt("##instance", &selected_instance_, 0, last_instance, "instance = %d");
+    Instance& instance = scene_.instance(static_cast<size_t>(selected_instance_));
+    ImGui::Text("Mesh: %zu", instance.mesh);
+    ImGui::DragFloat3("Position", &instance.position.x, 0.01f);
+    ImGui::DragFloat("Scale", &instance.scale, 0.01f, 0.01f, 100.0f);
+    ImGui::SliderInt3("Rotation", instance.rotation, -180, 180);
+    if (ImGui::Button("Remove", button_size_))
+    {
+        scene_.removeInstance(static_cast<size_t>(selected_instance_));
+    }
+
+    auto stats = scene_.statistics();
+    ImGui::Text("Meshes: %zu, instances: %zu", stats.meshes, stats.instances);
+    ImGui::Text("Draw calls: %zu (%s)", stats.draw_calls, stats.instanced ? "instanced" : "one per instance");
+}
+
+void GuiWindow::drawMeshAnalysisPanel()
+/** Prints the source of normals and runs the normal generation benchmark. Prints statistics and topology of the loaded
+mesh and plots triangle area and quality histograms. The analysis runs in the background after loading;
+until it finishes only its state is shown.*/
+{
+    auto normals = object_.normalsReport();
+    if (normals.from_file)
+    {
+        ImGui::Text("Normals: from file");
+    }
+    else
+    {
+        ImGui::Text("Normals: generated in %.1f ms", normals.generation_ms);
+    }
+    if (ImGui::Button("Benchmark normals", button_size_))
+    {
+        normals_benchmark_ = object_.benchmarkNormals();
+        std::cout << "Normals benchmark: " << object_.indices().size() / 3 << " triangles, serial "
+                  << normals_benchmark_.serial_ms << " ms, parallel " << normals_benchmark_.parallel_ms << " ms on "
+                  << normals_benchmark_.threads << " threads" << std::endl;
+    }
+    if (normals_benchmark_.threads > 0)
+    {
+        ImGui::Text("Serial: %.1f ms, parallel: %.1f ms (%zu threads)", normals_benchmark_.serial_ms,
+                    normals_benchmark_.parallel_ms, normals_benchmark_.threads);
+    }
+    ImGui::Spacing();
+
+    auto const& analyzer = object_.meshAnalyzer();
+    if (analyzer.isRunning())
+    {
+        ImGui::Text("Analyzing...");
+        return;
+    }
+    auto statistics = analyzer.statistics();
+    if (!statistics.valid)
+    {
+        ImGui::Text("No analysis");
+        return;
+    }
+
+    ImGui::Text("Triangles: %zu, vertices: %zu, shapes: %zu", statistics.triangles, statistics.vertices, statistics.shapes);
+    ImGui::Text("Surface area: %.4g", statistics.surface_area);
+    if (statistics.isClosed())
+    {
+        ImGui::Text("Volume: %.4g", statistics.volume);
+    }
+    else
+    {
+        ImGui::Text("Volume: %.4g (open mesh)", statistics.volume);
+    }
+    ImGui::Text("Degenerate triangles: %zu", statistics.degenerate_triangles);
+    ImGui::Text("Edges: %zu, boundary: %zu, non-manifold: %zu", statistics.edges, statistics.boundary_edges, statistics.non_manifold_edges);
+    ImGui::Text("Boundary components: %zu", statistics.boundary_components);
+
+    float area_bins[kHistogramBins], quality_bins[kHistogramBins];
+    for (int bin = 0; bin < kHistogramBins; bin++)
+    {
+        area_bins[bin] = static_cast<float>(statistics.area_histogram[bin]);
+        quality_bins[bin] = static_cast<float>(statistics.quality_histogram[bin]);
+    }
+    ImGui::PlotHistogram("##area", area_bins, kHistogramBins, 0, "area / mean, 2^-8 .. 2^8", 0.0f, FLT_MAX, ImVec2(0, 60));
+    ImGui::PlotHistogram("##quality", quality_bins, kHistogramBins, 0, "quality, 0 .. 1", 0.0f, FLT_MAX, ImVec2(0, 60));
+    ImGui::Text("Analysis: %.1f ms on %zu threads", statistics.analysis_ms, statistics.threads);
+}
+
+void GuiWindow::saveInputLog(InputRecorder &recorder)
+/** Opens a file dialog to select where recorded input is saved, notifies the user if the log cannot be written.*/
+{
+    auto filepath = pfd::save_file("Save input log", "input.irec", {"Input logs", "*.irec"}).result();
+    if (!filepath.empty() && !recorder.saveLog(filepath))
+    {
+        pfd::message("Problem", "Error: Unable to save input log '" + filepath + "'.",
+                     pfd::choice::ok, pfd::icon::error);
+    }
+}
+
+void GuiWindow::openInputLog(DrawingLib &drawing_lib)
+/** Opens a file dialog to select an input log, loads it and starts replay with the selected speed.*/
+{
+    auto selection = pfd::open_file("Select an input log", ".",
+                                    { "Input logs", "*.irec"}).result();
+    if (selection.empty())
+    {
+        return;
+    }
+    if (!drawing_lib.inputRecorder().loadLog(selection[0]))
+    {
+        pfd::message("Problem", "Error: Unable to load input log '" + selection[0] + "'.",
+                     pfd::choice::ok, pfd::icon::error);
+        return;
+    }
+    input_log_path_ = selection[0];
+    drawing_lib.startInputReplay(static_cast<ReplaySpeed>(replay_speed_));
+    replay_in_progress_ = true;
+}
+
+void GuiWindow::finishInputReplay(InputRecorder &recorder)
+/** Stores the report of the finished replay and saves frame timings next to the replayed log.*/
+{
+    replay_in_progress_ = false;
+    last_replay_report_ = recorder.replayReport();
+
+    std::string timings_path = input_log_path_ + ".timings.csv";
+    if (!recorder.saveFrameTimings(timings_path))
+    {
+        std::cerr << "Failed to save frame timings to " << timings_path << std::endl;
+        return;
+    }
+    std::cout << "Replay finished: " << last_replay_report_.frames << " frames, average "
+              << last_replay_report_.average_ms << " ms, p95 " << last_replay_report_.p95_ms
+              << " ms. Frame timings saved to " << timings_path << std::endl;
+
+    // Memory statistics are exported with timings, so results of different models can be compared.
+    std::string memory_path = input_log_path_ + ".memory.csv";
+    std::ofstream memory_file(memory_path);
+    if (memory_file.is_open())
+    {
+        object_.memoryStats().writeCsv(memory_file);
+        std::cout << "Memory statistics saved to " << memory_path << std::endl;
+    }
+    else
+    {
+        std::cerr << "Failed to save memory statistics to " << memory_path << std::endl;
+    }
+}
+
 int GuiWindow::inputTextToUpperCaseCallback(ImGuiInputTextCallbackData* data)
 /** Callback function that applies upper case to lower case chars.*/
 {
@@ -185,7 +829,7 @@ int GuiWindow::inputTextToUpperCaseCallback(ImGuiInputTextCallbackData* data)
     return 0;
 }
 
-void GuiWindow::shortcutInput(const std::string& text, const std::string& shortcut_key) const
+void GuiWindow::shortcutInput(const std::string& text, ShortcutAction action) const
 /** Creates a set of a string with short-cut name and input field to assign a char to a short-cut items.*/
 {
     ImVec2 startPos = ImGui::GetCursorPos();
@@ -194,12 +838,12 @@ void GuiWindow::shortcutInput(const std::string& text, const std::string& shortc
     ImGui::SetCursorPos(ImVec2(startPos.x + set_cursor_pos_x_, startPos.y));
 
     ImGui::PushItemWidth(25);
-    char Shortcut[2] = { Config::getShortcut(shortcut_key), '\0' };
+    char Shortcut[2] = { Config::getShortcut(action), '\0' };
 
-    std::string label = "##"+ shortcut_key;
+    std::string label = "##shortcut "+ std::to_string(action);
     if (ImGui::InputText(label.c_str(), Shortcut, IM_ARRAYSIZE(Shortcut), ImGuiInputTextFlags_CallbackCharFilter, inputTextToUpperCaseCallback))
     {
-        Config::getShortcut(shortcut_key) = Shortcut[0];
+        Config::setShortcut(action, Shortcut[0]);
     }
     ImGui::PopItemWidth();
 }
@@ -209,23 +853,23 @@ void GuiWindow::handleShortcuts(std::tuple<int, int> window_parameters)
 {
     ImGuiIO& io = ImGui::GetIO();
 
-    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut("Animate"))))
+    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut(kAnimateShortcut))))
     {
         animate_ = true;
     }
-    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut("OpenFile"))))
+    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut(kOpenFileShortcut))))
     {
         openFile();
     }
-    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut("Help"))))
+    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut(kHelpShortcut))))
     {
         help_window_ = true;
     }
-    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut("SaveImage"))))
+    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut(kSaveImageShortcut))))
     {
         makePrtSc(std::get<0>(window_parameters), std::get<1>(window_parameters));
     }
-    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut("Exit"))))
+    if (io.KeyCtrl && ImGui::IsKeyPressed(static_cast<ImGuiKey>(Config::getShortcut(kExitShortcut))))
     {
         exitConfirmMessage();
     }
@@ -253,7 +897,8 @@ void GuiWindow::openFile()
                                     { "Object Files", "*.obj"}).result();
     if (!selection.empty())
     {
-        object_.loadObjectFile(selection[0]);
+        std::string filepath = selection[0];
+        render_thread_.post([this, filepath](){object_.loadObjectFile(filepath);});
     }
     else
     {
@@ -262,26 +907,40 @@ void GuiWindow::openFile()
     }
 }
 
-void GuiWindow::saveRenderedImage(const char* filename, int width, int height)
-/** Creates a .png file with the screen image.*/
+void GuiWindow::reportLoadError()
+/** Displays the error of a failed .obj load. Load tasks only store their errors, since a dialog would block the
+worker; they are shown here while the render thread waits for the next frame.*/
 {
-    std::vector<unsigned char> pixels(width * height * 3);
-    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    std::string error = scene_.takeLoadError();
+    if (!error.empty())
+    {
+        pfd::message("Problem", error, pfd::choice::ok, pfd::icon::error);
+    }
+}
 
-    // Flip the image vertically
-    for (int y = 0; y < height / 2; ++y) {
-        for (int x = 0; x < width * 3; ++x) {
-            std::swap(pixels[y * width * 3 + x], pixels[(height - 1 - y) * width * 3 + x]);
+void GuiWindow::saveRenderedImage(const char* filename, int width, int height)
+/** Reads the screen image on the render thread and creates a .png file with it in a background task,
+so flipping and encoding the image do not delay the next frame.*/
+{
+    auto pixels = std::make_shared<std::vector<unsigned char>>(width * height * 3);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels->data());
+
+    std::string image_path = filename;
+    TaskScheduler::instance().submit("Encode screenshot", [pixels, image_path, width, height]() {
+        // Flip the image vertically
+        for (int y = 0; y < height / 2; ++y) {
+            std::swap_ranges(pixels->begin() + y * width * 3, pixels->begin() + (y + 1) * width * 3,
+                             pixels->begin() + (height - 1 - y) * width * 3);
         }
-    }
 
-    if (!stbi_write_png(filename, width, height, 3, pixels.data(), width * 3))
-    {
-        std::cerr << "Failed to save image to " << filename << std::endl;
-    } else
-    {
-        std::cout << "Image saved to " << filename << std::endl;
-    }
+        if (!stbi_write_png(image_path.c_str(), width, height, 3, pixels->data(), width * 3))
+        {
+            std::cerr << "Failed to save image to " << image_path << std::endl;
+        } else
+        {
+            std::cout << "Image saved to " << image_path << std::endl;
+        }
+    });
 }
 
 void GuiWindow::makePrtSc(int width, int height)
@@ -300,7 +959,9 @@ void GuiWindow::makePrtSc(int width, int height)
 
         strftime(date_string, sizeof(date_string), "%Y_%m_%d_%H_%M", curr_tm);
         rendered_image_path_ = folder + "/image_" + date_string + ".png";
-        saveRenderedImage(rendered_image_path_.c_str(),width, height);
+        // The framebuffer is read on the render thread once the next frame is drawn, before buffers are swapped.
+        std::string image_path = rendered_image_path_;
+        render_thread_.post([image_path, width, height](){saveRenderedImage(image_path.c_str(), width, height);}, kAfterFrame);
         rendered_image_path_.clear();
     }
     save_image_ = false;
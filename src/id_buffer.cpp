@@ -0,0 +1,162 @@
+#include <chrono>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+#include "../include/id_buffer.h"
+
+bool IdBuffer::resize(int width, int height)
+/** Creates the framebuffer with color and depth renderbuffers of the window size, and the pixel buffer for readback.
+Returns false if the framebuffer is not supported. */
+{
+    if (framebuffer_ != 0 && width == width_ && height == height_)
+    {
+        return true;
+    }
+    release();
+
+    glGenFramebuffers(1, &framebuffer_);
+    glGenRenderbuffers(1, &color_buffer_);
+    glGenRenderbuffers(1, &depth_buffer_);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "ID buffer framebuffer is incomplete: " << status << std::endl;
+        release();
+        return false;
+    }
+
+    glGenBuffers(1, &pixel_buffer_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer_);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 4, nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+void IdBuffer::release()
+{
+    if (framebuffer_ != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer_);
+        glDeleteRenderbuffers(1, &color_buffer_);
+        glDeleteRenderbuffers(1, &depth_buffer_);
+    }
+    if (pixel_buffer_ != 0)
+    {
+        glDeleteBuffers(1, &pixel_buffer_);
+    }
+    framebuffer_ = color_buffer_ = depth_buffer_ = pixel_buffer_ = 0;
+    width_ = height_ = 0;
+    valid_ = false;
+    pending_ = false;
+}
+
+void IdBuffer::render(const Object& object, const glm::mat4& model_view, const glm::mat4& projection, const glm::vec4& viewport,
+                      int width, int height)
+/** Renders shape IDs of the Object with the given matrices, unless the buffer already holds them.
+The viewport, clear color and framebuffer binding are restored afterwards. */
+{
+    if (valid_ && width == width_ && height == height_ && object.version() == object_version_
+        && model_view == model_view_ && projection == projection_ && viewport == viewport_)
+    {
+        return;
+    }
+    if (!resize(width, height))
+    {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GLint previous_viewport[4];
+    GLfloat previous_clear_color[4];
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previous_clear_color);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(static_cast<GLint>(viewport.x), static_cast<GLint>(viewport.y),
+               static_cast<GLsizei>(viewport.z), static_cast<GLsizei>(viewport.w));
+    // ID 0 means no shape, so the buffer is cleared to black. Dithering would change encoded colors.
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_DITHER);
+    glEnable(GL_DEPTH_TEST);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadMatrixf(glm::value_ptr(projection));
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadMatrixf(glm::value_ptr(model_view));
+
+    object.drawShapeIds();
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    glEnable(GL_DITHER);
+    glClearColor(previous_clear_color[0], previous_clear_color[1], previous_clear_color[2], previous_clear_color[3]);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+
+    valid_ = true;
+    model_view_ = model_view;
+    projection_ = projection;
+    viewport_ = viewport;
+    object_version_ = object.version();
+    render_count_++;
+    last_render_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void IdBuffer::requestPixel(int x_window, int y_window)
+/** Starts reading one pixel into the pixel buffer; glReadPixels returns without waiting for the GPU.
+The result is collected with readResult on a following frame. */
+{
+    if (!valid_ || x_window < 0 || y_window < 0 || x_window >= width_ || y_window >= height_)
+    {
+        return;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer_);
+    glReadPixels(x_window, y_window, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    pending_ = true;
+}
+
+bool IdBuffer::readResult(uint32_t& shape)
+/** Collects the pixel requested earlier and decodes the shape index, kNoShape for background.
+Returns false if no read is pending. */
+{
+    if (!pending_)
+    {
+        return false;
+    }
+    pending_ = false;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffer_);
+    auto* pixel = static_cast<const GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    uint32_t id = 0;
+    if (pixel != nullptr)
+    {
+        id = uint32_t(pixel[0]) | uint32_t(pixel[1]) << 8 | uint32_t(pixel[2]) << 16;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    shape = id == 0 ? kNoShape : id - 1;
+    return true;
+}
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include "../include/input_recorder.h"
+
+namespace
+{
+    // Log layout: header (magic, version, state flags, initial cursor position) followed by variable-length records.
+    // Each record is: type byte (high bit = ImGui captured the mouse), time delta in microseconds, type-specific payload.
+    const char kLogMagic[4] = {'I', 'R', 'E', 'C'};
+    const uint8_t kLogVersion{1};
+    const uint8_t kCaptureBit{0x80};
+
+    template <typename T>
+    void writeValue(std::ostream& stream, T value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool readValue(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+double InputRecorder::elapsedSeconds() const
+/** Returns the number of seconds passed since recording or replay has started. */
+{
+    return std::chrono::duration<double>(Clock::now() - start_time_).count();
+}
+
+void InputRecorder::startRecording(const InitialState& state)
+/** Clears previously recorded events, stores the application state the recording starts from and starts the clock. */
+{
+    replaying_ = false;
+    recording_ = true;
+    initial_state_ = state;
+    events_.clear();
+    start_time_ = Clock::now();
+}
+
+void InputRecorder::stopRecording()
+/** Stops recording, closing the last frame so a replay ends in the same state as the recording. */
+{
+    if (recording_)
+    {
+        recordFrameEnd();
+        recording_ = false;
+    }
+}
+
+void InputRecorder::addEvent(InputEvent event)
+/** Timestamps the event and appends it to the log. Timestamps are rounded to microseconds, as stored in the file,
+so an in-memory replay and a replay of the saved log behave identically. */
+{
+    auto micros = static_cast<int64_t>(elapsedSeconds() * 1e6);
+    event.timestamp = static_cast<double>(micros) * 1e-6;
+    events_.push_back(event);
+}
+
+void InputRecorder::recordMouseButton(int button, int action, int mods, bool imgui_capture_mouse)
+{
+    if (!recording_) return;
+    InputEvent event;
+    event.type = kMouseButtonEvent;
+    event.imgui_capture_mouse = imgui_capture_mouse;
+    event.code = button;
+    event.action = action;
+    event.mods = mods;
+    addEvent(event);
+}
+
+void InputRecorder::recordCursorPosition(double x, double y, bool imgui_capture_mouse)
+/** Cursor coordinates are stored as floats, which is exact enough for screen positions and halves the log size. */
+{
+    if (!recording_) return;
+    InputEvent event;
+    event.type = kCursorPositionEvent;
+    event.imgui_capture_mouse = imgui_capture_mouse;
+    event.x = static_cast<float>(x);
+    event.y = static_cast<float>(y);
+    addEvent(event);
+}
+
+void InputRecorder::recordKey(int key, int action, int mods)
+{
+    if (!recording_) return;
+    InputEvent event;
+    event.type = kKeyEvent;
+    event.code = key;
+    event.action = action;
+    event.mods = mods;
+    addEvent(event);
+}
+
+void InputRecorder::recordScroll(double y_offset, bool imgui_capture_mouse)
+{
+    if (!recording_) return;
+    InputEvent event;
+    event.type = kScrollEvent;
+    event.imgui_capture_mouse = imgui_capture_mouse;
+    event.y = static_cast<float>(y_offset);
+    addEvent(event);
+}
+
+void InputRecorder::recordFrameEnd()
+/** Marks the end of a rendered frame. Markers let a replay reproduce the original grouping of events per frame. */
+{
+    if (!recording_) return;
+    InputEvent event;
+    event.type = kFrameEndEvent;
+    addEvent(event);
+}
+
+bool InputRecorder::saveLog(const std::string& filepath) const
+/** Writes recorded events into a binary log. Returns false if the file cannot be written. */
+{
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write(kLogMagic, sizeof(kLogMagic));
+    writeValue<uint8_t>(file, kLogVersion);
+    uint8_t state_flags = (initial_state_.engineering_view ? 1 : 0) |
+                          (initial_state_.grid ? 2 : 0) |
+                          (initial_state_.dome_camera ? 4 : 0) |
+                          (initial_state_.orthogonal_view ? 8 : 0) |
+                          (initial_state_.arcball_camera ? 16 : 0) |
+                          ((initial_state_.viewport_layout & 7) << 5);
+    writeValue<uint8_t>(file, state_flags);
+    writeValue<double>(file, initial_state_.cursor_x);
+    writeValue<double>(file, initial_state_.cursor_y);
+
+    int64_t previous_micros = 0;
+    for (auto const& event : events_)
+    {
+        auto micros = static_cast<int64_t>(event.timestamp * 1e6 + 0.5);
+        uint8_t type_byte = static_cast<uint8_t>(event.type) | (event.imgui_capture_mouse ? kCaptureBit : 0);
+        writeValue<uint8_t>(file, type_byte);
+        writeValue<uint32_t>(file, static_cast<uint32_t>(micros - previous_micros));
+        previous_micros = micros;
+
+        switch (event.type)
+        {
+            case kMouseButtonEvent:
+                writeValue<uint8_t>(file, static_cast<uint8_t>(event.code));
+                writeValue<uint8_t>(file, static_cast<uint8_t>(event.action));
+                writeValue<uint8_t>(file, static_cast<uint8_t>(event.mods));
+                break;
+            case kCursorPositionEvent:
+                writeValue<float>(file, static_cast<float>(event.x));
+                writeValue<float>(file, static_cast<float>(event.y));
+                break;
+            case kKeyEvent:
+                writeValue<int16_t>(file, static_cast<int16_t>(event.code));
+                writeValue<uint8_t>(file, static_cast<uint8_t>(event.action));
+                writeValue<uint8_t>(file, static_cast<uint8_t>(event.mods));
+                break;
+            case kScrollEvent:
+                writeValue<float>(file, static_cast<float>(event.y));
+                break;
+            case kFrameEndEvent:
+                break;
+        }
+    }
+    return file.good();
+}
+
+bool InputRecorder::loadLog(const std::string& filepath)
+/** Reads events from a binary log created by saveLog. Returns false if the file is missing or malformed,
+in which case previously loaded events are kept. */
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    char magic[4];
+    uint8_t version, state_flags;
+    InitialState state;
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, kLogMagic) ||
+        !readValue(file, version) || version != kLogVersion ||
+        !readValue(file, state_flags) ||
+        !readValue(file, state.cursor_x) || !readValue(file, state.cursor_y))
+    {
+        return false;
+    }
+    state.engineering_view = (state_flags & 1) != 0;
+    state.grid = (state_flags & 2) != 0;
+    state.dome_camera = (state_flags & 4) != 0;
+    state.orthogonal_view = (state_flags & 8) != 0;
+    state.arcball_camera = (state_flags & 16) != 0;
+    state.viewport_layout = (state_flags >> 5) & 7;
+
+    std::vector<InputEvent> events;
+    int64_t micros = 0;
+    uint8_t type_byte;
+    while (readValue(file, type_byte))
+    {
+        InputEvent event;
+        uint32_t delta;
+        if (!readValue(file, delta))
+        {
+            return false;
+        }
+        micros += delta;
+        event.timestamp = static_cast<double>(micros) * 1e-6;
+        event.type = static_cast<InputEventType>(type_byte & ~kCaptureBit);
+        event.imgui_capture_mouse = (type_byte & kCaptureBit) != 0;
+
+        bool ok = true;
+        uint8_t u8_code, u8_action, u8_mods;
+        int16_t key;
+        float x, y;
+        switch (event.type)
+        {
+            case kMouseButtonEvent:
+                ok = readValue(file, u8_code) && readValue(file, u8_action) && readValue(file, u8_mods);
+                event.code = u8_code;
+                event.action = u8_action;
+                event.mods = u8_mods;
+                break;
+            case kCursorPositionEvent:
+                ok = readValue(file, x) && readValue(file, y);
+                event.x = x;
+                event.y = y;
+                break;
+            case kKeyEvent:
+                ok = readValue(file, key) && readValue(file, u8_action) && readValue(file, u8_mods);
+                event.code = key;
+                event.action = u8_action;
+                event.mods = u8_mods;
+                break;
+            case kScrollEvent:
+                ok = readValue(file, y);
+                event.y = y;
+                break;
+            case kFrameEndEvent:
+                break;
+            default:
+                ok = false;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    initial_state_ = state;
+    events_ = std::move(events);
+    return true;
+}
+
+void InputRecorder::startReplay(ReplaySpeed speed)
+/** Starts replaying loaded events from the beginning and resets collected frame timings. */
+{
+    recording_ = false;
+    replaying_ = !events_.empty();
+    replay_speed_ = speed;
+    replay_position_ = 0;
+    replay_time_ = 0;
+    frame_timings_ms_.clear();
+    start_time_ = Clock::now();
+    last_frame_time_ = start_time_;
+}
+
+void InputRecorder::stopReplay()
+{
+    replaying_ = false;
+}
+
+std::vector<InputRecorder::InputEvent> InputRecorder::nextReplayEvents()
+/** Called once per rendered frame during replay. Stores the duration of the previous frame and returns events to
+dispatch in this frame: events due by now at recorded speed, or events of the next recorded frame when replaying
+as fast as possible. Frame end markers are not returned. Replay stops after the last event. */
+{
+    std::vector<InputEvent> frame_events;
+    if (!replaying_)
+    {
+        return frame_events;
+    }
+
+    auto now = Clock::now();
+    if (replay_position_ > 0)
+    {
+        frame_timings_ms_.push_back(std::chrono::duration<double, std::milli>(now - last_frame_time_).count());
+    }
+    last_frame_time_ = now;
+
+    double elapsed = elapsedSeconds();
+    while (replay_position_ < events_.size())
+    {
+        const InputEvent& event = events_[replay_position_];
+        if (replay_speed_ == kRecordedSpeed && event.timestamp > elapsed)
+        {
+            break;
+        }
+        replay_position_++;
+        replay_time_ = event.timestamp;
+        if (event.type == kFrameEndEvent)
+        {
+            if (replay_speed_ == kAsFastAsPossible)
+            {
+                break;
+            }
+            continue;
+        }
+        frame_events.push_back(event);
+    }
+
+    if (replay_position_ >= events_.size())
+    {
+        replaying_ = false;
+    }
+    return frame_events;
+}
+
+double InputRecorder::time() const
+/** Returns seconds since the start of recording, or the recorded time of the frame being replayed, so animations
+driven by it replay the same way at any replay speed. */
+{
+    return replaying_ ? replay_time_ : elapsedSeconds();
+}
+
+InputRecorder::ReplayReport InputRecorder::replayReport() const
+/** Summarizes frame timings captured during the last replay. */
+{
+    ReplayReport report;
+    if (frame_timings_ms_.empty())
+    {
+        return report;
+    }
+
+    std::vector<double> sorted = frame_timings_ms_;
+    std::sort(sorted.begin(), sorted.end());
+
+    report.frames = sorted.size();
+    report.average_ms = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+    report.median_ms = sorted[sorted.size() / 2];
+    report.p95_ms = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+    report.max_ms = sorted.back();
+    return report;
+}
+
+bool InputRecorder::saveFrameTimings(const std::string& filepath) const
+/** Writes frame timings captured during the last replay into a .csv file. */
+{
+    std::ofstream file(filepath);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "frame,time_ms\n";
+    for (size_t i = 0; i < frame_timings_ms_.size(); i++)
+    {
+        file << i << "," << frame_timings_ms_[i] << "\n";
+    }
+    return file.good();
+}
@@ -0,0 +1,184 @@
+#include <iostream>
+#include "../include/instance_renderer.h"
+
+namespace
+{
+    // Attributes declared as mat4 and mat3 occupy consecutive locations, one per column.
+    const char* kVertexShader = R"(
+#version 130
+in mat4 instance_model;
+in mat3 instance_normal;
+uniform bool lighting;
+out vec4 color;
+void main()
+{
+    gl_Position = gl_ProjectionMatrix * (gl_ModelViewMatrix * (instance_model * gl_Vertex));
+    color = gl_Color;
+    if (lighting)
+    {
+        // Headlight shining along the view direction; both sides are lit.
+        vec3 normal = normalize(gl_NormalMatrix * (instance_normal * gl_Normal));
+        color.rgb *= 0.2 + 0.8 * abs(normal.z);
+    }
+}
+)";
+
+    const char* kFragmentShader = R"(
+#version 130
+in vec4 color;
+void main()
+{
+    gl_FragColor = color;
+}
+)";
+
+    GLuint compileShader(GLenum type, const char* source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled != GL_TRUE)
+        {
+            char log[1024];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "Instance shader does not compile: " << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+}
+
+bool InstanceRenderer::available()
+/** Returns true if instanced drawing is supported. The program is created on the first call, which needs a current OpenGL context. */
+{
+    if (!initialized_)
+    {
+        initialized_ = true;
+        available_ = GLEW_ARB_draw_instanced && GLEW_ARB_instanced_arrays && createProgram();
+    }
+    return available_;
+}
+
+bool InstanceRenderer::createProgram()
+{
+    GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, kVertexShader);
+    GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (vertex_shader == 0 || fragment_shader == 0)
+    {
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+        return false;
+    }
+
+    program_ = glCreateProgram();
+    glAttachShader(program_, vertex_shader);
+    glAttachShader(program_, fragment_shader);
+    glLinkProgram(program_);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program_, GL_LINK_STATUS, &linked);
+    model_location_ = glGetAttribLocation(program_, "instance_model");
+    normal_location_ = glGetAttribLocation(program_, "instance_normal");
+    lighting_location_ = glGetUniformLocation(program_, "lighting");
+    if (linked != GL_TRUE || model_location_ < 0 || normal_location_ < 0)
+    {
+        std::cerr << "Instance shader program does not link." << std::endl;
+        release();
+        return false;
+    }
+    glGenBuffers(1, &instance_buffer_);
+    return true;
+}
+
+void InstanceRenderer::upload(const std::vector<glm::mat4>& transforms)
+/** Uploads the model matrices of the instances with their normal matrices (inverse transpose of the upper 3x3 part). */
+{
+    instance_data_.clear();
+    instance_data_.reserve(transforms.size() * 25);
+    for (auto const& transform : transforms)
+    {
+        glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(transform)));
+        for (int column = 0; column < 4; column++)
+        {
+            instance_data_.insert(instance_data_.end(), {transform[column][0], transform[column][1], transform[column][2], transform[column][3]});
+        }
+        for (int column = 0; column < 3; column++)
+        {
+            instance_data_.insert(instance_data_.end(), {normal[column][0], normal[column][1], normal[column][2]});
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    size_t bytes = instance_data_.size() * sizeof(float);
+    if (bytes > buffer_bytes_)
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), instance_data_.data(), GL_STREAM_DRAW);
+        buffer_bytes_ = bytes;
+    }
+    else
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(bytes), instance_data_.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceRenderer::begin(size_t first_instance, bool lighting) const
+/** Binds the program and the uploaded transforms starting with the given instance. Leaves GL_ARRAY_BUFFER unbound,
+so vertex arrays of the mesh can be specified afterwards. */
+{
+    const GLsizei stride = 25 * sizeof(float);
+    const size_t first_byte = first_instance * stride;
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+    for (int column = 0; column < 4; column++)
+    {
+        GLuint location = static_cast<GLuint>(model_location_ + column);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(first_byte + column * 4 * sizeof(float)));
+        glVertexAttribDivisorARB(location, 1);
+    }
+    for (int column = 0; column < 3; column++)
+    {
+        GLuint location = static_cast<GLuint>(normal_location_ + column);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(first_byte + (16 + column * 3) * sizeof(float)));
+        glVertexAttribDivisorARB(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(program_);
+    glUniform1i(lighting_location_, lighting ? 1 : 0);
+}
+
+void InstanceRenderer::end() const
+{
+    glUseProgram(0);
+    for (int column = 0; column < 4; column++)
+    {
+        glVertexAttribDivisorARB(static_cast<GLuint>(model_location_ + column), 0);
+        glDisableVertexAttribArray(static_cast<GLuint>(model_location_ + column));
+    }
+    for (int column = 0; column < 3; column++)
+    {
+        glVertexAttribDivisorARB(static_cast<GLuint>(normal_location_ + column), 0);
+        glDisableVertexAttribArray(static_cast<GLuint>(normal_location_ + column));
+    }
+}
+
+void InstanceRenderer::release()
+{
+    if (program_ != 0)
+    {
+        glDeleteProgram(program_);
+    }
+    if (instance_buffer_ != 0)
+    {
+        glDeleteBuffers(1, &instance_buffer_);
+    }
+    program_ = instance_buffer_ = 0;
+    buffer_bytes_ = 0;
+    available_ = false;
+}
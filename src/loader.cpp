@@ -1,12 +1,21 @@
 
+#include <cmath>
 #include <iostream>
 #include "tiny_obj_loader.h"
 #include "../include/loader.h"
+#include "../include/memory_stats.h"
 
-void ObjectLoader::loadObFileData(const std::string &filepath,
-                                  std::vector<float> &object_vertices,
-                                  std::vector<std::vector<unsigned int>> &object_shapes)
-/** Loads vertices and vector of shapes where each shape contains indices using open-source library tiny-obj-loader.*/
+size_t ObjectLoader::loadObFileData(const std::string &filepath,
+                                    std::vector<float> &object_vertices,
+                                    std::vector<unsigned int> &object_indices,
+                                    std::vector<ShapeRange> &object_shapes,
+                                    std::vector<float> &object_normals)
+/** Loads vertices, indices of all shapes stored one after another in a single array, and a table of shapes
+with their range in this array using open-source library tiny-obj-loader.
+Normals of the file are kept as one normal per vertex, averaged over all corners referencing the vertex;
+if any corner has no normal, object_normals is left empty and normals have to be generated.
+Returns the estimated peak memory of the load: tiny-obj-loader data and the resulting vertices and indices,
+which exist at the same time before the reader is destroyed.*/
 {
     tinyobj::ObjReaderConfig reader_config;
     tinyobj::ObjReader reader;
@@ -27,23 +36,79 @@ void ObjectLoader::loadObFileData(const std::string &filepath,
         throw reader.Warning();
     }
 
-    tinyobj::attrib_t attrib    = reader.GetAttrib();
-    std::vector<tinyobj::shape_t> shapes    = reader.GetShapes();
+    // References avoid copying the whole parsed file, which would double the peak memory of loading.
+    const tinyobj::attrib_t& attrib    = reader.GetAttrib();
+    const std::vector<tinyobj::shape_t>& shapes    = reader.GetShapes();
 
-    for (auto const& vertex : attrib.vertices)
+    object_vertices.assign(attrib.vertices.begin(), attrib.vertices.end());
+
+    size_t reader_bytes = vectorBytes(attrib.vertices) + vectorBytes(attrib.normals) +
+                          vectorBytes(attrib.texcoords) + vectorBytes(attrib.colors) + vectorBytes(shapes);
+    size_t result_bytes = vectorBytes(object_vertices);
+
+    // Indices of all shapes are counted first, so the index array is allocated once.
+    size_t index_count = 0;
+    for (auto const& shape : shapes)
     {
-        object_vertices.push_back(vertex);
+        index_count += shape.mesh.indices.size();
+        reader_bytes += vectorBytes(shape.mesh.indices) + vectorBytes(shape.mesh.num_face_vertices);
     }
+    object_indices.reserve(index_count);
+    object_shapes.reserve(shapes.size());
 
     for (auto const& shape : shapes)
     {
-        std::vector<unsigned int> shape_indices;
+        ShapeRange range;
+        range.offset = object_indices.size();
+        range.count = shape.mesh.indices.size();
+        range.name = shape.name;
 
         for (auto const& index : shape.mesh.indices)
         {
-            shape_indices.push_back(index.vertex_index);
+            object_indices.push_back(index.vertex_index);
         }
+        object_shapes.push_back(std::move(range));
+    }
 
-        object_shapes.push_back(shape_indices);
+    // OBJ normals are indexed per face corner, the Object stores positions and normals with the same index.
+    bool normals_complete = !attrib.normals.empty();
+    if (normals_complete)
+    {
+        object_normals.assign(object_vertices.size(), 0.0f);
+        for (auto const& shape : shapes)
+        {
+            for (auto const& index : shape.mesh.indices)
+            {
+                if (index.normal_index < 0)
+                {
+                    normals_complete = false;
+                    break;
+                }
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    object_normals[3 * size_t(index.vertex_index) + axis] += attrib.normals[3 * size_t(index.normal_index) + axis];
+                }
+            }
+            if (!normals_complete)
+            {
+                break;
+            }
+        }
+        for (size_t i = 0; normals_complete && i < object_normals.size(); i += 3)
+        {
+            float length = std::sqrt(object_normals[i] * object_normals[i] + object_normals[i + 1] * object_normals[i + 1]
+                                     + object_normals[i + 2] * object_normals[i + 2]);
+            for (int axis = 0; axis < 3 && length > 0; axis++)
+            {
+                object_normals[i + axis] /= length;
+            }
+        }
     }
+    if (!normals_complete)
+    {
+        object_normals.clear();
+    }
+    result_bytes += vectorBytes(object_indices) + vectorBytes(object_shapes) + vectorBytes(object_normals);
+
+    return reader_bytes + result_bytes;
 }
@@ -6,22 +6,29 @@
 #include "backends/imgui_impl_opengl3.h"
 
 #include "../include/object.h"
+#include "../include/scene.h"
 #include "../include/drawing_lib.h"
 #include "../include/gui.h"
+#include "../include/render_thread.h"
+#include "../include/task_scheduler.h"
 #include "../include/config.h"
 
 Parameters Config::parameters_;
-std::map<std::string, char> Config::shortcuts_ = {
-        {"Animate", 'A'},
-        {"Exit", 'Q'},
-        {"OpenFile", 'O'},
-        {"SaveImage", 'S'},
-        {"Help", 'H'},
-        {"SwitchCameraMode", '0'},
-        {"SwitchCameraView", '1'},
-        {"EnableGrid", '3'},
-        {"SwitchEngineeringView", '4'}
+std::shared_ptr<const ConfigSnapshot> Config::published_;
+thread_local std::shared_ptr<const ConfigSnapshot> Config::thread_snapshot_;
+std::array<char, kShortcutCount> Config::shortcuts_ = {
+        '\0',
+        'A',    // Animate
+        'Q',    // Exit
+        'O',    // OpenFile
+        'S',    // SaveImage
+        'H',    // Help
+        '0',    // SwitchCameraMode
+        '1',    // SwitchCameraView
+        '3',    // EnableGrid
+        '4'     // SwitchEngineeringView
 };
+std::array<ShortcutAction, kShortcutKeyCount> Config::actions_by_key_ = Config::buildActionTable();
 
 
 int main()
@@ -32,9 +39,13 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
 
     // Session
-    Object object = Object();
+    auto object = std::make_shared<Object>();
+    Scene scene(object);
     DrawingLib drawing_lib    = DrawingLib();
-    GuiWindow gui_window = GuiWindow(object);
+    RenderThread render_thread;
+    TaskProfiler task_profiler;
+    TaskScheduler::instance().setTimingHook([&task_profiler](const TaskTiming& timing){task_profiler.record(timing);});
+    GuiWindow gui_window = GuiWindow(scene, render_thread, task_profiler);
 
     GLFWwindow* window = drawing_lib.createWindow();
     glfwMakeContextCurrent(window);
@@ -59,11 +70,31 @@ int main()
 
     ImGui_ImplOpenGL3_CreateFontsTexture();
 
-    object.loadObjectFile("../objects/bunny.obj");
+    Config::publish();
+    object->loadObjectFile("../objects/bunny.obj");
+    object->finishLoading(true);
+
+    // From here on the OpenGL context belongs to the render thread: it draws the scene and the UI of a frame and swaps
+    // buffers, while this thread polls events and lays out the UI of the next frame.
+    glfwMakeContextCurrent(nullptr);
+    render_thread.start(window, [&drawing_lib, window](FrameSnapshot& frame) {
+        drawing_lib.drawScene(window, frame);
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplOpenGL3_RenderDrawData(frame.ui_draw_data);
+
+        GLuint res = glGetError();
+        if (res)
+        {
+            std::cout << glewGetErrorString(res) << std::endl;
+        }
+    });
 
     while (glfwWindowShouldClose(window) == 0)
     {
-        ImGui_ImplOpenGL3_NewFrame();
+        // The draw data of the previous ImGui frame and the scene must not be in use when the UI changes them.
+        render_thread.waitForFrameData();
+
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
@@ -78,21 +109,20 @@ int main()
         // Check if ImGui wants to capture the mouse
         bool ioWantCaptureMouse = ImGui::GetIO().WantCaptureMouse;
 
-        drawing_lib.drawScene(window, object, ioWantCaptureMouse);
-
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        glfwSwapBuffers(window);
+        auto frame = drawing_lib.makeSnapshot(scene, ioWantCaptureMouse);
+        frame->ui_draw_data = ImGui::GetDrawData();
+        render_thread.submit(std::move(frame));
 
         glfwPollEvents();
-        GLuint res = glGetError();
-        if (res)
-        {
-            std::cout << glewGetErrorString(res) << std::endl;
-        }
-
+        drawing_lib.processRecordedInput(window);
     }
+    render_thread.stop();
+    glfwMakeContextCurrent(window);
+    scene.release();
+    // Tasks still running on the workers must not record into the profiler once it is destroyed.
+    TaskScheduler::instance().setTimingHook(nullptr);
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,219 @@
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include "../include/measure_tool.h"
+#include "../include/font.h"
+
+namespace
+{
+    std::string formatLength(const char* label, float length)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s%.3f", label, length);
+        return buffer;
+    }
+
+    void setSnapColor(SnapKind kind)
+    {
+        switch (kind)
+        {
+            case kSnapVertex: glColor3f(0, 1, 0); break;
+            case kSnapEdge: glColor3f(0, 1, 1); break;
+            case kSnapSurface: glColor3f(1, 1, 0); break;
+            default: glColor3f(1, 1, 1); break;
+        }
+    }
+}
+
+void MeasureTool::start(const Object& object, const Ray& ray, const SnapRadius& snap_radius)
+/** Starts a new measurement at the snapped point under the cursor. Nothing happens if the cursor misses the Object. */
+{
+    auto start_time = std::chrono::steady_clock::now();
+    SnapPoint point = snap(object, ray, snap_radius);
+    if (point.kind != kSnapNone)
+    {
+        measuring_ = true;
+        measurement_ = Measurement();
+        measurement_.start = point;
+        measurement_.end = point;
+        view_ray_ = ray;
+        measure(object);
+    }
+    hover_ = point;
+    query_time_us_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void MeasureTool::update(const Object& object, const Ray& ray, const SnapRadius& snap_radius)
+/** Moves the end point of the current measurement to the cursor, or only updates the snap preview
+when no measurement is in progress. */
+{
+    auto start_time = std::chrono::steady_clock::now();
+    hover_ = snap(object, ray, snap_radius);
+    if (measuring_ && hover_.kind != kSnapNone)
+    {
+        measurement_.end = hover_;
+        view_ray_ = ray;
+        measure(object);
+    }
+    query_time_us_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void MeasureTool::clear()
+{
+    measuring_ = false;
+    hover_ = SnapPoint();
+    measurement_ = Measurement();
+}
+
+MeasureTool::SnapPoint MeasureTool::snap(const Object& object, const Ray& ray, const SnapRadius& snap_radius) const
+/** Snaps the cursor ray to the Object: a vertex has priority over an edge of the hit triangle, an edge over the surface.
+If the ray misses the Object during a measurement, the point is placed on the plane through the start point
+perpendicular to the ray. */
+{
+    SnapPoint result;
+    RayHit hit;
+    if (!object.pick(ray, hit))
+    {
+        if (measuring_)
+        {
+            float distance = glm::dot(measurement_.start.point - ray.origin, ray.direction);
+            result.kind = kSnapFree;
+            result.point = ray.origin + ray.direction * distance;
+        }
+        return result;
+    }
+
+    float radius = snap_radius(hit.point);
+
+    uint32_t vertex;
+    float vertex_distance;
+    if (object.vertexGrid().nearest(hit.point, radius, vertex, vertex_distance))
+    {
+        result.kind = kSnapVertex;
+        result.point = object.vertex(vertex);
+        return result;
+    }
+
+    float closest = radius;
+    for (int corner = 0; corner < 3; corner++)
+    {
+        glm::vec3 edge_point = closestPointOnSegment(hit.point, object.triangleVertex(hit.triangle, corner),
+                                                     object.triangleVertex(hit.triangle, (corner + 1) % 3));
+        float distance = glm::distance(edge_point, hit.point);
+        if (distance <= closest)
+        {
+            closest = distance;
+            result.kind = kSnapEdge;
+            result.point = edge_point;
+        }
+    }
+    if (result.kind == kSnapNone)
+    {
+        result.kind = kSnapSurface;
+        result.point = hit.point;
+    }
+    return result;
+}
+
+void MeasureTool::measure(const Object& object)
+/** Calculates the length of the measurement. A free end point gets its distance to the closest point of the mesh;
+an end point on the surface gets the thickness of the mesh section behind it, i.e. the distance along the view ray
+to the next surface. */
+{
+    measurement_.length = glm::distance(measurement_.start.point, measurement_.end.point);
+    measurement_.mesh_distance = -1;
+    measurement_.section = -1;
+
+    if (measurement_.end.kind == kSnapFree)
+    {
+        RayHit closest;
+        if (object.bvh().closestPoint(measurement_.end.point, FLT_MAX, closest))
+        {
+            measurement_.mesh_distance = closest.distance;
+            measurement_.mesh_point = closest.point;
+        }
+        return;
+    }
+
+    // The ray starts slightly behind the end point, so the surface the point lies on is not hit again.
+    const Bvh::Node& root = object.bvh().nodes()[0];
+    float offset = glm::distance(root.min, root.max) * 1e-5f;
+    Ray section_ray{measurement_.end.point + view_ray_.direction * offset, view_ray_.direction};
+    RayHit exit;
+    if (object.pick(section_ray, exit))
+    {
+        measurement_.section = exit.distance + offset;
+    }
+}
+
+void MeasureTool::draw() const
+/** Draws the measurement and the snap preview on top of the Object, with lengths in model units.
+Expects the modelview matrix the Object was drawn with. */
+{
+    glDisable(GL_DEPTH_TEST);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPointSize(7.0f);
+
+    if (measurement_.start.kind != kSnapNone)
+    {
+        const glm::vec3& start = measurement_.start.point;
+        const glm::vec3& end = measurement_.end.point;
+
+        glColor3f(1, 1, 0);
+        glBegin(GL_LINES);
+        glVertex3f(start.x, start.y, start.z);
+        glVertex3f(end.x, end.y, end.z);
+        if (measurement_.mesh_distance >= 0)
+        {
+            glColor3f(.5, .5, .5);
+            glVertex3f(end.x, end.y, end.z);
+            glVertex3f(measurement_.mesh_point.x, measurement_.mesh_point.y, measurement_.mesh_point.z);
+        }
+        glEnd();
+
+        glBegin(GL_POINTS);
+        setSnapColor(measurement_.start.kind);
+        glVertex3f(start.x, start.y, start.z);
+        setSnapColor(measurement_.end.kind);
+        glVertex3f(end.x, end.y, end.z);
+        glEnd();
+
+        glColor3f(1, 1, 0);
+        glm::vec3 middle = (start + end) * 0.5f;
+        glRasterPos3f(middle.x, middle.y, middle.z);
+        print_string(formatLength("", measurement_.length).c_str());
+
+        glRasterPos3f(end.x, end.y, end.z);
+        if (measurement_.mesh_distance >= 0)
+        {
+            print_string(formatLength("  to mesh: ", measurement_.mesh_distance).c_str());
+        }
+        else if (measurement_.section >= 0)
+        {
+            print_string(formatLength("  section: ", measurement_.section).c_str());
+        }
+    }
+
+    if (!measuring_ && hover_.kind != kSnapNone)
+    {
+        setSnapColor(hover_.kind);
+        glBegin(GL_POINTS);
+        glVertex3f(hover_.point.x, hover_.point.y, hover_.point.z);
+        glEnd();
+        glRasterPos3f(hover_.point.x, hover_.point.y, hover_.point.z);
+        print_string(("  " + snapKindToString(hover_.kind)).c_str());
+    }
+    glEnable(GL_DEPTH_TEST);
+}
+
+std::string MeasureTool::snapKindToString(SnapKind kind)
+{
+    switch (kind)
+    {
+        case kSnapVertex: return "vertex";
+        case kSnapEdge: return "edge";
+        case kSnapSurface: return "surface";
+        case kSnapFree: return "free";
+        default: return "";
+    }
+}
@@ -0,0 +1,33 @@
+#include <cstdio>
+#include "../include/memory_stats.h"
+
+void MemoryStats::writeCsv(std::ostream& stream) const
+/** Writes memory statistics as "category,bytes" rows. */
+{
+    stream << "category,bytes\n";
+    stream << "vertices," << vertex_bytes << "\n";
+    stream << "indices," << index_bytes << "\n";
+    stream << "normals," << normal_bytes << "\n";
+    stream << "caches," << cache_bytes << "\n";
+    stream << "cpu_total," << cpuBytes() << "\n";
+    stream << "gpu_buffers," << gpu_bytes << "\n";
+    stream << "submitted_per_frame," << submitted_bytes << "\n";
+    stream << "peak_load," << peak_load_bytes << "\n";
+}
+
+std::string formatBytes(size_t bytes)
+/** Converts a number of bytes into a human-readable string, e.g. "1.5 MB". */
+{
+    const char* units[] = {"B", "KB", "MB", "GB"};
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 3)
+    {
+        value /= 1024.0;
+        unit++;
+    }
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+    return buffer;
+}
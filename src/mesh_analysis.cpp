@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <glm/glm.hpp>
+#include "../include/mesh_analysis.h"
+#include "../include/edge_table.h"
+#include "../include/parallel.h"
+
+namespace
+{
+    struct TriangleTotals
+    {
+        double area{0};
+        double volume{0};
+        size_t degenerate{0};
+        std::array<size_t, kHistogramBins> quality_histogram{};
+    };
+
+    glm::vec3 position(const float* vertices, unsigned int index)
+    {
+        return {vertices[3 * size_t(index)], vertices[3 * size_t(index) + 1], vertices[3 * size_t(index) + 2]};
+    }
+
+    size_t findRoot(std::vector<size_t>& parents, size_t i)
+    {
+        while (parents[i] != i)
+        {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+}
+
+MeshAnalyzer::~MeshAnalyzer()
+/** Cancels the analysis and waits for it, since it reads the mesh of the Object, which is released after the analyzer. */
+{
+    cancel();
+    if (run_ != nullptr)
+    {
+        run_->task.wait();
+    }
+}
+
+void MeshAnalyzer::start(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t shape_count)
+/** Cancels a running analysis and submits a new one as a background task, whose parallel stages inherit its priority. */
+{
+    cancel();
+    auto run = std::make_shared<Run>();
+    auto results = results_;
+    const float* vertex_data = vertices.data();
+    const unsigned int* index_data = indices.data();
+    size_t vertex_count = vertices.size();
+    size_t index_count = indices.size();
+    run->task = TaskScheduler::instance().submit("Mesh analysis", [run, results, vertex_data, vertex_count, index_data, index_count, shape_count]() {
+        MeshStatistics result;
+        if (analyze(vertex_data, vertex_count, index_data, index_count, shape_count, run->token, result))
+        {
+            // Statistics of a run cancelled meanwhile are dropped; cancel() takes the same lock.
+            std::lock_guard<std::mutex> lock(results->mutex);
+            if (!run->token.isCancelled())
+            {
+                results->statistics = result;
+            }
+        }
+        run->running = false;
+    }, kBackgroundPriority, run->token);
+    run_ = run;
+}
+
+void MeshAnalyzer::cancel()
+/** Asks the running analysis to stop without waiting for it and clears the published statistics. */
+{
+    std::lock_guard<std::mutex> lock(results_->mutex);
+    if (run_ != nullptr)
+    {
+        run_->token.cancel();
+    }
+    results_->statistics = MeshStatistics();
+}
+
+void MeshAnalyzer::release(std::vector<float>& vertices, std::vector<unsigned int>& indices)
+/** Cancels the analysis and, if its task may still read the given vertices and indices, moves them into the task's
+state, so they are freed when it stops instead of while it reads them. The vectors are left empty. */
+{
+    cancel();
+    if (run_ != nullptr && run_->running)
+    {
+        run_->released_vertices = std::move(vertices);
+        run_->released_indices = std::move(indices);
+    }
+    run_.reset();
+    vertices.clear();
+    indices.clear();
+}
+
+MeshStatistics MeshAnalyzer::statistics() const
+{
+    std::lock_guard<std::mutex> lock(results_->mutex);
+    return results_->statistics;
+}
+
+bool MeshAnalyzer::analyze(const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count,
+                           size_t shape_count, const CancellationToken& token, MeshStatistics& result)
+/** Runs the analysis stages: per-triangle measures, triangle area histogram, edge table, and edge topology
+with boundary components. Each stage is split between all workers; partial results are merged under a lock once per
+chunk. Every stage checks the token and returns false once it is cancelled. */
+{
+    auto start = std::chrono::steady_clock::now();
+    result = MeshStatistics();
+    result.triangles = index_count / 3;
+    result.vertices = vertex_count / 3;
+    result.shapes = shape_count;
+    result.threads = workerCount();
+    std::mutex merge_mutex;
+
+    // Surface area, volume, degenerate triangles and quality histogram.
+    TriangleTotals totals;
+    parallelFor(result.triangles, [&](size_t begin, size_t end) {
+        TriangleTotals partial;
+        for (size_t t = begin; t < end && !token.isCancelled(); t++)
+        {
+            unsigned int ia = indices[3 * t], ib = indices[3 * t + 1], ic = indices[3 * t + 2];
+            glm::vec3 a = position(vertices, ia), b = position(vertices, ib), c = position(vertices, ic);
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            double area = 0.5 * glm::length(normal);
+            partial.area += area;
+            partial.volume += glm::dot(a, glm::cross(b, c)) / 6.0;
+
+            float squared_lengths = glm::dot(b - a, b - a) + glm::dot(c - b, c - b) + glm::dot(a - c, a - c);
+            double quality = squared_lengths > 0 ? 4.0 * std::sqrt(3.0) * area / squared_lengths : 0.0;
+            if (ia == ib || ib == ic || ic == ia || quality < 1e-6)
+            {
+                partial.degenerate++;
+            }
+            auto bin = static_cast<int>(quality * kHistogramBins);
+            partial.quality_histogram[std::max(0, std::min(kHistogramBins - 1, bin))]++;
+        }
+
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        totals.area += partial.area;
+        totals.volume += partial.volume;
+        totals.degenerate += partial.degenerate;
+        for (int bin = 0; bin < kHistogramBins; bin++)
+        {
+            totals.quality_histogram[bin] += partial.quality_histogram[bin];
+        }
+    });
+    if (token.isCancelled())
+    {
+        return false;
+    }
+    result.surface_area = totals.area;
+    result.volume = totals.volume;
+    result.degenerate_triangles = totals.degenerate;
+    result.quality_histogram = totals.quality_histogram;
+
+    // Area histogram relative to the mean area, which is known only after the first pass.
+    double mean_area = result.triangles > 0 ? result.surface_area / static_cast<double>(result.triangles) : 0;
+    parallelFor(result.triangles, [&](size_t begin, size_t end) {
+        std::array<size_t, kHistogramBins> partial{};
+        for (size_t t = begin; t < end && !token.isCancelled(); t++)
+        {
+            glm::vec3 a = position(vertices, indices[3 * t]);
+            double area = 0.5 * glm::length(glm::cross(position(vertices, indices[3 * t + 1]) - a, position(vertices, indices[3 * t + 2]) - a));
+            int bin = area > 0 && mean_area > 0 ? static_cast<int>(std::floor(std::log2(area / mean_area))) + kHistogramBins / 2 : 0;
+            partial[std::max(0, std::min(kHistogramBins - 1, bin))]++;
+        }
+
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        for (int bin = 0; bin < kHistogramBins; bin++)
+        {
+            result.area_histogram[bin] += partial[bin];
+        }
+    });
+    if (token.isCancelled())
+    {
+        return false;
+    }
+
+    // Edge topology: runs of equal keys in the sorted edge table are edges.
+    EdgeTable edge_table;
+    edge_table.build(indices, index_count, token);
+    if (token.isCancelled())
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> boundary_edges;
+    auto const& records = edge_table.records();
+    edge_table.parallelForEdges([&](size_t begin, size_t end) {
+        size_t edges = 0, non_manifold = 0;
+        std::vector<uint64_t> boundary;
+        for (size_t i = begin; i < end && !token.isCancelled();)
+        {
+            size_t run_end = edge_table.runEnd(i);
+            edges++;
+            if (run_end - i == 1)
+            {
+                boundary.push_back(records[i].key);
+            }
+            else if (run_end - i > 2)
+            {
+                non_manifold++;
+            }
+            i = run_end;
+        }
+
+        std::lock_guard<std::mutex> lock(merge_mutex);
+        result.edges += edges;
+        result.non_manifold_edges += non_manifold;
+        boundary_edges.insert(boundary_edges.end(), boundary.begin(), boundary.end());
+    });
+    if (token.isCancelled())
+    {
+        return false;
+    }
+    result.boundary_edges = boundary_edges.size();
+    edge_table.clear();
+
+    // Boundary components are connected components of the graph of boundary edges, found with union-find
+    // over the vertices the boundary edges use. Loops touching at a vertex form one component.
+    std::vector<uint32_t> boundary_vertices;
+    boundary_vertices.reserve(2 * boundary_edges.size());
+    for (uint64_t key : boundary_edges)
+    {
+        boundary_vertices.push_back(EdgeTable::firstVertex(key));
+        boundary_vertices.push_back(EdgeTable::secondVertex(key));
+    }
+    std::sort(boundary_vertices.begin(), boundary_vertices.end());
+    boundary_vertices.erase(std::unique(boundary_vertices.begin(), boundary_vertices.end()), boundary_vertices.end());
+
+    std::vector<size_t> parents(boundary_vertices.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    auto vertex_slot = [&](uint32_t vertex) {
+        return static_cast<size_t>(std::lower_bound(boundary_vertices.begin(), boundary_vertices.end(), vertex) - boundary_vertices.begin());
+    };
+    for (size_t i = 0; i < boundary_edges.size() && !token.isCancelled(); i++)
+    {
+        uint64_t key = boundary_edges[i];
+        size_t a = findRoot(parents, vertex_slot(EdgeTable::firstVertex(key)));
+        size_t b = findRoot(parents, vertex_slot(EdgeTable::secondVertex(key)));
+        parents[a] = b;
+    }
+    for (size_t i = 0; i < parents.size(); i++)
+    {
+        result.boundary_components += findRoot(parents, i) == i ? 1 : 0;
+    }
+    if (token.isCancelled())
+    {
+        return false;
+    }
+
+    result.analysis_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.valid = true;
+    return true;
+}
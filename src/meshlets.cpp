@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "../include/meshlets.h"
+#include "../include/memory_stats.h"
+#include "../include/parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MESHLETS_SSE 1
+#endif
+
+namespace
+{
+    // Cutoff of meshlets whose normals spread too much to ever be back-facing as a whole.
+    const float kNoCone = 2.0f;
+
+    glm::vec3 vertexAt(const std::vector<float>& vertices, unsigned int index)
+    {
+        return {vertices[3 * size_t(index)], vertices[3 * size_t(index) + 1], vertices[3 * size_t(index) + 2]};
+    }
+
+    struct CullView
+    /** Clipping planes, viewer position and direction in object coordinates. */
+    {
+        glm::vec4 planes[6];
+        glm::vec3 eye;
+        glm::vec3 direction;
+        bool orthographic;
+        bool cone_culling;
+    };
+
+    void clusterShape(const std::vector<unsigned int>& indices, const std::vector<uint32_t>& adjacency_start,
+                      const std::vector<uint32_t>& adjacency, size_t first_triangle, size_t end_triangle,
+                      std::vector<uint8_t>& used, std::vector<uint32_t>& order, std::vector<uint32_t>& meshlet_sizes)
+    /** Grows meshlets from the first unused triangle of the shape over triangles sharing a vertex with the meshlet,
+    in the order they are reached, while the triangle and vertex limits allow. */
+    {
+        std::vector<uint32_t> candidates;
+        uint32_t meshlet_vertices[kMeshletMaxVertices];
+        size_t seed = first_triangle;
+        size_t shape_triangles = end_triangle - first_triangle;
+        size_t ordered = 0;
+        while (ordered < shape_triangles)
+        {
+            while (used[seed])
+            {
+                seed++;
+            }
+            size_t vertex_count = 0;
+            size_t triangle_count = 0;
+            candidates.clear();
+            candidates.push_back(static_cast<uint32_t>(seed));
+            for (size_t head = 0; head < candidates.size() && triangle_count < kMeshletMaxTriangles; head++)
+            {
+                uint32_t triangle = candidates[head];
+                if (used[triangle])
+                {
+                    continue;
+                }
+                unsigned int new_vertices[3];
+                size_t new_count = 0;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int vertex = indices[3 * size_t(triangle) + corner];
+                    if (std::find(meshlet_vertices, meshlet_vertices + vertex_count, vertex) == meshlet_vertices + vertex_count
+                        && std::find(new_vertices, new_vertices + new_count, vertex) == new_vertices + new_count)
+                    {
+                        new_vertices[new_count++] = vertex;
+                    }
+                }
+                if (vertex_count + new_count > kMeshletMaxVertices)
+                {
+                    continue;
+                }
+                std::copy(new_vertices, new_vertices + new_count, meshlet_vertices + vertex_count);
+                vertex_count += new_count;
+                used[triangle] = 1;
+                order.push_back(triangle);
+                triangle_count++;
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int vertex = indices[3 * size_t(triangle) + corner];
+                    for (uint32_t i = adjacency_start[vertex]; i < adjacency_start[vertex + 1]; i++)
+                    {
+                        uint32_t neighbour = adjacency[i];
+                        if (neighbour >= first_triangle && neighbour < end_triangle && !used[neighbour])
+                        {
+                            candidates.push_back(neighbour);
+                        }
+                    }
+                }
+            }
+            meshlet_sizes.push_back(static_cast<uint32_t>(triangle_count));
+            ordered += triangle_count;
+        }
+    }
+}
+
+bool Meshlets::simd()
+{
+#ifdef MESHLETS_SSE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Meshlets::build(const std::vector<float>& vertices, std::vector<unsigned int>& indices, const std::vector<ShapeRange>& shapes)
+/** Splits every shape into meshlets of at most kMeshletMaxTriangles triangles and kMeshletMaxVertices vertices, reorders
+triangles inside each shape to follow the meshlets and computes their bounds. Shapes are clustered on all workers. */
+{
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    size_t vertex_count = vertices.size() / 3;
+    size_t triangle_count = indices.size() / 3;
+
+    // Triangles of each vertex, as ranges of one array.
+    std::vector<uint32_t> adjacency_start(vertex_count + 1, 0);
+    for (unsigned int index : indices)
+    {
+        adjacency_start[index + 1]++;
+    }
+    for (size_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        adjacency_start[vertex + 1] += adjacency_start[vertex];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+    fill = std::vector<uint32_t>();
+
+    std::vector<uint8_t> used(triangle_count, 0);
+    std::vector<unsigned int> reordered(indices.size());
+    std::vector<std::vector<uint32_t>> shape_meshlets(shapes.size());
+    parallelFor(shapes.size(), [&](size_t begin, size_t end) {
+        std::vector<uint32_t> order;
+        for (size_t shape = begin; shape < end; shape++)
+        {
+            size_t first_triangle = shapes[shape].offset / 3;
+            size_t end_triangle = first_triangle + shapes[shape].count / 3;
+            order.clear();
+            clusterShape(indices, adjacency_start, adjacency, first_triangle, end_triangle, used, order, shape_meshlets[shape]);
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    reordered[3 * (first_triangle + i) + corner] = indices[3 * size_t(order[i]) + corner];
+                }
+            }
+        }
+    }, 1);
+    indices.swap(reordered);
+
+    for (size_t shape = 0; shape < shapes.size(); shape++)
+    {
+        auto first_index = static_cast<uint32_t>(shapes[shape].offset);
+        for (uint32_t triangles : shape_meshlets[shape])
+        {
+            first_index_.push_back(first_index);
+            index_count_.push_back(3 * triangles);
+            first_index += 3 * triangles;
+        }
+    }
+
+    size_t padded = (first_index_.size() + 3) & ~size_t(3);
+    for (auto* bounds : {&center_x_, &center_y_, &center_z_, &radius_, &axis_x_, &axis_y_, &axis_z_})
+    {
+        bounds->assign(padded, 0.0f);
+    }
+    cutoff_.assign(padded, kNoCone);
+    parallelFor(first_index_.size(), [&](size_t begin, size_t end) {
+        for (size_t meshlet = begin; meshlet < end; meshlet++)
+        {
+            computeBounds(vertices, indices, meshlet);
+        }
+    }, 1024);
+    build_time_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Meshlets::computeBounds(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, size_t meshlet)
+/** Computes a bounding sphere around the center of the meshlet's bounding box and the cone of its unit triangle normals:
+the axis is their normalized sum and the cutoff is the sine of the largest angle between a normal and the axis.*/
+{
+    size_t first = first_index_[meshlet];
+    size_t end = first + index_count_[meshlet];
+    glm::vec3 min = vertexAt(vertices, indices[first]);
+    glm::vec3 max = min;
+    for (size_t i = first; i < end; i++)
+    {
+        min = glm::min(min, vertexAt(vertices, indices[i]));
+        max = glm::max(max, vertexAt(vertices, indices[i]));
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    float radius = 0;
+    std::vector<glm::vec3> normals;
+    glm::vec3 normal_sum(0.0f);
+    for (size_t i = first; i < end; i += 3)
+    {
+        glm::vec3 a = vertexAt(vertices, indices[i]);
+        glm::vec3 b = vertexAt(vertices, indices[i + 1]);
+        glm::vec3 c = vertexAt(vertices, indices[i + 2]);
+        radius = std::max(radius, std::max(glm::length(a - center), std::max(glm::length(b - center), glm::length(c - center))));
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length > 0)
+        {
+            normals.push_back(normal / length);
+            normal_sum += normal / length;
+        }
+    }
+    center_x_[meshlet] = center.x;
+    center_y_[meshlet] = center.y;
+    center_z_[meshlet] = center.z;
+    radius_[meshlet] = radius;
+
+    float sum_length = glm::length(normal_sum);
+    if (sum_length == 0)
+    {
+        return;
+    }
+    glm::vec3 axis = normal_sum / sum_length;
+    float min_dot = 1;
+    for (auto const& normal : normals)
+    {
+        min_dot = std::min(min_dot, glm::dot(axis, normal));
+    }
+    axis_x_[meshlet] = axis.x;
+    axis_y_[meshlet] = axis.y;
+    axis_z_[meshlet] = axis.z;
+    // Cones wider than about 84 degrees from the axis are almost never back-facing; they are not tested.
+    cutoff_[meshlet] = min_dot <= 0.1f ? kNoCone : std::sqrt(1 - min_dot * min_dot);
+}
+
+void Meshlets::clear()
+{
+    for (auto* values : {&first_index_, &index_count_})
+    {
+        values->clear();
+        values->shrink_to_fit();
+    }
+    for (auto* bounds : {&center_x_, &center_y_, &center_z_, &radius_, &axis_x_, &axis_y_, &axis_z_, &cutoff_})
+    {
+        bounds->clear();
+        bounds->shrink_to_fit();
+    }
+    build_time_ms_ = 0;
+}
+
+MeshletCullStats Meshlets::cull(const glm::mat4& model_view, const glm::mat4& projection, bool cone_culling,
+                                std::vector<uint32_t>& visible) const
+/** Appends meshlets that intersect the view frustum and, with cone_culling, are not entirely back-facing to visible,
+in ascending order. A meshlet is back-facing if dot(center - eye, axis) >= cutoff * |center - eye| + radius, or, for an
+orthogonal projection, if dot(view direction, axis) >= cutoff. */
+{
+    auto start = std::chrono::steady_clock::now();
+    MeshletCullStats stats;
+    stats.meshlets = first_index_.size();
+
+    // Planes of the clipping volume in object coordinates, from the rows of the combined matrix (Gribb and Hartmann).
+    CullView view;
+    glm::mat4 clip = projection * model_view;
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; row++)
+    {
+        rows[row] = glm::vec4(clip[0][row], clip[1][row], clip[2][row], clip[3][row]);
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        view.planes[2 * axis] = rows[3] + rows[axis];
+        view.planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    for (auto& plane : view.planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        plane = length > 0 ? plane / length : plane;
+    }
+    glm::mat4 inverse_model_view = glm::inverse(model_view);
+    view.orthographic = projection[3][3] == 1.0f;
+    view.eye = glm::vec3(inverse_model_view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    view.direction = glm::normalize(glm::vec3(inverse_model_view * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+    view.cone_culling = cone_culling;
+
+    size_t count = first_index_.size();
+#ifdef MESHLETS_SSE
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&center_x_[i]);
+        __m128 cy = _mm_loadu_ps(&center_y_[i]);
+        __m128 cz = _mm_loadu_ps(&center_z_[i]);
+        __m128 radius = _mm_loadu_ps(&radius_[i]);
+        __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+        __m128 outside = _mm_setzero_ps();
+        for (auto const& plane : view.planes)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negative_radius));
+        }
+        int frustum_mask = _mm_movemask_ps(outside);
+
+        int back_mask = 0;
+        if (view.cone_culling)
+        {
+            __m128 ax = _mm_loadu_ps(&axis_x_[i]);
+            __m128 ay = _mm_loadu_ps(&axis_y_[i]);
+            __m128 az = _mm_loadu_ps(&axis_z_[i]);
+            __m128 cutoff = _mm_loadu_ps(&cutoff_[i]);
+            __m128 back;
+            if (view.orthographic)
+            {
+                __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(view.direction.x), ax), _mm_mul_ps(_mm_set1_ps(view.direction.y), ay)),
+                                        _mm_mul_ps(_mm_set1_ps(view.direction.z), az));
+                back = _mm_cmpge_ps(dot, cutoff);
+            }
+            else
+            {
+                __m128 dx = _mm_sub_ps(cx, _mm_set1_ps(view.eye.x));
+                __m128 dy = _mm_sub_ps(cy, _mm_set1_ps(view.eye.y));
+                __m128 dz = _mm_sub_ps(cz, _mm_set1_ps(view.eye.z));
+                __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+                __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ax), _mm_mul_ps(dy, ay)), _mm_mul_ps(dz, az));
+                back = _mm_cmpge_ps(dot, _mm_add_ps(_mm_mul_ps(cutoff, length), radius));
+            }
+            back_mask = _mm_movemask_ps(back) & ~frustum_mask;
+        }
+
+        size_t lanes = std::min<size_t>(4, count - i);
+        for (size_t lane = 0; lane < lanes; lane++)
+        {
+            if (frustum_mask & (1 << lane))
+            {
+                stats.frustum_rejected++;
+            }
+            else if (back_mask & (1 << lane))
+            {
+                stats.backface_rejected++;
+            }
+            else
+            {
+                visible.push_back(static_cast<uint32_t>(i + lane));
+            }
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 center(center_x_[i], center_y_[i], center_z_[i]);
+        bool outside = false;
+        for (auto const& plane : view.planes)
+        {
+            outside = outside || glm::dot(glm::vec3(plane), center) + plane.w < -radius_[i];
+        }
+        if (outside)
+        {
+            stats.frustum_rejected++;
+            continue;
+        }
+        if (view.cone_culling)
+        {
+            glm::vec3 axis(axis_x_[i], axis_y_[i], axis_z_[i]);
+            bool back = view.orthographic ? glm::dot(view.direction, axis) >= cutoff_[i]
+                                          : glm::dot(center - view.eye, axis) >= cutoff_[i] * glm::length(center - view.eye) + radius_[i];
+            if (back)
+            {
+                stats.backface_rejected++;
+                continue;
+            }
+        }
+        visible.push_back(static_cast<uint32_t>(i));
+    }
+#endif
+    stats.time_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+size_t Meshlets::memoryBytes() const
+{
+    return vectorBytes(first_index_) + vectorBytes(index_count_) + vectorBytes(center_x_) + vectorBytes(center_y_)
+           + vectorBytes(center_z_) + vectorBytes(radius_) + vectorBytes(axis_x_) + vectorBytes(axis_y_) + vectorBytes(axis_z_)
+           + vectorBytes(cutoff_);
+}
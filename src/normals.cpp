@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "../include/normals.h"
+#include "../include/parallel.h"
+
+namespace
+{
+    void computeFaceNormals(const float* vertices, const unsigned int* indices, size_t begin, size_t end, float* face_normals)
+    /** Writes the cross product of two edges of each triangle; its length is twice the triangle area, which weights
+    the normal by area when summed. The loop has no branches, so the compiler can vectorize the arithmetic. */
+    {
+        for (size_t t = begin; t < end; t++)
+        {
+            const float* a = vertices + 3 * size_t(indices[3 * t]);
+            const float* b = vertices + 3 * size_t(indices[3 * t + 1]);
+            const float* c = vertices + 3 * size_t(indices[3 * t + 2]);
+            float e1x = b[0] - a[0], e1y = b[1] - a[1], e1z = b[2] - a[2];
+            float e2x = c[0] - a[0], e2y = c[1] - a[1], e2z = c[2] - a[2];
+            face_normals[3 * t] = e1y * e2z - e1z * e2y;
+            face_normals[3 * t + 1] = e1z * e2x - e1x * e2z;
+            face_normals[3 * t + 2] = e1x * e2y - e1y * e2x;
+        }
+    }
+
+    void normalize(float* normals, size_t begin, size_t end)
+    {
+        for (size_t v = begin; v < end; v++)
+        {
+            float* n = normals + 3 * v;
+            float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            float scale = length > 0 ? 1.0f / length : 0.0f;
+            n[0] *= scale;
+            n[1] *= scale;
+            n[2] *= scale;
+        }
+    }
+}
+
+void gatherSmoothNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals)
+/** Face normals are computed in parallel, then each vertex gathers the face normals of its triangles from
+a vertex-to-triangle table (compressed rows), so no two threads write to the same vertex. Independent of index order,
+but the table costs 4 bytes per index and is built on one thread. */
+{
+    size_t triangle_count = indices.size() / 3;
+    size_t vertex_count = vertices.size() / 3;
+
+    std::vector<float> face_normals(3 * triangle_count);
+    parallelFor(triangle_count, [&](size_t begin, size_t end) {
+        computeFaceNormals(vertices.data(), indices.data(), begin, end, face_normals.data());
+    });
+
+    // Triangles of vertex v are vertex_triangles[offsets[v], offsets[v + 1]).
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (unsigned int index : indices)
+    {
+        offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> vertex_triangles(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        vertex_triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    normals.resize(3 * vertex_count);
+    parallelFor(vertex_count, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++)
+        {
+            float x = 0, y = 0, z = 0;
+            for (uint32_t i = offsets[v]; i < offsets[v + 1]; i++)
+            {
+                const float* face_normal = face_normals.data() + 3 * size_t(vertex_triangles[i]);
+                x += face_normal[0];
+                y += face_normal[1];
+                z += face_normal[2];
+            }
+            normals[3 * v] = x;
+            normals[3 * v + 1] = y;
+            normals[3 * v + 2] = z;
+        }
+        normalize(normals.data(), begin, end);
+    });
+}
+
+void generateSmoothNormals(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals)
+/** Generates area-weighted vertex normals on all workers. Triangles are split into one chunk per worker; each chunk
+adds its face normals into its own accumulator covering only the range of vertex indices it uses, then the accumulators
+are summed per vertex range in parallel. Meshes from files have good index locality, so the ranges barely overlap;
+if they overlap too much, normals are gathered per vertex instead. Vertices not used by any triangle get a zero normal. */
+{
+    const size_t min_chunk = 65536;
+    size_t triangle_count = indices.size() / 3;
+    size_t vertex_count = vertices.size() / 3;
+    size_t chunks = std::min(workerCount(), triangle_count / min_chunk);
+    if (chunks <= 1)
+    {
+        generateSmoothNormalsSerial(vertices, indices, normals);
+        return;
+    }
+
+    struct Accumulator
+    {
+        size_t first_triangle, last_triangle;
+        unsigned int min_vertex, max_vertex;
+        std::vector<float> normals;
+    };
+    std::vector<Accumulator> accumulators(chunks);
+    size_t chunk_size = (triangle_count + chunks - 1) / chunks;
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            Accumulator& accumulator = accumulators[chunk];
+            accumulator.first_triangle = std::min(triangle_count, chunk * chunk_size);
+            accumulator.last_triangle = std::min(triangle_count, (chunk + 1) * chunk_size);
+            auto first = indices.begin() + 3 * accumulator.first_triangle, last = indices.begin() + 3 * accumulator.last_triangle;
+            auto range = std::minmax_element(first, last);
+            accumulator.min_vertex = *range.first;
+            accumulator.max_vertex = *range.second;
+        }
+    }, 1);
+
+    size_t accumulated_vertices = 0;
+    for (auto const& accumulator : accumulators)
+    {
+        accumulated_vertices += accumulator.max_vertex - accumulator.min_vertex + 1;
+    }
+    if (accumulated_vertices > 2 * vertex_count)
+    {
+        gatherSmoothNormals(vertices, indices, normals);
+        return;
+    }
+
+    parallelFor(chunks, [&](size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++)
+        {
+            Accumulator& accumulator = accumulators[chunk];
+            accumulator.normals.assign(3 * size_t(accumulator.max_vertex - accumulator.min_vertex + 1), 0.0f);
+            float face_normal[3];
+            for (size_t t = accumulator.first_triangle; t < accumulator.last_triangle; t++)
+            {
+                computeFaceNormals(vertices.data(), indices.data() + 3 * t, 0, 1, face_normal);
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    float* n = accumulator.normals.data() + 3 * size_t(indices[3 * t + corner] - accumulator.min_vertex);
+                    n[0] += face_normal[0];
+                    n[1] += face_normal[1];
+                    n[2] += face_normal[2];
+                }
+            }
+        }
+    }, 1);
+
+    normals.resize(3 * vertex_count);
+    parallelFor(vertex_count, [&](size_t begin, size_t end) {
+        std::fill(normals.begin() + 3 * begin, normals.begin() + 3 * end, 0.0f);
+        for (auto const& accumulator : accumulators)
+        {
+            size_t first = std::max<size_t>(begin, accumulator.min_vertex);
+            size_t last = std::min<size_t>(end, size_t(accumulator.max_vertex) + 1);
+            for (size_t v = first; v < last; v++)
+            {
+                const float* n = accumulator.normals.data() + 3 * (v - accumulator.min_vertex);
+                normals[3 * v] += n[0];
+                normals[3 * v + 1] += n[1];
+                normals[3 * v + 2] += n[2];
+            }
+        }
+        normalize(normals.data(), begin, end);
+    });
+}
+
+void generateSmoothNormalsSerial(const std::vector<float>& vertices, const std::vector<unsigned int>& indices, std::vector<float>& normals)
+/** Reference implementation for the benchmark: face normals are added to the three vertices of each triangle
+on one thread. */
+{
+    size_t triangle_count = indices.size() / 3;
+    normals.assign(vertices.size(), 0.0f);
+    float face_normal[3];
+    for (size_t t = 0; t < triangle_count; t++)
+    {
+        computeFaceNormals(vertices.data(), indices.data() + 3 * t, 0, 1, face_normal);
+        for (int corner = 0; corner < 3; corner++)
+        {
+            float* n = normals.data() + 3 * size_t(indices[3 * t + corner]);
+            n[0] += face_normal[0];
+            n[1] += face_normal[1];
+            n[2] += face_normal[2];
+        }
+    }
+    normalize(normals.data(), 0, vertices.size() / 3);
+}
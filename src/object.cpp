@@ -1,60 +1,978 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "../include/object.h"
 #include "../include/loader.h"
+#include "../include/config.h"
+#include "../include/meshlets.h"
+#include "../include/normals.h"
+#include "../include/parallel.h"
 #include "portable-file-dialogs.h"
 
+namespace
+{
+    void enableFillOffset()
+    /** Moves filled triangles slightly away from the viewer, so lines drawn over them are not hidden. With reversed depth
+    (see SceneFramebuffer) farther fragments have smaller depths, so the offset is negative. */
+    {
+        GLint depth_function = GL_LESS;
+        glGetIntegerv(GL_DEPTH_FUNC, &depth_function);
+        float offset = (depth_function == GL_GEQUAL || depth_function == GL_GREATER) ? -1.0f : 1.0f;
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(offset, offset);
+    }
+}
 
 void Object::loadObjectFile(const std::string& filepath)
-/**Loads vertices and indices from an .obj file using Loader class, calculates Object's bounding box and its diagonal length.
-If the loading fails, an error message is displayed.*/
+/** Starts loading an .obj file as a background task of the TaskScheduler and cancels the load started before, if it is
+still running. The current mesh is drawn until finishLoading() replaces it with the loaded one.*/
+{
+    cancelLoading();
+    load_token_ = CancellationToken();
+    loaded_mesh_ = std::make_shared<LoadedMesh>();
+    std::shared_ptr<LoadedMesh> mesh = loaded_mesh_;
+    CancellationToken token = load_token_;
+    load_task_ = TaskScheduler::instance().submit("Load .obj file", [filepath, token, mesh]() {
+        prepareMesh(filepath, token, *mesh);
+    }, kBackgroundPriority, token);
+}
+
+bool Object::finishLoading(bool wait)
+/** Replaces the mesh with the one loaded by the last loadObjectFile() call once its task is finished, or waits for it
+if wait is true. Uploads the buffers, so it is called with the OpenGL context current, on the thread drawing the Object.
+Returns true if the mesh was replaced. A failed load keeps the current mesh and leaves its error for takeLoadError(),
+unless the load was cancelled.*/
+{
+    if (!load_task_.valid())
+    {
+        return false;
+    }
+    if (wait)
+    {
+        load_task_.wait();
+    }
+    if (!load_task_.done())
+    {
+        return false;
+    }
+    std::shared_ptr<LoadedMesh> mesh = std::move(loaded_mesh_);
+    load_task_ = TaskHandle();
+    if (load_token_.isCancelled())
+    {
+        return false;
+    }
+    if (!mesh->loaded)
+    {
+        load_error_ = std::move(mesh->error);
+        return false;
+    }
+    installMesh(*mesh);
+    return true;
+}
+
+std::string Object::takeLoadError()
+/** Returns the error of the last failed load once, or an empty string. */
+{
+    std::string error;
+    error.swap(load_error_);
+    return error;
+}
+
+void Object::cancelLoading()
+/** Cancels the running load. Its task stops after the current stage and its result is discarded.*/
+{
+    load_token_.cancel();
+    load_task_ = TaskHandle();
+    loaded_mesh_.reset();
+}
+
+void Object::prepareMesh(const std::string& filepath, const CancellationToken& token, LoadedMesh& mesh)
+/** Runs on a worker: loads vertices, indices and normals from an .obj file using Loader class, generates normals if
+the file has none, splits shapes into meshlets, and builds the BVH used for picking, the vertex grid used for snapping,
+the feature edges and the bounding sphere used for framing the camera. The token is checked between the stages. If the loading fails, the error is stored in the mesh; no UI is shown from the
+worker.*/
+{
+    try
+    {
+        mesh.peak_load_bytes = ObjectLoader::loadObFileData(filepath, mesh.vertices, mesh.indices, mesh.shapes, mesh.normals);
+    }
+    catch(...)
+    {
+        mesh.error = "Error: Unable to load file '" + filepath + "'. Please check if the file exists and you have the necessary permissions to read it.";
+        return;
+    }
+    if (token.isCancelled())
+    {
+        return;
+    }
+    mesh.normals_report.from_file = !mesh.normals.empty();
+    if (mesh.normals.empty())
+    {
+        auto start = std::chrono::steady_clock::now();
+        generateSmoothNormals(mesh.vertices, mesh.indices, mesh.normals);
+        mesh.normals_report.generation_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (token.isCancelled())
+    {
+        return;
+    }
+
+    // Triangles are reordered inside their shapes to follow meshlets before anything refers to triangle positions.
+    mesh.meshlets.build(mesh.vertices, mesh.indices, mesh.shapes);
+    if (token.isCancelled())
+    {
+        return;
+    }
+    mesh.bvh.build(mesh.vertices, mesh.indices);
+    if (token.isCancelled())
+    {
+        return;
+    }
+    mesh.vertex_grid.build(mesh.vertices);
+    mesh.feature_edges.build(mesh.vertices, mesh.indices);
+    mesh.bounding_sphere = minimalBoundingSphere(mesh.vertices);
+    mesh.loaded = true;
+}
+
+void Object::installMesh(LoadedMesh& mesh)
+/** Replaces the mesh with a loaded one, calculates Object's bounding box and its diagonal length, uploads the buffers
+and starts the mesh analysis in the background. Boxes of the top BVH levels are kept for fitting the depth range.*/
 {
     rotation_[0] = 0;
     rotation_[1] = 0;
     rotation_[2] = 0;
 
+    releaseMesh();
+    streaming_octree_.close();
+    vertices_ = std::move(mesh.vertices);
+    indices_ = std::move(mesh.indices);
+    shapes_ = std::move(mesh.shapes);
+    normals_ = std::move(mesh.normals);
+    normals_report_ = mesh.normals_report;
+    meshlets_ = std::move(mesh.meshlets);
+    bvh_ = std::move(mesh.bvh);
+    vertex_grid_ = std::move(mesh.vertex_grid);
+    feature_edges_ = std::move(mesh.feature_edges);
+    bounding_sphere_ = mesh.bounding_sphere;
+    peak_load_bytes_ = mesh.peak_load_bytes;
+
+    bounding_box_ = calculateBoundingBox();
+    max_length_ = calculateObjectSize(bounding_box_);
+    part_boxes_.clear();
+    DepthBounds::collectBvhBoxes(bvh_, kPartBoxLevels, part_boxes_);
+    packIndices();
+    assignMeshletBatches();
+    uploadIndexBuffer();
+    uploadVertexBuffer();
+    edge_line_classes_ = 0;
+    silhouette_caches_.clear();
+    mesh_analyzer_.start(vertices_, indices_, shapes_.size());
+    version_++;
+}
+
+void Object::releaseMesh()
+/** Releases the mesh and the data derived from it. */
+{
+    // The analysis of the previous model may still read its vertices and indices, so they are handed over to it
+    // and freed when it stops, instead of waiting for it on the render thread.
+    mesh_analyzer_.release(vertices_, indices_);
+
+    bvh_.clear();
+    vertex_grid_.clear();
+    feature_edges_.clear();
+    meshlets_.clear();
+    meshlet_batches_.clear();
+    meshlet_batches_.shrink_to_fit();
     vertices_.clear();
+    vertices_.shrink_to_fit();
+    indices_.clear();
+    indices_.shrink_to_fit();
     shapes_.clear();
-    try
-    {
-        ObjectLoader::loadObFileData(filepath, vertices_, shapes_);
-    }
-    catch(...)
+    shapes_.shrink_to_fit();
+    normals_.clear();
+    normals_.shrink_to_fit();
+}
+
+void Object::openStreamingFile(const std::string& filepath)
+/** Replaces the loaded mesh with an octree file, whose nodes are loaded while drawing, as the current view needs them.
+The bounding box of the octree sets the Object's size and, since its vertices are not in memory, its bounding sphere
+is the sphere around the box. If the file cannot be opened, an error message is displayed.*/
+{
+    cancelLoading();
+    // The mesh is released only once the octree file has been read, so a file that cannot be opened keeps the current model.
+    if (!streaming_octree_.open(filepath))
     {
-        pfd::message("Problem", "Error: Unable to load file '" + filepath + "'. Please check if the file exists and you have the necessary permissions to read it.",
+        pfd::message("Problem", "Error: Unable to open octree file '" + filepath + "'.",
                      pfd::choice::ok, pfd::icon::error);
         return;
     }
-    BoundingBox bounding_box = calculateBoundingBox();
-    max_length_ = calculateObjectSize(bounding_box);
+    rotation_[0] = 0;
+    rotation_[1] = 0;
+    rotation_[2] = 0;
+
+    releaseMesh();
+    // Buffers of the mesh are emptied, so only the octree's nodes occupy GPU memory.
+    packIndices();
+    uploadIndexBuffer();
+    uploadVertexBuffer();
+    edge_line_count_ = 0;
+    edge_line_classes_ = 0;
+    silhouette_caches_.clear();
+    peak_load_bytes_ = 0;
+    version_++;
+
+    bounding_box_.min = streaming_octree_.boundsMin();
+    bounding_box_.max = streaming_octree_.boundsMax();
+    max_length_ = calculateObjectSize(bounding_box_);
+    bounding_sphere_.center = (bounding_box_.min + bounding_box_.max) * 0.5f;
+    bounding_sphere_.radius = max_length_ * 0.5f;
+    part_boxes_ = {bounds()};
 }
 
-void Object::draw()
-/** Renders an Object using OpenGL. */
+bool Object::saveStreamingFile(const std::string& filepath) const
+/** Writes the loaded mesh as an octree file for openStreamingFile().*/
 {
-    // glPolygonMode sets the polygon drawing mode, determining how polygons will be rasterized.
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    return StreamingOctree::writeFile(filepath, vertices_, indices_);
+}
 
+void Object::draw()
+/** Renders an Object using OpenGL, rotated by its rotation angles, in the mode selected in Config (see drawMesh). */
+{
     // Apply rotation along each axis.
     glRotatef(float(rotation_[0]), 1,0,0);
     glRotatef(float(rotation_[1]), 0,1,0);
     glRotatef(float(rotation_[2]), 0,0,1);
 
+    drawMesh();
+}
+
+void Object::drawMesh()
+/** Draws the mesh in the current modelview transform, as a wireframe of the edge classes selected in Config or, when
+solid shading is turned on, as lit filled triangles with a headlight. In hidden-line mode only visible feature and
+silhouette edges are drawn. A streaming octree is drawn as a triangle wireframe at the level of detail the view needs. */
+{
+    auto const& params = Config::getParameters();
+    if (streaming_octree_.isOpen())
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        glColor3f(1, 1, 1);
+        streaming_octree_.draw(params.streaming_error_pixels_, size_t(params.streaming_budget_mb_) << 20);
+        return;
+    }
+    if (params.solid_shading_)
+    {
+        drawSolid();
+        return;
+    }
+    if (params.hidden_line_)
+    {
+        drawHiddenLine();
+        return;
+    }
+
     // Set color to white
     glColor3f(1, 1, 1);
 
-    // Iterate though loaded shapes, where each shape contains a vector of indices.
-    for (auto const& shape : shapes_)
+    // Every edge is drawn once as a line, instead of twice as a side of both of its triangles in GL_LINE polygon mode.
+    updateEdgeLines(static_cast<uint8_t>(params.edge_classes_), params.crease_angle_);
+    drawEdgeLines();
+    edge_line_report_.edge_lines = edge_line_count_ / 2;
+    edge_line_report_.silhouette_lines = 0;
+    edge_line_report_.triangle_edges = indices_.size();
+}
+
+bool Object::drawsInstanced(InstanceRenderer& renderer) const
+/** Returns true if copies of the mesh are drawn with instanced calls: instancing is supported and turned on in Config,
+and the mesh is drawn neither in hidden-line nor in streaming mode. */
+{
+    auto const& params = Config::getParameters();
+    return params.instanced_rendering_ && !params.hidden_line_ && !streaming_octree_.isOpen() && renderer.available();
+}
+
+glm::mat4 Object::instanceDecode() const
+/** Returns the matrix decoding quantized positions, applied by each instance's model matrix, since the modelview
+matrix is shared by all instances. */
+{
+    if (!quantized_)
+    {
+        return glm::mat4(1.0f);
+    }
+    return glm::scale(glm::translate(glm::mat4(1.0f), quantization_center_), quantization_step_);
+}
+
+size_t Object::drawInstances(const std::vector<glm::mat4>& transforms, size_t first_instance, InstanceRenderer& renderer)
+/** Draws a copy of the mesh with each transform (applied on top of the current modelview matrix) and returns the number
+of draw calls. Wireframe and solid shading use one instanced call per index batch, reading the model matrices uploaded
+to the renderer from first_instance on (see drawsInstanced); otherwise every copy is drawn on its own.*/
+{
+    auto const& params = Config::getParameters();
+    if (transforms.empty())
+    {
+        return 0;
+    }
+    if (!drawsInstanced(renderer))
+    {
+        for (auto const& transform : transforms)
+        {
+            glPushMatrix();
+            glMultMatrixf(glm::value_ptr(transform));
+            drawMesh();
+            glPopMatrix();
+        }
+        return transforms.size() * (params.solid_shading_ ? index_batches_.size() : 1);
+    }
+
+    bool solid = params.solid_shading_;
+    auto instance_count = static_cast<GLsizei>(transforms.size());
+    size_t draw_calls = 0;
+    if (solid)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        enableFillOffset();
+    }
+    else
     {
-        int num_ind = static_cast<int>(shape.size());
+        updateEdgeLines(static_cast<uint8_t>(params.edge_classes_), params.crease_angle_);
+    }
+    glColor3f(1, 1, 1);
 
-        // Enables OpenGL to use the array of vertices specified later.
-        glEnableClientState(GL_VERTEX_ARRAY);
-        // glVertexPointer specifies the location and data format of an array of vertex coordinates to use when rendering
-        glVertexPointer(3, GL_FLOAT, 0, vertices_.data());
-        // Renders primitives from array data.
-        // Due to mode GL_TRIANGLES it draws triangles using the indices stored in a shape.
-        glDrawElements(GL_TRIANGLES, num_ind, GL_UNSIGNED_INT, shape.data());
-        glDisableClientState(GL_VERTEX_ARRAY);
+    renderer.begin(first_instance, solid);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if (solid)
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        for (auto const& batch : index_batches_)
+        {
+            drawIndexRange(batch, 0, batch.count, true, instance_count);
+            draw_calls++;
+        }
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+    }
+    else
+    {
+        glVertexPointer(3, quantized_ ? GL_SHORT : GL_FLOAT, 0, nullptr);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_line_buffer_);
+        glDrawElementsInstancedARB(GL_LINES, static_cast<GLsizei>(edge_line_count_), edge_line_type_, nullptr, instance_count);
+        draw_calls++;
     }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    renderer.end();
+    return draw_calls;
+}
+
+void Object::drawSolid()
+/** Draws lit filled triangles with a headlight. */
+{
+    // glPolygonMode sets the polygon drawing mode, determining how polygons will be rasterized.
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    // Set color to white
+    glColor3f(1, 1, 1);
+
+    // The light is positioned with an identity modelview matrix, so it shines from the camera.
+    const GLfloat light_direction[] = {0.0f, 0.0f, 1.0f, 0.0f};
+    glPushMatrix();
+    glLoadIdentity();
+    glLightfv(GL_LIGHT0, GL_POSITION, light_direction);
+    glPopMatrix();
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    // Both sides are lit, since orientation of triangles in OBJ files is not always consistent.
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+    glEnable(GL_COLOR_MATERIAL);
+    // Normals are scaled by the modelview matrix (object scaling, quantization), so they are renormalized.
+    glEnable(GL_NORMALIZE);
+    // Lines drawn over the solid object (selection, edges) must not be hidden by its faces.
+    enableFillOffset();
+
+    drawTriangles(true, Config::getParameters().meshlet_cone_culling_);
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_NORMALIZE);
+    glDisable(GL_COLOR_MATERIAL);
+    glDisable(GL_LIGHT0);
+    glDisable(GL_LIGHTING);
+}
+
+void Object::drawTriangles(bool with_normals, bool cone_culling)
+/** Draws filled triangles of all shapes, each batch with one call. With meshlet culling turned on in Config, only meshlets
+in the view frustum (and with cone_culling, only those that are not back-facing) are drawn, consecutive ones with one call;
+culling statistics are kept per viewport.
+Rotation of the Object is expected to be applied already.*/
+{
+    auto const& params = Config::getParameters();
+    if (!params.meshlet_culling_ || meshlets_.size() == 0)
+    {
+        beginDraw(with_normals);
+        for (auto const& batch : index_batches_)
+        {
+            drawIndexRange(batch, 0, batch.count, with_normals);
+        }
+        endDraw();
+        return;
+    }
+
+    glm::mat4 model_view, projection;
+    GLint viewport[4];
+    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(model_view));
+    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    visible_meshlets_.clear();
+    MeshletCullStats stats = meshlets_.cull(model_view, projection, cone_culling, visible_meshlets_);
+
+    size_t draw_calls = 0;
+    beginDraw(with_normals);
+    for (size_t i = 0; i < visible_meshlets_.size();)
+    {
+        uint32_t meshlet = visible_meshlets_[i];
+        size_t first = meshlets_.firstIndex(meshlet);
+        size_t count = meshlets_.indexCount(meshlet);
+        // Meshlets are consecutive ranges of indices_, so neighbouring visible meshlets of one batch are merged.
+        size_t next = i + 1;
+        while (next < visible_meshlets_.size() && visible_meshlets_[next] == visible_meshlets_[next - 1] + 1
+               && meshlet_batches_[visible_meshlets_[next]] == meshlet_batches_[meshlet])
+        {
+            count += meshlets_.indexCount(visible_meshlets_[next]);
+            next++;
+        }
+        auto const& batch = index_batches_[meshlet_batches_[meshlet]];
+        drawIndexRange(batch, first - batch.first_index, count, with_normals);
+        draw_calls++;
+        i = next;
+    }
+    endDraw();
+
+    // Reports of viewports not drawn recently are replaced first.
+    draw_count_++;
+    auto report = std::find_if(meshlet_reports_.begin(), meshlet_reports_.end(), [&](const MeshletReport& r) {
+        return std::equal(viewport, viewport + 4, r.viewport);
+    });
+    if (report == meshlet_reports_.end())
+    {
+        report = std::min_element(meshlet_reports_.begin(), meshlet_reports_.end(), [](const MeshletReport& a, const MeshletReport& b) {
+            return a.draw < b.draw;
+        });
+    }
+    std::copy(viewport, viewport + 4, report->viewport);
+    report->stats = stats;
+    report->draw_calls = draw_calls;
+    report->draw = draw_count_;
+}
+
+std::vector<Object::MeshletReport> Object::meshletReports() const
+/** Returns culling statistics of viewports drawn with meshlet culling during the last four draws. */
+{
+    std::vector<MeshletReport> reports;
+    for (auto const& report : meshlet_reports_)
+    {
+        if (report.draw > 0 && draw_count_ - report.draw < meshlet_reports_.size())
+        {
+            reports.push_back(report);
+        }
+    }
+    return reports;
+}
+
+void Object::assignMeshletBatches()
+/** Finds the index batch of every meshlet. Meshlets lie inside one shape, so they never span two batches.*/
+{
+    meshlet_batches_.resize(meshlets_.size());
+    for (size_t meshlet = 0; meshlet < meshlets_.size(); meshlet++)
+    {
+        auto batch = std::upper_bound(index_batches_.begin(), index_batches_.end(), size_t(meshlets_.firstIndex(meshlet)),
+                                      [](size_t offset, const IndexBatch& b) {return offset < b.first_index;});
+        meshlet_batches_[meshlet] = static_cast<uint32_t>(batch - index_batches_.begin() - 1);
+    }
+}
+
+void Object::drawHiddenLine()
+/** Draws the Object for engineering drawings: a depth-only pass of filled triangles pushed back by polygon offset,
+then boundary, crease and silhouette edges tested against that depth, so edges behind the Object are hidden. */
+{
+    // The viewer's position (or direction for orthogonal projection) in object coordinates decides which triangles
+    // face it. Orthogonal projection matrices have 1 in their bottom-right element.
+    glm::mat4 model_view, projection;
+    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(model_view));
+    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+    bool orthographic = projection[3][3] == 1.0f;
+    glm::mat4 inverse_model_view = glm::inverse(model_view);
+    glm::vec3 eye = orthographic ? glm::vec3(inverse_model_view * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f))
+                                 : glm::vec3(inverse_model_view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    enableFillOffset();
+    // Edges behind back-facing meshlets must stay hidden, so the depth pass never culls by orientation.
+    drawTriangles(false, false);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // Smooth edges are left out: silhouettes are the only smooth edges that outline the visible shape.
+    auto const& params = Config::getParameters();
+    updateEdgeLines(static_cast<uint8_t>(params.edge_classes_ & ~kSmoothEdge), params.crease_angle_);
+    const std::vector<uint32_t>& silhouette = silhouetteLines(eye, orthographic);
+
+    glColor3f(1, 1, 1);
+    drawEdgeLines();
+    // Silhouettes change with the view, so they are drawn from client memory.
+    beginDraw();
+    glVertexPointer(3, quantized_ ? GL_SHORT : GL_FLOAT, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDrawElements(GL_LINES, static_cast<GLsizei>(silhouette.size()), GL_UNSIGNED_INT, silhouette.data());
+    endDraw();
+
+    edge_line_report_.edge_lines = edge_line_count_ / 2;
+    edge_line_report_.silhouette_lines = silhouette.size() / 2;
+    edge_line_report_.triangle_edges = indices_.size();
+}
+
+void Object::updateEdgeLines(uint8_t edge_classes, float crease_angle)
+/** Classifies edges if the crease angle changed and uploads edges of the given classes into the edge line index buffer,
+if the classes or the angle changed since the last upload. Indices are stored in 16 bits when the Object has at most 65536 vertices.*/
+{
+    bool reclassify = crease_angle != feature_edges_.creaseAngle();
+    if (!reclassify && edge_classes == edge_line_classes_)
+    {
+        return;
+    }
+    if (reclassify)
+    {
+        feature_edges_.classify(crease_angle);
+    }
+    std::vector<uint32_t> line_indices;
+    feature_edges_.lineIndices(edge_classes, line_indices);
+
+    if (edge_line_buffer_ == 0)
+    {
+        glGenBuffers(1, &edge_line_buffer_);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_line_buffer_);
+    if (vertices_.size() / 3 <= 65536)
+    {
+        std::vector<GLushort> short_indices(line_indices.begin(), line_indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(short_indices.size() * sizeof(GLushort)), short_indices.data(), GL_STATIC_DRAW);
+        edge_line_type_ = GL_UNSIGNED_SHORT;
+    }
+    else
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(line_indices.size() * sizeof(uint32_t)), line_indices.data(), GL_STATIC_DRAW);
+        edge_line_type_ = GL_UNSIGNED_INT;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    edge_line_count_ = line_indices.size();
+    edge_line_classes_ = edge_classes;
+}
+
+void Object::drawEdgeLines() const
+/** Draws the edge line index buffer with one call. Rotation of the Object is expected to be applied already.*/
+{
+    // Line indices refer to all vertices, so the vertex array starts at the first vertex.
+    beginDraw();
+    glVertexPointer(3, quantized_ ? GL_SHORT : GL_FLOAT, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, edge_line_buffer_);
+    glDrawElements(GL_LINES, static_cast<GLsizei>(edge_line_count_), edge_line_type_, nullptr);
+    endDraw();
+}
+
+size_t Object::SilhouetteViewHash::operator()(const SilhouetteView& view) const
+{
+    std::hash<float> hash;
+    size_t seed = hash(view.eye.x);
+    seed = seed * 31 + hash(view.eye.y);
+    seed = seed * 31 + hash(view.eye.z);
+    return seed * 2 + (view.orthographic ? 1 : 0);
+}
+
+void Object::beginSilhouetteFrame(size_t views)
+/** Called once per frame with the number of views the Object is drawn in, i.e. its copies times the viewports.
+Drops silhouettes of views that were not drawn in the previous frame. */
+{
+    silhouette_views_ = std::max(kSilhouetteViews, views);
+    for (auto it = silhouette_caches_.begin(); it != silhouette_caches_.end();)
+    {
+        it = it->second.frame == silhouette_frame_ ? std::next(it) : silhouette_caches_.erase(it);
+    }
+    silhouette_frame_++;
+}
+
+const std::vector<uint32_t>& Object::silhouetteLines(const glm::vec3& eye, bool orthographic)
+/** Returns silhouette lines for the view, from the cache if the same view was drawn in this or the previous frame;
+otherwise they are extracted into a new cache entry. Copies seen from the same direction share one entry. */
+{
+    SilhouetteView view{eye, orthographic};
+    auto found = silhouette_caches_.find(view);
+    if (found != silhouette_caches_.end())
+    {
+        found->second.frame = silhouette_frame_;
+        return found->second.line_indices;
+    }
+
+    // More views than expected: silhouettes not drawn in this frame are dropped early.
+    if (silhouette_caches_.size() >= 2 * silhouette_views_)
+    {
+        for (auto it = silhouette_caches_.begin(); it != silhouette_caches_.end();)
+        {
+            it = it->second.frame == silhouette_frame_ ? std::next(it) : silhouette_caches_.erase(it);
+        }
+    }
+    SilhouetteCache& cache = silhouette_caches_[view];
+    cache.frame = silhouette_frame_;
+    feature_edges_.silhouetteEdges(eye, orthographic, cache.line_indices);
+    return cache.line_indices;
+}
+
+void Object::drawShapeIds() const
+/** Draws filled shapes, each in a color encoding its index + 1 in the red, green and blue bytes, so 0 is left for
+the background. Rotation of the Object is expected to be applied already, e.g. by the modelview matrix captured after draw().*/
+{
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    beginDraw();
+    for (size_t shape = 0; shape < shapes_.size(); shape++)
+    {
+        auto id = static_cast<uint32_t>(shape + 1);
+        glColor3ub(id & 0xff, (id >> 8) & 0xff, (id >> 16) & 0xff);
+        drawShapeElements(shape);
+    }
+    endDraw();
+}
+
+void Object::drawShapeHighlight(size_t shape) const
+/** Draws one shape over the Object in the highlight color. Expects the modelview matrix the Object was drawn with.*/
+{
+    if (shape >= shapes_.size())
+    {
+        return;
+    }
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glLineWidth(2.0f);
+    glColor3f(1.0f, 0.5f, 0.0f);
+    beginDraw();
+    drawShapeElements(shape);
+    endDraw();
+    glLineWidth(1.0f);
+}
+
+void Object::beginDraw(bool with_normals) const
+/** Binds vertex and index buffers and applies the transform decoding quantized positions.*/
+{
+    // Quantized positions are decoded by the vertex transform: translation to the center of the bounding box
+    // and scaling by the quantization step are applied on top of the current modelview matrix.
+    glPushMatrix();
+    if (quantized_)
+    {
+        glTranslatef(quantization_center_.x, quantization_center_.y, quantization_center_.z);
+        glScalef(quantization_step_.x, quantization_step_.y, quantization_step_.z);
+    }
+
+    // Vertices and indices are read from GPU buffers, pointers below are byte offsets into the bound buffers.
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+
+    // Enables OpenGL to use the array of vertices specified later.
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if (with_normals)
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+    }
+}
+
+void Object::endDraw() const
+{
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // Buffers are unbound, so following client-side arrays (e.g. ImGui) are not read from them.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glPopMatrix();
+}
+
+void Object::drawIndexRange(const IndexBatch& batch, size_t first, size_t count, bool with_normals, GLsizei instances) const
+/** Draws count indices of a batch starting at its first-th index, or that many instances of them if instances is not 0.
+For batches with 16-bit indices the vertex array starts at the batch's base vertex, since their indices are stored relative to it.*/
+{
+    GLenum vertex_type = quantized_ ? GL_SHORT : GL_FLOAT;
+    size_t vertex_size = quantized_ ? 3 * sizeof(GLshort) : 3 * sizeof(GLfloat);
+    size_t index_size = batch.index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+    if (with_normals)
+    {
+        // Normals are stored in their own buffer; the array pointer refers to the buffer bound when it is set.
+        glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
+        glNormalPointer(GL_FLOAT, 0, reinterpret_cast<const void*>(batch.base_vertex * 3 * sizeof(GLfloat)));
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    }
+    // glVertexPointer specifies the location and data format of an array of vertex coordinates to use when rendering
+    glVertexPointer(3, vertex_type, 0, reinterpret_cast<const void*>(batch.base_vertex * vertex_size));
+    // Renders primitives from array data.
+    // Due to mode GL_TRIANGLES it draws triangles using the indices stored in a batch.
+    const void* indices = reinterpret_cast<const void*>(batch.byte_offset + first * index_size);
+    if (instances > 0)
+    {
+        glDrawElementsInstancedARB(GL_TRIANGLES, static_cast<GLsizei>(count), batch.index_type, indices, instances);
+        return;
+    }
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count), batch.index_type, indices);
+}
+
+void Object::drawShapeElements(size_t shape) const
+/** Draws one shape from the batch containing it. Batches are ordered by their first index in indices_.*/
+{
+    auto const& range = shapes_[shape];
+    if (range.count == 0)
+    {
+        return;
+    }
+    auto batch = std::upper_bound(index_batches_.begin(), index_batches_.end(), range.offset,
+                                  [](size_t offset, const IndexBatch& b) {return offset < b.first_index;});
+    if (batch == index_batches_.begin())
+    {
+        return;
+    }
+    --batch;
+    drawIndexRange(*batch, range.offset - batch->first_index, range.count);
+}
+
+void Object::releaseBuffers()
+/** Deletes the GPU buffers of the Object, before an Object that is no longer drawn is destroyed. Needs the OpenGL context. */
+{
+    GLuint buffers[] = {vertex_buffer_, index_buffer_, normal_buffer_, edge_line_buffer_};
+    glDeleteBuffers(4, buffers);
+    vertex_buffer_ = index_buffer_ = normal_buffer_ = edge_line_buffer_ = 0;
+    vertex_buffer_bytes_ = index_buffer_bytes_ = normal_buffer_bytes_ = 0;
+    edge_line_count_ = 0;
+    edge_line_classes_ = 0;
+}
+
+void Object::uploadIndexBuffer()
+/** Uploads packed indices into a GPU buffer and releases their CPU copy.*/
+{
+    if (index_buffer_ == 0)
+    {
+        glGenBuffers(1, &index_buffer_);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed_indices_.size()), packed_indices_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    index_buffer_bytes_ = packed_indices_.size();
+    packed_indices_.clear();
+    packed_indices_.shrink_to_fit();
+}
+
+void Object::uploadVertexBuffer()
+/** Uploads vertex positions into a GPU buffer, either as 32-bit floats or, when quantization is turned on in Config,
+as 16-bit integers relative to the bounding box, and normals into their own buffer. Called after loading and whenever the quantization setting changes.*/
+{
+    if (vertex_buffer_ == 0)
+    {
+        glGenBuffers(1, &vertex_buffer_);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+
+    quantized_ = Config::getParameters().quantize_positions_;
+    if (quantized_)
+    {
+        std::vector<GLshort> quantized_vertices = quantizePositions();
+        vertex_buffer_bytes_ = quantized_vertices.size() * sizeof(GLshort);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_buffer_bytes_), quantized_vertices.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        vertex_buffer_bytes_ = vertices_.size() * sizeof(GLfloat);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertex_buffer_bytes_), vertices_.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadNormalBuffer();
+}
+
+void Object::uploadNormalBuffer()
+/** Uploads normals into a GPU buffer. With quantized positions the modelview matrix also scales normals by the inverse
+of the quantization step, so normals are uploaded multiplied by the step to cancel it out.*/
+{
+    if (normal_buffer_ == 0)
+    {
+        glGenBuffers(1, &normal_buffer_);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, normal_buffer_);
+    normal_buffer_bytes_ = normals_.size() * sizeof(GLfloat);
+    if (quantized_)
+    {
+        std::vector<GLfloat> scaled_normals(normals_.size());
+        for (size_t i = 0; i < normals_.size(); i++)
+        {
+            scaled_normals[i] = normals_[i] * quantization_step_[static_cast<int>(i % 3)];
+        }
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(normal_buffer_bytes_), scaled_normals.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(normal_buffer_bytes_), normals_.data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::vector<GLshort> Object::quantizePositions()
+/** Packs each coordinate into a 16-bit integer q = round((v - center) / step), where center is the center of the bounding
+box and step maps the half-extent of the box on each axis to 32767. Stores the maximum distance between an original
+and a decoded position as the quantization error.*/
+{
+    const float max_quantized = 32767.0f;
+
+    quantization_center_ = (bounding_box_.min + bounding_box_.max) * 0.5f;
+    glm::vec3 half_extent = (bounding_box_.max - bounding_box_.min) * 0.5f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        quantization_step_[axis] = half_extent[axis] > 0 ? half_extent[axis] / max_quantized : 1.0f;
+    }
+
+    std::vector<GLshort> quantized_vertices(vertices_.size());
+    float max_error_squared = 0;
+    for (size_t i = 0; i < vertices_.size(); i += 3)
+    {
+        float error_squared = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float q = std::round((vertices_[i + axis] - quantization_center_[axis]) / quantization_step_[axis]);
+            q = std::max(-max_quantized, std::min(max_quantized, q));
+            quantized_vertices[i + axis] = static_cast<GLshort>(q);
+
+            float decoded = quantization_center_[axis] + q * quantization_step_[axis];
+            error_squared += (decoded - vertices_[i + axis]) * (decoded - vertices_[i + axis]);
+        }
+        max_error_squared = std::max(max_error_squared, error_squared);
+    }
+    quantization_error_ = std::sqrt(max_error_squared);
+    return quantized_vertices;
+}
+
+Object::QuantizationReport Object::quantizationReport() const
+/** Returns the error of the last quantization and sizes of vertex positions in both storage modes.*/
+{
+    QuantizationReport report;
+    report.max_error = quantization_error_;
+    report.float_bytes = vertices_.size() * sizeof(GLfloat);
+    report.quantized_bytes = vertices_.size() * sizeof(GLshort);
+    return report;
+}
+
+void Object::packIndices()
+/** Index-width selection stage. Groups consecutive shapes into batches whose indices span fewer than 65,536 vertices;
+such batches are stored as 16-bit indices relative to the lowest vertex of the batch. A shape spanning more vertices
+is stored with 32-bit indices, merged with neighbouring 32-bit shapes.*/
+{
+    const unsigned int short_index_limit = 65536;
+
+    packed_indices_.clear();
+    index_batches_.clear();
+
+    size_t shape_i = 0;
+    while (shape_i < shapes_.size())
+    {
+        // Extend the batch with following shapes while the vertex span stays addressable with 16 bits.
+        unsigned int batch_min = UINT_MAX, batch_max = 0;
+        size_t batch_end = shape_i;
+        while (batch_end < shapes_.size())
+        {
+            auto const& shape = shapes_[batch_end];
+            unsigned int shape_min = batch_min, shape_max = batch_max;
+            for (size_t i = shape.offset; i < shape.offset + shape.count; i++)
+            {
+                shape_min = std::min(shape_min, indices_[i]);
+                shape_max = std::max(shape_max, indices_[i]);
+            }
+            if (shape_min != UINT_MAX && shape_max - shape_min >= short_index_limit)
+            {
+                break;
+            }
+            batch_min = shape_min;
+            batch_max = shape_max;
+            batch_end++;
+        }
+
+        if (batch_end == shape_i)
+        {
+            auto const& shape = shapes_[shape_i];
+            appendIndexBatch(shape.offset, shape.count, GL_UNSIGNED_INT, 0);
+            shape_i++;
+            continue;
+        }
+
+        size_t first_index = shapes_[shape_i].offset;
+        size_t count = shapes_[batch_end - 1].offset + shapes_[batch_end - 1].count - first_index;
+        appendIndexBatch(first_index, count, GL_UNSIGNED_SHORT, batch_min == UINT_MAX ? 0 : batch_min);
+        shape_i = batch_end;
+    }
+    packed_indices_.shrink_to_fit();
+}
+
+void Object::appendIndexBatch(size_t first_index, size_t count, GLenum index_type, unsigned int base_vertex)
+/** Appends indices [first_index, first_index + count) to the packed index array in the given width.
+32-bit indices directly following another 32-bit batch extend it instead of creating a new draw call.*/
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (index_type == GL_UNSIGNED_INT)
+    {
+        if (!index_batches_.empty() && index_batches_.back().index_type == GL_UNSIGNED_INT)
+        {
+            index_batches_.back().count += count;
+        }
+        else
+        {
+            // 32-bit indices are kept 4-byte aligned after preceding 16-bit batches.
+            packed_indices_.resize((packed_indices_.size() + 3) & ~size_t(3));
+            index_batches_.push_back({GL_UNSIGNED_INT, packed_indices_.size(), count, 0, first_index});
+        }
+        size_t byte_offset = packed_indices_.size();
+        packed_indices_.resize(byte_offset + count * sizeof(uint32_t));
+        auto* destination = reinterpret_cast<uint32_t*>(packed_indices_.data() + byte_offset);
+        std::copy(indices_.begin() + first_index, indices_.begin() + first_index + count, destination);
+    }
+    else
+    {
+        index_batches_.push_back({GL_UNSIGNED_SHORT, packed_indices_.size(), count, base_vertex, first_index});
+        size_t byte_offset = packed_indices_.size();
+        packed_indices_.resize(byte_offset + count * sizeof(uint16_t));
+        auto* destination = reinterpret_cast<uint16_t*>(packed_indices_.data() + byte_offset);
+        for (size_t i = 0; i < count; i++)
+        {
+            destination[i] = static_cast<uint16_t>(indices_[first_index + i] - base_vertex);
+        }
+    }
+}
+
+Object::IndexPackingReport Object::indexPackingReport() const
+/** Counts batches by index width and compares submitted index bytes with 32-bit indices only.*/
+{
+    IndexPackingReport report;
+    for (auto const& batch : index_batches_)
+    {
+        if (batch.index_type == GL_UNSIGNED_SHORT)
+        {
+            report.short_batches++;
+            report.packed_bytes += batch.count * sizeof(uint16_t);
+        }
+        else
+        {
+            report.int_batches++;
+            report.packed_bytes += batch.count * sizeof(uint32_t);
+        }
+    }
+    report.full_bytes = indices_.size() * sizeof(uint32_t);
+    return report;
 }
 
 Object::BoundingBox Object::calculateBoundingBox()
@@ -99,4 +1017,65 @@ ensuring the rotation angle stays within 0-359 degrees.*/
 {
     rotation_[i] += 90 * direction;
     rotation_[i] = (rotation_[i] % 360 + 360) % 360;
-}
\ No newline at end of file
+}
+
+glm::mat4 Object::rotation() const
+/** Returns the rotation applied by draw(): along X, then Y, then Z. */
+{
+    glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(float(rotation_[0])), glm::vec3(1, 0, 0));
+    rotation = glm::rotate(rotation, glm::radians(float(rotation_[1])), glm::vec3(0, 1, 0));
+    return glm::rotate(rotation, glm::radians(float(rotation_[2])), glm::vec3(0, 0, 1));
+}
+
+BoundingSphere Object::shapeBoundingSphere(size_t shape) const
+/** Computes the smallest sphere containing the vertices of a shape, in object coordinates. */
+{
+    if (shape >= shapes_.size())
+    {
+        return {};
+    }
+    return minimalBoundingSphere(vertices_, indices_, shapes_[shape].offset, shapes_[shape].count);
+}
+
+MemoryStats Object::memoryStats() const
+/** Collects memory used by the Object: vertices, indices of all shapes, normals, shape table, GPU buffers,
+and the peak of the last load. Nothing is submitted from client memory, since vertices and indices are stored in GPU buffers.*/
+{
+    MemoryStats stats;
+    stats.vertex_bytes = vectorBytes(vertices_);
+    stats.index_bytes = vectorBytes(indices_);
+    stats.normal_bytes = vectorBytes(normals_);
+    stats.cache_bytes = vectorBytes(shapes_) + vectorBytes(packed_indices_) + vectorBytes(index_batches_) + bvh_.memoryBytes()
+                        + vertex_grid_.memoryBytes() + feature_edges_.memoryBytes() + streaming_octree_.memoryBytes()
+                        + meshlets_.memoryBytes() + vectorBytes(meshlet_batches_) + vectorBytes(visible_meshlets_);
+    for (auto const& cache : silhouette_caches_)
+    {
+        stats.cache_bytes += vectorBytes(cache.second.line_indices);
+    }
+    for (auto const& shape : shapes_)
+    {
+        stats.cache_bytes += shape.name.capacity();
+    }
+    stats.gpu_bytes = vertex_buffer_bytes_ + index_buffer_bytes_ + normal_buffer_bytes_
+                      + edge_line_count_ * (edge_line_type_ == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(uint32_t));
+    stats.gpu_bytes += streaming_octree_.statistics().resident_bytes;
+    stats.peak_load_bytes = peak_load_bytes_;
+    return stats;
+}
+
+Object::NormalsBenchmark Object::benchmarkNormals() const
+/** Measures generation of normals for the loaded mesh with the serial and the parallel implementation.*/
+{
+    NormalsBenchmark result;
+    std::vector<GLfloat> normals;
+
+    auto start = std::chrono::steady_clock::now();
+    generateSmoothNormalsSerial(vertices_, indices_, normals);
+    result.serial_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    generateSmoothNormals(vertices_, indices_, normals);
+    result.parallel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.threads = workerCount();
+    return result;
+}
@@ -0,0 +1,44 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "../include/parallel.h"
+#include "../include/task_scheduler.h"
+
+size_t workerCount()
+/** Returns the number of hardware threads, at least 1. The value is queried once, since the query reads system files. */
+{
+    static const size_t worker_count = std::max(1u, std::thread::hardware_concurrency());
+    return worker_count;
+}
+
+void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body, size_t min_chunk)
+/** Splits the range [0, count) into one chunk per worker (but not smaller than min_chunk) and submits the chunks to
+the TaskScheduler with the priority of the calling task. The calling thread processes the first chunk and helps with
+the rest while it waits, so parallelFor may be called from tasks. Returns when all chunks are processed. */
+{
+    size_t chunks = std::min(workerCount(), (count + min_chunk - 1) / std::max<size_t>(min_chunk, 1));
+    if (chunks <= 1)
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    TaskPriority priority = TaskScheduler::currentPriority();
+    size_t chunk_size = (count + chunks - 1) / chunks;
+    std::vector<TaskHandle> handles;
+    for (size_t begin = chunk_size; begin < count; begin += chunk_size)
+    {
+        size_t end = std::min(count, begin + chunk_size);
+        handles.push_back(scheduler.submit("parallelFor", [&body, begin, end](){body(begin, end);}, priority));
+    }
+    body(0, std::min(count, chunk_size));
+
+    for (auto& handle : handles)
+    {
+        handle.wait();
+    }
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include "../include/render_thread.h"
+
+
+void RenderThread::start(GLFWwindow* window, FrameFunction draw_frame)
+/** Starts the render thread. The window's OpenGL context must not be current on the calling thread, since the
+render thread makes it current on its own. */
+{
+    if (thread_.joinable())
+    {
+        return;
+    }
+    window_ = window;
+    draw_frame_ = std::move(draw_frame);
+    stop_ = false;
+    thread_ = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop()
+/** Draws the submitted snapshot, if any, and stops the render thread. The OpenGL context is released,
+so it can be made current on the calling thread again. */
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void RenderThread::submit(std::unique_ptr<FrameSnapshot> snapshot)
+/** Passes the snapshot of the next frame to the render thread. If the previous snapshot has not been taken yet,
+it is replaced, so the render thread always draws the latest state. */
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot->frame = ++submitted_frames_;
+        if (pending_)
+        {
+            // The replaced frame is counted as drawn, so waitForFrameData does not wait for it.
+            drawn_frames_ = pending_->frame;
+        }
+        pending_ = std::move(snapshot);
+    }
+    condition_.notify_all();
+}
+
+void RenderThread::waitForFrameData()
+/** Blocks until the render thread has drawn the scene and UI of the last submitted snapshot. After that the main thread
+may change the scene and start the next ImGui frame while the render thread swaps buffers. */
+{
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]{return drawn_frames_ == submitted_frames_ || !thread_.joinable();});
+    statistics_.wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderThread::post(std::function<void()> task, RenderTaskStage stage)
+/** Runs a task on the thread owning the OpenGL context: before or after drawing the next submitted frame,
+or immediately if the render thread is not running. */
+{
+    if (!thread_.joinable())
+    {
+        task();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    (stage == kBeforeFrame ? tasks_before_ : tasks_after_).push_back(std::move(task));
+}
+
+RenderThread::Statistics RenderThread::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return statistics_;
+}
+
+void RenderThread::run()
+{
+    glfwMakeContextCurrent(window_);
+    while (true)
+    {
+        std::unique_ptr<FrameSnapshot> snapshot;
+        std::vector<std::function<void()>> tasks_before;
+        std::vector<std::function<void()>> tasks_after;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{return pending_ || stop_;});
+            if (!pending_)
+            {
+                break;
+            }
+            snapshot = std::move(pending_);
+            tasks_before.swap(tasks_before_);
+            tasks_after.swap(tasks_after_);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Config::useSnapshot(snapshot->config);
+        for (auto const& task : tasks_before)
+        {
+            task();
+        }
+        draw_frame_(*snapshot);
+        for (auto const& task : tasks_after)
+        {
+            task();
+        }
+        Config::useSnapshot(nullptr);
+        auto drawn = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drawn_frames_ = std::max(drawn_frames_, snapshot->frame);
+        }
+        condition_.notify_all();
+
+        glfwSwapBuffers(window_);
+        auto swapped = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics_.frames++;
+        statistics_.draw_ms = std::chrono::duration<double, std::milli>(drawn - start).count();
+        statistics_.swap_ms = std::chrono::duration<double, std::milli>(swapped - drawn).count();
+    }
+    glfwMakeContextCurrent(nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    drawn_frames_ = submitted_frames_;
+    condition_.notify_all();
+}
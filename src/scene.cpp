@@ -0,0 +1,222 @@
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include "../include/scene.h"
+#include "../include/config.h"
+
+
+void Scene::addMesh(const std::string& filepath, int copies)
+/** Starts loading an .obj file as a new mesh of the scene without waiting for it. finishLoading() adds the mesh and a
+grid of copies of it once the load task is finished. */
+{
+    PendingMesh pending;
+    pending.mesh = std::make_shared<Object>();
+    pending.mesh->loadObjectFile(filepath);
+    pending.copies = copies;
+    pending_meshes_.push_back(std::move(pending));
+}
+
+void Scene::finishLoading()
+/** Called by the render thread at the start of a frame: replaces the primary Object with a mesh loaded in the
+background and adds the meshes of finished addMesh calls with their copies. Errors of failed loads are kept for
+takeLoadError(). */
+{
+    meshes_[0]->finishLoading();
+    for (size_t i = 0; i < pending_meshes_.size();)
+    {
+        PendingMesh& pending = pending_meshes_[i];
+        if (pending.mesh->isLoading())
+        {
+            i++;
+            continue;
+        }
+        if (pending.mesh->finishLoading() && !pending.mesh->indices().empty())
+        {
+            meshes_.push_back(pending.mesh);
+            addGrid(meshes_.size() - 1, pending.copies);
+        }
+        else if (load_error_.empty())
+        {
+            load_error_ = pending.mesh->takeLoadError();
+        }
+        pending_meshes_.erase(pending_meshes_.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+}
+
+bool Scene::isLoading() const
+/** Returns true while the primary Object or a mesh added by addMesh is being loaded. */
+{
+    if (meshes_[0]->isLoading())
+    {
+        return true;
+    }
+    for (auto const& pending : pending_meshes_)
+    {
+        if (pending.mesh->isLoading())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Scene::takeLoadError()
+/** Returns the error of a failed load of the primary Object or of a mesh added by addMesh once, or an empty string. */
+{
+    std::string error = meshes_[0]->takeLoadError();
+    if (error.empty())
+    {
+        error.swap(load_error_);
+    }
+    return error;
+}
+
+size_t Scene::addInstance(const Instance& instance)
+/** Adds an instance of an existing mesh and returns its index. */
+{
+    if (instance.mesh >= meshes_.size())
+    {
+        return instances_.size();
+    }
+    instances_.push_back(instance);
+    return instances_.size() - 1;
+}
+
+void Scene::addGrid(size_t mesh, int count)
+/** Adds count instances of a mesh on a square grid in the XZ plane next to the primary Object, spaced by the larger of
+the two meshes' sizes. Copies of other meshes are scaled to the size of the primary Object.*/
+{
+    if (mesh >= meshes_.size() || count <= 0)
+    {
+        return;
+    }
+    float primary_size = meshes_[0]->size();
+    float mesh_size = meshes_[mesh]->size();
+    float scale = (mesh == 0 || mesh_size <= 0) ? 1.0f : primary_size / mesh_size;
+    float spacing = primary_size > 0 ? primary_size : 1.0f;
+
+    auto columns = static_cast<int>(std::ceil(std::sqrt(float(count))));
+    size_t first = instances_.size();
+    for (int i = 0; i < count; i++)
+    {
+        Instance instance;
+        instance.mesh = mesh;
+        instance.scale = scale;
+        // Cells start one row in front of the primary Object, so no copy overlaps it.
+        instance.position = glm::vec3(float(i % columns - columns / 2) * spacing, 0.0f,
+                                      float(i / columns + 1) * spacing);
+        instances_.push_back(instance);
+    }
+    // Grids added later are placed behind the previous ones.
+    for (size_t i = first; i < instances_.size(); i++)
+    {
+        instances_[i].position.z += float(first / size_t(columns)) * spacing;
+    }
+}
+
+void Scene::removeInstance(size_t index)
+{
+    if (index < instances_.size())
+    {
+        instances_.erase(instances_.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+}
+
+void Scene::clearInstances()
+/** Removes all instances and the meshes other than the primary Object, and cancels the meshes still being loaded. */
+{
+    pending_meshes_.clear();
+    instances_.clear();
+    for (size_t mesh = 1; mesh < meshes_.size(); mesh++)
+    {
+        meshes_[mesh]->releaseBuffers();
+    }
+    meshes_.resize(1);
+    transforms_.clear();
+    instance_models_.clear();
+    first_instance_.clear();
+    statistics_ = Statistics();
+}
+
+void Scene::release()
+/** Removes all instances and deletes the GPU resources of the instance renderer. Needs the OpenGL context. */
+{
+    clearInstances();
+    renderer_.release();
+}
+
+glm::mat4 Scene::instanceTransform(const Instance& instance)
+/** Returns the model matrix of an instance in the coordinates of the primary Object. */
+{
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), instance.position);
+    transform = glm::rotate(transform, glm::radians(float(instance.rotation[0])), glm::vec3(1, 0, 0));
+    transform = glm::rotate(transform, glm::radians(float(instance.rotation[1])), glm::vec3(0, 1, 0));
+    transform = glm::rotate(transform, glm::radians(float(instance.rotation[2])), glm::vec3(0, 0, 1));
+    return glm::scale(transform, glm::vec3(instance.scale));
+}
+
+BoundingSphere Scene::boundingSphere() const
+/** Returns a sphere containing the rotated primary Object and all instances, in the coordinates of the primary Object.
+It is merged from the spheres the meshes computed when they were loaded, so it is not the smallest possible one. */
+{
+    const Object& primary = *meshes_[0];
+    BoundingSphere sphere = primary.boundingSphere().transformed(primary.rotation(), 1.0f);
+    for (auto const& instance : instances_)
+    {
+        sphere = mergeSpheres(sphere, meshes_[instance.mesh]->boundingSphere().transformed(instanceTransform(instance),
+                                                                                           std::abs(instance.scale)));
+    }
+    return sphere;
+}
+
+void Scene::prepareInstances(size_t viewports)
+/** Groups the instance transforms by mesh and uploads the model matrices of the meshes drawn with instanced calls.
+Called once per frame, before drawInstances is called in each viewport. Each mesh is told how many views it is drawn
+in, so silhouettes of all of its copies stay cached in hidden-line mode. */
+{
+    transforms_.resize(meshes_.size());
+    for (auto& transforms : transforms_)
+    {
+        transforms.clear();
+    }
+    for (auto const& instance : instances_)
+    {
+        transforms_[instance.mesh].push_back(instanceTransform(instance));
+    }
+
+    instance_models_.clear();
+    first_instance_.assign(meshes_.size(), 0);
+    for (size_t mesh = 0; mesh < meshes_.size(); mesh++)
+    {
+        // The primary Object is drawn once more by itself.
+        meshes_[mesh]->beginSilhouetteFrame((transforms_[mesh].size() + (mesh == 0 ? 1 : 0)) * viewports);
+        first_instance_[mesh] = instance_models_.size();
+        if (transforms_[mesh].empty() || !meshes_[mesh]->drawsInstanced(renderer_))
+        {
+            continue;
+        }
+        glm::mat4 decode = meshes_[mesh]->instanceDecode();
+        for (auto const& transform : transforms_[mesh])
+        {
+            instance_models_.push_back(transform * decode);
+        }
+    }
+    if (!instance_models_.empty())
+    {
+        renderer_.upload(instance_models_);
+    }
+
+    statistics_ = Statistics();
+    statistics_.meshes = meshes_.size();
+    statistics_.instances = instances_.size();
+    statistics_.instanced = Config::getParameters().instanced_rendering_ && renderer_.available();
+}
+
+void Scene::drawInstances()
+/** Draws all instances prepared for the frame on top of the current modelview matrix, grouped by mesh, so each mesh is
+drawn with its own instanced calls. */
+{
+    for (size_t mesh = 0; mesh < transforms_.size(); mesh++)
+    {
+        statistics_.draw_calls += meshes_[mesh]->drawInstances(transforms_[mesh], first_instance_[mesh], renderer_);
+    }
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include "../include/scene_framebuffer.h"
+
+bool SceneFramebuffer::supported()
+/** Returns true if the depth range can be set to zero to one. Floating-point depth buffers are core since OpenGL 3.0. */
+{
+    return GLEW_VERSION_4_5 || GLEW_ARB_clip_control;
+}
+
+bool SceneFramebuffer::resize(int width, int height)
+/** Creates the framebuffer with color and floating-point depth renderbuffers of the window size. Returns false if
+the framebuffer is not supported. */
+{
+    if (framebuffer_ != 0 && width == width_ && height == height_)
+    {
+        return true;
+    }
+    release();
+
+    glGenFramebuffers(1, &framebuffer_);
+    glGenRenderbuffers(1, &color_buffer_);
+    glGenRenderbuffers(1, &depth_buffer_);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Scene framebuffer is incomplete: " << status << std::endl;
+        release();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+bool SceneFramebuffer::begin(int width, int height)
+/** Binds the framebuffer and switches to reversed depth: depth is cleared to 0 and the zero-to-one depth range is used.
+Returns false, leaving the default framebuffer bound, if reversed depth is not supported. */
+{
+    if (!supported() || width <= 0 || height <= 0 || !resize(width, height))
+    {
+        return false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+    glClearDepth(0.0);
+    return true;
+}
+
+void SceneFramebuffer::end() const
+/** Restores the default depth range, clear value and depth test, and copies the color of the scene to the default
+framebuffer. */
+{
+    glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+    glClearDepth(1.0);
+    glDepthFunc(GL_LEQUAL);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SceneFramebuffer::release()
+{
+    if (framebuffer_ != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer_);
+        glDeleteRenderbuffers(1, &color_buffer_);
+        glDeleteRenderbuffers(1, &depth_buffer_);
+    }
+    framebuffer_ = color_buffer_ = depth_buffer_ = 0;
+    width_ = height_ = 0;
+}
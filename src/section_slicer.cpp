@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "../include/section_slicer.h"
+#include "../include/edge_table.h"
+
+namespace
+{
+    struct SectionPoint
+    /** Intersection of the plane with a mesh edge and the (at most two, on a manifold edge) segments ending in it. */
+    {
+        glm::vec3 point;
+        int segments[2] = {-1, -1};
+    };
+
+    struct Segment
+    {
+        uint64_t ends[2];
+        bool visited{false};
+    };
+}
+
+void SectionSlicer::clear()
+{
+    valid_ = false;
+    points_.clear();
+    contours_.clear();
+    statistics_ = Statistics();
+}
+
+void SectionSlicer::update(const Object& object, const glm::vec3& normal, float position)
+/** Slices the Object with the plane of the given normal; position moves the plane from the lowest (0) to the highest (1)
+point of the Object's bounding box along the normal. Does nothing if the cached contours belong to the same plane. */
+{
+    if (object.bvh().empty())
+    {
+        clear();
+        return;
+    }
+    if (valid_ && normal == normal_ && position == position_ && object.version() == object_version_)
+    {
+        return;
+    }
+
+    // Projections of the bounding box corners onto the normal give the range of plane distances crossing the Object.
+    const Bvh::Node& root = object.bvh().nodes()[0];
+    glm::vec3 center = (root.min + root.max) * 0.5f;
+    float radius = glm::dot(glm::abs(normal), (root.max - root.min) * 0.5f);
+    float distance = glm::dot(normal, center) + (2.0f * position - 1.0f) * radius;
+
+    auto start = std::chrono::steady_clock::now();
+    slice(object, normal, distance);
+    statistics_.time_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    valid_ = true;
+    normal_ = normal;
+    position_ = position;
+    object_version_ = object.version();
+}
+
+void SectionSlicer::slice(const Object& object, const glm::vec3& normal, float distance)
+/** Intersects candidate triangles with the plane and chains segments through shared edge points.
+Vertices lying exactly on the plane are treated as being above it, so every crossed triangle yields exactly
+one segment between two of its edges. */
+{
+    statistics_ = Statistics();
+    triangles_.clear();
+    points_.clear();
+    contours_.clear();
+    statistics_.visited_nodes = object.bvh().queryPlane(normal, distance, triangles_);
+    statistics_.tested_triangles = triangles_.size();
+
+    auto const& indices = object.indices();
+    std::unordered_map<uint64_t, SectionPoint> section_points;
+    section_points.reserve(triangles_.size());
+    std::vector<Segment> segments;
+
+    for (uint32_t triangle : triangles_)
+    {
+        unsigned int corners[3] = {indices[3 * size_t(triangle)], indices[3 * size_t(triangle) + 1], indices[3 * size_t(triangle) + 2]};
+        float distances[3];
+        for (int i = 0; i < 3; i++)
+        {
+            distances[i] = glm::dot(normal, object.vertex(corners[i])) - distance;
+        }
+
+        Segment segment;
+        int ends = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3;
+            if ((distances[i] >= 0) == (distances[j] >= 0))
+            {
+                continue;
+            }
+            uint64_t key = EdgeTable::edgeKey(corners[i], corners[j]);
+            auto inserted = section_points.insert({key, SectionPoint()});
+            SectionPoint& section_point = inserted.first->second;
+            if (inserted.second)
+            {
+                // The point is computed from the edge in its key order, so both triangles sharing the edge get the same point.
+                unsigned int a = EdgeTable::firstVertex(key), b = EdgeTable::secondVertex(key);
+                float distance_a = a == corners[i] ? distances[i] : distances[j];
+                float distance_b = a == corners[i] ? distances[j] : distances[i];
+                section_point.point = object.vertex(a) + (object.vertex(b) - object.vertex(a)) * (distance_a / (distance_a - distance_b));
+            }
+            int slot = section_point.segments[0] < 0 ? 0 : 1;
+            section_point.segments[slot] = static_cast<int>(segments.size());
+            segment.ends[ends++] = key;
+        }
+        if (ends == 2)
+        {
+            segments.push_back(segment);
+        }
+    }
+    statistics_.segments = segments.size();
+
+    // Follows segments from an end point until the chain closes or reaches a point with no unvisited segment.
+    auto follow = [&](uint64_t key, std::vector<glm::vec3>& chain) {
+        while (true)
+        {
+            const SectionPoint& section_point = section_points[key];
+            int next = -1;
+            for (int segment_index : section_point.segments)
+            {
+                if (segment_index >= 0 && !segments[segment_index].visited)
+                {
+                    next = segment_index;
+                    break;
+                }
+            }
+            if (next < 0)
+            {
+                return key;
+            }
+            Segment& segment = segments[next];
+            segment.visited = true;
+            key = segment.ends[0] == key ? segment.ends[1] : segment.ends[0];
+            chain.push_back(section_points[key].point);
+        }
+    };
+
+    std::vector<glm::vec3> forward, backward;
+    for (auto& segment : segments)
+    {
+        if (segment.visited)
+        {
+            continue;
+        }
+        segment.visited = true;
+        forward.assign(1, section_points[segment.ends[1]].point);
+        backward.clear();
+        uint64_t last = follow(segment.ends[1], forward);
+        bool closed = last == segment.ends[0];
+        if (!closed)
+        {
+            follow(segment.ends[0], backward);
+        }
+
+        Contour contour;
+        contour.offset = points_.size();
+        contour.closed = closed;
+        points_.insert(points_.end(), backward.rbegin(), backward.rend());
+        points_.push_back(section_points[segment.ends[0]].point);
+        // A closed chain ends with its first point, which is not repeated.
+        points_.insert(points_.end(), forward.begin(), closed ? forward.end() - 1 : forward.end());
+        contour.count = points_.size() - contour.offset;
+        contours_.push_back(contour);
+        statistics_.open_contours += closed ? 0 : 1;
+    }
+}
+
+void SectionSlicer::draw() const
+/** Draws contours over the Object: closed contours in red, open ones (the section of an open mesh) in orange.
+Expects the modelview matrix the Object was drawn with. */
+{
+    if (contours_.empty())
+    {
+        return;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glLineWidth(2.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, points_.data());
+    for (auto const& contour : contours_)
+    {
+        if (contour.closed)
+        {
+            glColor3f(1.0f, 0.2f, 0.2f);
+        }
+        else
+        {
+            glColor3f(1.0f, 0.6f, 0.0f);
+        }
+        glDrawArrays(contour.closed ? GL_LINE_LOOP : GL_LINE_STRIP, static_cast<GLint>(contour.offset), static_cast<GLsizei>(contour.count));
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glLineWidth(1.0f);
+    glEnable(GL_DEPTH_TEST);
+}
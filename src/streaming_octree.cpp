@@ -0,0 +1,637 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+#include <glm/gtc/type_ptr.hpp>
+#include "../include/streaming_octree.h"
+#include "../include/memory_stats.h"
+
+namespace
+{
+    const char kMagic[4] = {'O', 'C', 'T', '1'};
+    const uint32_t kFileVersion = 1;
+    const int kMaxDepth = 12;
+    const uint32_t kClusterGrid = 32;           // cells per axis of the vertex clustering of internal nodes
+    // Nodes visited by the last traversals are not evicted. Engineering view draws four viewports in one frame.
+    const size_t kProtectedTraversals = 4;
+
+    struct FileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t node_count;
+        uint32_t reserved;
+        uint64_t table_offset;      // the node table follows the payloads, since their offsets are known only after writing
+    };
+
+    struct Builder
+    {
+        const std::vector<float>& vertices;
+        const std::vector<unsigned int>& indices;
+        size_t leaf_triangles;
+        std::ofstream& file;
+        std::vector<StreamingOctree::Node> nodes;
+    };
+
+    glm::vec3 vertexAt(const std::vector<float>& vertices, unsigned int index)
+    {
+        return {vertices[3 * size_t(index)], vertices[3 * size_t(index) + 1], vertices[3 * size_t(index) + 2]};
+    }
+
+    void writePayload(Builder& builder, StreamingOctree::Node& node, const std::vector<float>& vertices, const std::vector<uint32_t>& indices)
+    {
+        node.offset = static_cast<uint64_t>(builder.file.tellp());
+        node.vertex_count = static_cast<uint32_t>(vertices.size() / 3);
+        node.index_count = static_cast<uint32_t>(indices.size());
+        builder.file.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(float)));
+        builder.file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+    }
+
+    void leafPayload(const Builder& builder, const std::vector<uint32_t>& triangles, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+    /** Copies the triangles with their vertices renumbered from 0. */
+    {
+        std::unordered_map<unsigned int, uint32_t> local;
+        for (uint32_t triangle : triangles)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                unsigned int index = builder.indices[3 * size_t(triangle) + corner];
+                auto inserted = local.emplace(index, static_cast<uint32_t>(vertices.size() / 3));
+                if (inserted.second)
+                {
+                    glm::vec3 vertex = vertexAt(builder.vertices, index);
+                    vertices.insert(vertices.end(), {vertex.x, vertex.y, vertex.z});
+                }
+                indices.push_back(inserted.first->second);
+            }
+        }
+    }
+
+    void clusteredPayload(const Builder& builder, const std::vector<uint32_t>& triangles, const glm::vec3& cube_min, float cube_size,
+                          std::vector<float>& vertices, std::vector<uint32_t>& indices)
+    /** Simplifies the triangles by vertex clustering: vertices in the same grid cell are replaced by their average,
+    triangles with two corners in one cell disappear and duplicate triangles are dropped. */
+    {
+        float cell_size = cube_size / kClusterGrid;
+        auto cellOf = [&](const glm::vec3& vertex) {
+            glm::vec3 cell = glm::floor((vertex - cube_min) / cell_size);
+            auto x = static_cast<uint32_t>(glm::clamp(cell.x, 0.0f, float(kClusterGrid - 1)));
+            auto y = static_cast<uint32_t>(glm::clamp(cell.y, 0.0f, float(kClusterGrid - 1)));
+            auto z = static_cast<uint32_t>(glm::clamp(cell.z, 0.0f, float(kClusterGrid - 1)));
+            return (x * kClusterGrid + y) * kClusterGrid + z;
+        };
+
+        std::unordered_map<uint32_t, uint32_t> cluster_of_cell;
+        std::vector<glm::vec3> sums;
+        std::vector<uint32_t> counts;
+        std::unordered_set<uint64_t> emitted;
+        for (uint32_t triangle : triangles)
+        {
+            uint32_t clusters[3];
+            for (int corner = 0; corner < 3; corner++)
+            {
+                glm::vec3 vertex = vertexAt(builder.vertices, builder.indices[3 * size_t(triangle) + corner]);
+                auto inserted = cluster_of_cell.emplace(cellOf(vertex), static_cast<uint32_t>(sums.size()));
+                if (inserted.second)
+                {
+                    sums.emplace_back(0.0f);
+                    counts.push_back(0);
+                }
+                clusters[corner] = inserted.first->second;
+                sums[clusters[corner]] += vertex;
+                counts[clusters[corner]]++;
+            }
+            if (clusters[0] == clusters[1] || clusters[1] == clusters[2] || clusters[0] == clusters[2])
+            {
+                continue;
+            }
+            // Cells are numbered with 15 bits, so a sorted triple of clusters of one node fits a 64-bit key.
+            uint32_t sorted[3] = {clusters[0], clusters[1], clusters[2]};
+            std::sort(sorted, sorted + 3);
+            uint64_t key = (uint64_t(sorted[0]) << 42) | (uint64_t(sorted[1]) << 21) | sorted[2];
+            if (emitted.insert(key).second)
+            {
+                indices.insert(indices.end(), {clusters[0], clusters[1], clusters[2]});
+            }
+        }
+        vertices.reserve(sums.size() * 3);
+        for (size_t cluster = 0; cluster < sums.size(); cluster++)
+        {
+            glm::vec3 average = sums[cluster] / float(counts[cluster]);
+            vertices.insert(vertices.end(), {average.x, average.y, average.z});
+        }
+    }
+
+    uint32_t buildNode(Builder& builder, std::vector<uint32_t>& triangles, const glm::vec3& cube_min, float cube_size, int depth)
+    /** Writes the payload of a node for the triangles with centroids inside the cube, then builds its children. */
+    {
+        auto index = static_cast<uint32_t>(builder.nodes.size());
+        builder.nodes.emplace_back();
+        StreamingOctree::Node node{};
+        node.min = glm::vec3(std::numeric_limits<float>::max());
+        node.max = glm::vec3(std::numeric_limits<float>::lowest());
+        for (uint32_t triangle : triangles)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                glm::vec3 vertex = vertexAt(builder.vertices, builder.indices[3 * size_t(triangle) + corner]);
+                node.min = glm::min(node.min, vertex);
+                node.max = glm::max(node.max, vertex);
+            }
+        }
+
+        std::vector<float> vertices;
+        std::vector<uint32_t> indices;
+        if (triangles.size() <= builder.leaf_triangles || depth == kMaxDepth)
+        {
+            leafPayload(builder, triangles, vertices, indices);
+            node.geometric_error = 0;
+            writePayload(builder, node, vertices, indices);
+            builder.nodes[index] = node;
+            return index;
+        }
+
+        clusteredPayload(builder, triangles, cube_min, cube_size, vertices, indices);
+        // A vertex moves at most by the diagonal of its cell.
+        node.geometric_error = cube_size / kClusterGrid * std::sqrt(3.0f);
+        writePayload(builder, node, vertices, indices);
+        vertices = std::vector<float>();
+        indices = std::vector<uint32_t>();
+
+        float half = cube_size / 2;
+        glm::vec3 center = cube_min + half;
+        std::vector<uint32_t> octants[8];
+        for (uint32_t triangle : triangles)
+        {
+            glm::vec3 centroid = (vertexAt(builder.vertices, builder.indices[3 * size_t(triangle)])
+                                  + vertexAt(builder.vertices, builder.indices[3 * size_t(triangle) + 1])
+                                  + vertexAt(builder.vertices, builder.indices[3 * size_t(triangle) + 2])) / 3.0f;
+            int octant = (centroid.x >= center.x ? 1 : 0) | (centroid.y >= center.y ? 2 : 0) | (centroid.z >= center.z ? 4 : 0);
+            octants[octant].push_back(triangle);
+        }
+        triangles = std::vector<uint32_t>();
+
+        for (int octant = 0; octant < 8; octant++)
+        {
+            node.children[octant] = 0;
+            if (octants[octant].empty())
+            {
+                continue;
+            }
+            glm::vec3 child_min = cube_min + glm::vec3(octant & 1 ? half : 0.0f, octant & 2 ? half : 0.0f, octant & 4 ? half : 0.0f);
+            node.children[octant] = buildNode(builder, octants[octant], child_min, half, depth + 1);
+        }
+        builder.nodes[index] = node;
+        return index;
+    }
+
+    float boxDistance(const StreamingOctree::Node& node, const glm::vec3& point)
+    {
+        glm::vec3 outside = glm::max(glm::max(node.min - point, point - node.max), glm::vec3(0.0f));
+        return glm::length(outside);
+    }
+
+    bool boxVisible(const StreamingOctree::Node& node, const glm::mat4& model_view_projection)
+    /** Returns false if all corners of the node's box are outside one clipping plane. */
+    {
+        int outside[6] = {0, 0, 0, 0, 0, 0};
+        for (int corner = 0; corner < 8; corner++)
+        {
+            glm::vec4 point(corner & 1 ? node.max.x : node.min.x, corner & 2 ? node.max.y : node.min.y,
+                            corner & 4 ? node.max.z : node.min.z, 1.0f);
+            glm::vec4 clip = model_view_projection * point;
+            outside[0] += clip.x < -clip.w;
+            outside[1] += clip.x > clip.w;
+            outside[2] += clip.y < -clip.w;
+            outside[3] += clip.y > clip.w;
+            outside[4] += clip.z < -clip.w;
+            outside[5] += clip.z > clip.w;
+        }
+        return std::none_of(outside, outside + 6, [](int count) {return count == 8;});
+    }
+
+    bool validNode(const StreamingOctree::Node& node, uint32_t index, size_t node_count, uint64_t file_size)
+    /** Returns true if the node's payload lies inside the file and its children come after it in the table, as the
+    writer stores them, so a corrupt table can neither cause huge allocations nor cycles in the traversal. */
+    {
+        uint64_t payload_bytes = uint64_t(node.vertex_count) * 3 * sizeof(float) + uint64_t(node.index_count) * sizeof(uint32_t);
+        if (node.offset > file_size || payload_bytes > file_size - node.offset || node.index_count % 3 != 0)
+        {
+            return false;
+        }
+        return std::all_of(node.children, node.children + 8, [index, node_count](uint32_t child) {
+            return child == 0 || (child > index && child < node_count);
+        });
+    }
+}
+
+bool StreamingOctree::writeFile(const std::string& filepath, const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+                                size_t leaf_triangles)
+/** Builds an octree of the mesh and writes it to a file: a header, node payloads (float positions and 32-bit indices)
+and the node table. Triangles are assigned to octants by their centroids; nodes with at most leaf_triangles become leaves.
+Returns false if the mesh is empty or the file cannot be written. */
+{
+    if (indices.empty())
+    {
+        return false;
+    }
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFileVersion;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    glm::vec3 min = vertexAt(vertices, indices[0]);
+    glm::vec3 max = min;
+    for (unsigned int index : indices)
+    {
+        min = glm::min(min, vertexAt(vertices, index));
+        max = glm::max(max, vertexAt(vertices, index));
+    }
+    glm::vec3 extent = max - min;
+    // Cubes keep clustering cells and child boxes of all nodes cubic.
+    float cube_size = std::max(std::max(extent.x, extent.y), std::max(extent.z, std::numeric_limits<float>::min())) * 1.0001f;
+
+    Builder builder{vertices, indices, std::max<size_t>(leaf_triangles, 1), file, {}};
+    std::vector<uint32_t> triangles(indices.size() / 3);
+    for (size_t triangle = 0; triangle < triangles.size(); triangle++)
+    {
+        triangles[triangle] = static_cast<uint32_t>(triangle);
+    }
+    buildNode(builder, triangles, min, cube_size, 0);
+
+    header.node_count = static_cast<uint32_t>(builder.nodes.size());
+    header.table_offset = static_cast<uint64_t>(file.tellp());
+    file.write(reinterpret_cast<const char*>(builder.nodes.data()), static_cast<std::streamsize>(builder.nodes.size() * sizeof(Node)));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return static_cast<bool>(file);
+}
+
+bool StreamingOctree::open(const std::string& filepath)
+/** Reads the node table of an octree file, loads the root node and starts the loader thread. Offsets and counts of
+the table are checked against the file size. Returns false if the file cannot be read, has another format or is
+corrupt; an octree opened before stays open in that case. */
+{
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    auto file_size = static_cast<uint64_t>(std::max<std::streamoff>(0, static_cast<std::streamoff>(file.tellg())));
+    file.seekg(0);
+    FileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+        || header.version != kFileVersion || header.node_count == 0 || header.table_offset > file_size
+        || header.node_count > (file_size - header.table_offset) / sizeof(Node))
+    {
+        return false;
+    }
+    std::vector<Node> nodes(header.node_count);
+    file.seekg(static_cast<std::streamoff>(header.table_offset));
+    if (!file.read(reinterpret_cast<char*>(nodes.data()), static_cast<std::streamsize>(nodes.size() * sizeof(Node))))
+    {
+        return false;
+    }
+    for (uint32_t node = 0; node < nodes.size(); node++)
+    {
+        if (!validNode(nodes[node], node, nodes.size(), file_size))
+        {
+            return false;
+        }
+    }
+
+    // The root is always resident, so there is something to draw before the loader thread delivers the first nodes.
+    // The previous octree is closed only once the new one has been read.
+    NodeData root;
+    if (!readNode(file, nodes[0], 0, root))
+    {
+        return false;
+    }
+    close();
+    nodes_ = std::move(nodes);
+    filepath_ = filepath;
+    resident_.assign(nodes_.size(), ResidentNode());
+    upload(root);
+
+    stop_ = false;
+    loader_ = std::thread(&StreamingOctree::loaderLoop, this);
+    return true;
+}
+
+void StreamingOctree::close()
+/** Stops the loader thread and releases GPU buffers of all resident nodes. */
+{
+    stopLoader();
+    for (uint32_t node = 0; node < resident_.size(); node++)
+    {
+        if (resident_[node].resident)
+        {
+            evict(node);
+        }
+    }
+    nodes_.clear();
+    nodes_.shrink_to_fit();
+    resident_.clear();
+    resident_.shrink_to_fit();
+    draw_list_.clear();
+    requests_.clear();
+    completed_.clear();
+    resident_bytes_ = 0;
+    drawn_triangles_ = 0;
+    loaded_nodes_ = 0;
+    evicted_nodes_ = 0;
+    load_ms_ = 0;
+}
+
+void StreamingOctree::stopLoader()
+{
+    if (!loader_.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    loader_.join();
+}
+
+void StreamingOctree::loaderLoop()
+/** Reads the requested node with the largest screen-space error, one at a time, until the octree is closed. */
+{
+    std::ifstream file(filepath_, std::ios::binary);
+    while (true)
+    {
+        uint32_t node;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] {return stop_ || !requests_.empty();});
+            if (stop_)
+            {
+                return;
+            }
+            auto best = std::max_element(requests_.begin(), requests_.end(),
+                                         [](const std::pair<const uint32_t, Request>& a, const std::pair<const uint32_t, Request>& b) {
+                return a.second.priority < b.second.priority;
+            });
+            node = best->first;
+            requests_.erase(best);
+        }
+
+        NodeData data;
+        if (!readNode(file, nodes_[node], node, data))
+        {
+            // The node is delivered empty, so it is not requested again.
+            data.vertices.clear();
+            data.indices.clear();
+            file.clear();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed_.push_back(std::move(data));
+    }
+}
+
+bool StreamingOctree::readNode(std::ifstream& file, const Node& entry, uint32_t node, NodeData& data)
+/** Reads the payload of a node. Returns false if it cannot be read or refers to vertices it does not have. */
+{
+    auto start = std::chrono::steady_clock::now();
+    data.node = node;
+    data.vertices.resize(3 * size_t(entry.vertex_count));
+    data.indices.resize(entry.index_count);
+    file.seekg(static_cast<std::streamoff>(entry.offset));
+    file.read(reinterpret_cast<char*>(data.vertices.data()), static_cast<std::streamsize>(data.vertices.size() * sizeof(float)));
+    file.read(reinterpret_cast<char*>(data.indices.data()), static_cast<std::streamsize>(data.indices.size() * sizeof(uint32_t)));
+    data.read_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return file && std::all_of(data.indices.begin(), data.indices.end(), [&entry](uint32_t index) {return index < entry.vertex_count;});
+}
+
+void StreamingOctree::upload(NodeData& data)
+/** Moves node geometry into GPU buffers. Must be called on the thread owning the OpenGL context. */
+{
+    ResidentNode& resident = resident_[data.node];
+    resident.resident = true;
+    resident.in_flight = false;
+    resident.last_used = traversal_;
+    if (data.indices.empty())
+    {
+        return;
+    }
+    glGenBuffers(1, &resident.vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, resident.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.vertices.size() * sizeof(float)), data.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glGenBuffers(1, &resident.index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resident.index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.indices.size() * sizeof(uint32_t)), data.indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    resident.bytes = data.vertices.size() * sizeof(float) + data.indices.size() * sizeof(uint32_t);
+    resident_bytes_ += resident.bytes;
+}
+
+void StreamingOctree::evict(uint32_t node)
+{
+    ResidentNode& resident = resident_[node];
+    if (resident.vertex_buffer != 0)
+    {
+        glDeleteBuffers(1, &resident.vertex_buffer);
+        glDeleteBuffers(1, &resident.index_buffer);
+    }
+    resident_bytes_ -= resident.bytes;
+    resident = ResidentNode();
+    evicted_nodes_++;
+}
+
+void StreamingOctree::receiveCompleted()
+/** Uploads nodes read by the loader thread since the last call. */
+{
+    std::vector<NodeData> completed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completed.swap(completed_);
+    }
+    for (auto& data : completed)
+    {
+        upload(data);
+        loaded_nodes_++;
+        load_ms_ += data.read_ms;
+    }
+}
+
+void StreamingOctree::evictToBudget()
+/** Evicts least recently used nodes, except the root and nodes of the last traversals, while over the budget. */
+{
+    if (resident_bytes_ <= budget_bytes_)
+    {
+        return;
+    }
+    std::vector<uint32_t> candidates;
+    for (uint32_t node = 1; node < resident_.size(); node++)
+    {
+        if (resident_[node].resident && traversal_ - resident_[node].last_used >= kProtectedTraversals)
+        {
+            candidates.push_back(node);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+        return resident_[a].last_used < resident_[b].last_used;
+    });
+    for (size_t i = 0; i < candidates.size() && resident_bytes_ > budget_bytes_; i++)
+    {
+        evict(candidates[i]);
+    }
+}
+
+void StreamingOctree::traverse(uint32_t node, const glm::mat4& model_view_projection, const glm::vec3& eye, float error_scale,
+                               bool orthographic, float max_error_pixels, std::unordered_map<uint32_t, float>& wanted)
+/** Adds the node to the draw list, or its children if its screen-space error is too large and all visible children are resident.
+Missing children are added to wanted with the error of the node. Visited nodes are expected to be resident. */
+{
+    const Node& entry = nodes_[node];
+    resident_[node].last_used = traversal_;
+    if (!boxVisible(entry, model_view_projection))
+    {
+        return;
+    }
+
+    float distance = boxDistance(entry, eye);
+    float error = orthographic ? entry.geometric_error * error_scale
+                               : (distance > 0 ? entry.geometric_error * error_scale / distance : std::numeric_limits<float>::max());
+    if (entry.geometric_error > 0 && error > max_error_pixels)
+    {
+        bool children_resident = true;
+        for (uint32_t child : entry.children)
+        {
+            if (child != 0 && !resident_[child].resident && boxVisible(nodes_[child], model_view_projection))
+            {
+                children_resident = false;
+                float& priority = wanted[child];
+                priority = std::max(priority, error);
+            }
+        }
+        if (children_resident)
+        {
+            for (uint32_t child : entry.children)
+            {
+                if (child != 0 && resident_[child].resident)
+                {
+                    traverse(child, model_view_projection, eye, error_scale, orthographic, max_error_pixels, wanted);
+                }
+            }
+            return;
+        }
+    }
+    draw_list_.push_back(node);
+    drawn_triangles_ += entry.index_count / 3;
+}
+
+void StreamingOctree::draw(float max_error_pixels, size_t budget_bytes)
+/** Draws resident nodes whose screen-space error in the current view is at most max_error_pixels, or the closest resident
+ancestors of missing ones. The view is read from the current OpenGL modelview, projection and viewport.
+Uploads nodes read since the last call, evicts nodes over the budget and hands missing nodes to the loader thread. */
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+    traversal_++;
+    budget_bytes_ = budget_bytes;
+    receiveCompleted();
+
+    glm::mat4 model_view, projection;
+    glm::vec4 viewport;
+    glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(model_view));
+    glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+    glGetFloatv(GL_VIEWPORT, glm::value_ptr(viewport));
+    // Orthogonal projection matrices have 1 in their bottom-right element. Its error does not depend on the distance,
+    // but on the scaling of the modelview matrix.
+    bool orthographic = projection[3][3] == 1.0f;
+    glm::vec3 eye = glm::vec3(glm::inverse(model_view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    float error_scale = viewport[3] * projection[1][1] / 2;
+    if (orthographic)
+    {
+        error_scale *= glm::length(glm::vec3(model_view[0]));
+    }
+
+    draw_list_.clear();
+    drawn_triangles_ = 0;
+    std::unordered_map<uint32_t, float> wanted;
+    traverse(0, projection * model_view, eye, error_scale, orthographic, max_error_pixels, wanted);
+    evictToBudget();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Requests not repeated by the last traversals are dropped, so the loader follows the camera.
+        for (auto it = requests_.begin(); it != requests_.end();)
+        {
+            if (traversal_ - it->second.traversal >= kProtectedTraversals)
+            {
+                resident_[it->first].in_flight = false;
+                it = requests_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (auto const& node : wanted)
+        {
+            auto request = requests_.find(node.first);
+            if (request != requests_.end())
+            {
+                request->second = Request{node.second, traversal_};
+            }
+            else if (!resident_[node.first].in_flight && resident_bytes_ < budget_bytes_)
+            {
+                requests_[node.first] = Request{node.second, traversal_};
+                resident_[node.first].in_flight = true;
+            }
+        }
+    }
+    condition_.notify_one();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (uint32_t node : draw_list_)
+    {
+        const ResidentNode& resident = resident_[node];
+        if (resident.vertex_buffer == 0)
+        {
+            continue;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, resident.vertex_buffer);
+        glVertexPointer(3, GL_FLOAT, 0, nullptr);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, resident.index_buffer);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(nodes_[node].index_count), GL_UNSIGNED_INT, nullptr);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+StreamingOctree::Statistics StreamingOctree::statistics() const
+{
+    Statistics statistics;
+    statistics.nodes = nodes_.size();
+    statistics.resident_nodes = std::count_if(resident_.begin(), resident_.end(), [](const ResidentNode& node) {return node.resident;});
+    statistics.resident_bytes = resident_bytes_;
+    statistics.budget_bytes = budget_bytes_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics.queued_nodes = requests_.size();
+    }
+    statistics.drawn_nodes = draw_list_.size();
+    statistics.drawn_triangles = drawn_triangles_;
+    statistics.loaded_nodes = loaded_nodes_;
+    statistics.evicted_nodes = evicted_nodes_;
+    statistics.load_ms = load_ms_;
+    return statistics;
+}
+
+size_t StreamingOctree::memoryBytes() const
+{
+    return vectorBytes(nodes_) + vectorBytes(resident_) + vectorBytes(draw_list_);
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cstdint>
+#include "../include/task_scheduler.h"
+#include "../include/config.h"
+#include "../include/parallel.h"
+
+namespace
+{
+    const size_t kNotAWorker = SIZE_MAX;
+
+    // Queue of the worker running on this thread, and the priority of the task it runs. Threads outside the pool
+    // (main and render thread) are interactive.
+    thread_local size_t current_worker = kNotAWorker;
+    thread_local TaskPriority current_priority = kInteractivePriority;
+}
+
+bool TaskHandle::done() const
+{
+    return state_ == nullptr || state_->done;
+}
+
+void TaskHandle::wait() const
+/** Blocks until the task is finished or skipped. Meanwhile the waiting thread runs queued tasks of its own priority
+or higher, which is how a thread waiting for its parallelFor chunks helps to process them. */
+{
+    if (state_ == nullptr)
+    {
+        return;
+    }
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    while (!state_->done)
+    {
+        if (!scheduler.runPendingTask(TaskScheduler::currentPriority()))
+        {
+            // Nothing to help with: the task is running on another thread.
+            std::unique_lock<std::mutex> lock(state_->mutex);
+            state_->condition.wait(lock, [this]{return state_->done.load();});
+        }
+    }
+}
+
+TaskScheduler& TaskScheduler::instance()
+/** Returns the application's scheduler. Workers are started on the first call. */
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler()
+/** Starts one worker less than there are hardware threads, since the thread calling parallelFor processes chunks too. */
+{
+    size_t threads = std::max<size_t>(1, ::workerCount() - 1);
+    max_running_background_ = std::max<size_t>(1, threads - 1);
+    for (auto& queued : queued_)
+    {
+        queued = 0;
+    }
+    for (size_t i = 0; i <= threads; i++)
+    {
+        queues_.emplace_back(new Queue());
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        threads_.emplace_back(&TaskScheduler::run, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+/** Stops the workers after their current tasks. Tasks still queued are dropped and marked as done. */
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+    for (auto& queue : queues_)
+    {
+        for (auto& tasks : queue->tasks)
+        {
+            for (auto& task : tasks)
+            {
+                task.state->done = true;
+                task.state->condition.notify_all();
+            }
+        }
+    }
+}
+
+TaskHandle TaskScheduler::submit(const char* name, std::function<void()> task, TaskPriority priority, CancellationToken token)
+/** Queues a task. Tasks submitted by a worker go to its own queue, so nested work stays on the same thread
+unless other workers are idle and steal it. The task reads the Config snapshot of the submitting thread, so chunks of
+parallelFor see the same Parameters as their caller; threads without one (the main thread) pass the published snapshot. */
+{
+    Task queued_task;
+    queued_task.name = name;
+    queued_task.function = std::move(task);
+    queued_task.priority = priority;
+    queued_task.token = std::move(token);
+    queued_task.config = Config::threadSnapshot() ? Config::threadSnapshot() : Config::snapshot();
+    queued_task.submitted = Clock::now();
+    queued_task.state = std::make_shared<TaskHandle::State>();
+
+    TaskHandle handle;
+    handle.state_ = queued_task.state;
+
+    size_t queue = current_worker == kNotAWorker ? queues_.size() - 1 : current_worker;
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        queues_[queue]->tasks[priority].push_back(std::move(queued_task));
+    }
+    queued_[priority]++;
+    wakeWorkers();
+    return handle;
+}
+
+bool TaskScheduler::runPendingTask(TaskPriority lowest_priority)
+/** Runs one queued task with priority lowest_priority or higher on the calling thread, if there is any. */
+{
+    size_t own_queue = current_worker == kNotAWorker ? queues_.size() - 1 : current_worker;
+    for (int priority = kInteractivePriority; priority <= lowest_priority; priority++)
+    {
+        Task task;
+        if (findTask(own_queue, static_cast<TaskPriority>(priority), task))
+        {
+            execute(task);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::setTimingHook(TimingHook hook)
+/** Sets the function called after every task, from the thread that ran it. */
+{
+    std::atomic_store(&timing_hook_, std::shared_ptr<const TimingHook>(hook ? new TimingHook(std::move(hook)) : nullptr));
+}
+
+TaskPriority TaskScheduler::currentPriority()
+/** Returns the priority of the task running on the calling thread. Work submitted from a task, like the chunks
+of parallelFor, inherits it. */
+{
+    return current_priority;
+}
+
+void TaskScheduler::run(size_t worker)
+{
+    current_worker = worker;
+    while (true)
+    {
+        Task task;
+        if (findTask(worker, kInteractivePriority, task))
+        {
+            execute(task);
+            continue;
+        }
+
+        // A slot for a background task is reserved before searching, so at most max_running_background_ run at once.
+        if (running_background_.fetch_add(1) < max_running_background_)
+        {
+            bool found = findTask(worker, kBackgroundPriority, task);
+            if (found)
+            {
+                execute(task);
+            }
+            running_background_--;
+            if (found)
+            {
+                wakeWorkers();
+                continue;
+            }
+        }
+        else
+        {
+            running_background_--;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this]{return stop_ || hasWork();});
+        if (stop_)
+        {
+            return;
+        }
+    }
+}
+
+bool TaskScheduler::takeTask(size_t queue, TaskPriority priority, bool newest, Task& task)
+{
+    std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+    auto& tasks = queues_[queue]->tasks[priority];
+    if (tasks.empty())
+    {
+        return false;
+    }
+    if (newest)
+    {
+        task = std::move(tasks.back());
+        tasks.pop_back();
+    }
+    else
+    {
+        task = std::move(tasks.front());
+        tasks.pop_front();
+    }
+    queued_[priority]--;
+    return true;
+}
+
+bool TaskScheduler::findTask(size_t own_queue, TaskPriority priority, Task& task)
+/** Takes the newest task of the own queue, or steals the oldest task of another queue, starting with the next one,
+so stealing workers spread over the queues. */
+{
+    if (queued_[priority] == 0)
+    {
+        return false;
+    }
+    if (takeTask(own_queue, priority, true, task))
+    {
+        return true;
+    }
+    for (size_t i = 1; i < queues_.size(); i++)
+    {
+        if (takeTask((own_queue + i) % queues_.size(), priority, false, task))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::execute(Task& task)
+{
+    TaskTiming timing;
+    timing.name = task.name;
+    timing.priority = task.priority;
+    auto start = Clock::now();
+    timing.queued_ms = std::chrono::duration<double, std::milli>(start - task.submitted).count();
+
+    if (task.token.isCancelled())
+    {
+        timing.cancelled = true;
+    }
+    else
+    {
+        TaskPriority previous_priority = current_priority;
+        std::shared_ptr<const ConfigSnapshot> previous_config = Config::threadSnapshot();
+        current_priority = task.priority;
+        Config::useSnapshot(task.config);
+        task.function();
+        Config::useSnapshot(std::move(previous_config));
+        current_priority = previous_priority;
+    }
+    timing.run_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> lock(task.state->mutex);
+        task.state->done = true;
+    }
+    task.state->condition.notify_all();
+
+    auto hook = std::atomic_load(&timing_hook_);
+    if (hook)
+    {
+        (*hook)(timing);
+    }
+}
+
+void TaskScheduler::wakeWorkers()
+/** Wakes a sleeping worker. The sleep mutex is taken, so a worker checking for work cannot miss the change. */
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+bool TaskScheduler::hasWork() const
+{
+    return queued_[kInteractivePriority] > 0
+           || (queued_[kBackgroundPriority] > 0 && running_background_ < max_running_background_);
+}
+
+void TaskProfiler::record(const TaskTiming& timing)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[timing.name];
+    entry.count++;
+    entry.total_queued_ms += timing.queued_ms;
+    if (timing.cancelled)
+    {
+        entry.cancelled++;
+        return;
+    }
+    entry.total_run_ms += timing.run_ms;
+    entry.max_run_ms = std::max(entry.max_run_ms, timing.run_ms);
+    entry.last_run_ms = timing.run_ms;
+}
+
+void TaskProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+std::map<std::string, TaskProfiler::Entry> TaskProfiler::entries() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "../include/vertex_grid.h"
+#include "../include/memory_stats.h"
+#include "../include/parallel.h"
+
+void VertexGrid::clear()
+{
+    vertices_ = nullptr;
+    bucket_start_.clear();
+    bucket_start_.shrink_to_fit();
+    vertex_ids_.clear();
+    vertex_ids_.shrink_to_fit();
+}
+
+size_t VertexGrid::bucket(int x, int y, int z) const
+/** Hashes integer cell coordinates into one of the buckets; the number of buckets is a power of two. */
+{
+    auto hash = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ static_cast<uint32_t>(z) * 83492791u;
+    return hash & (bucket_start_.size() - 2);
+}
+
+void VertexGrid::cellOf(const glm::vec3& point, int& x, int& y, int& z) const
+{
+    x = static_cast<int>(std::floor((point.x - origin_.x) / cell_size_));
+    y = static_cast<int>(std::floor((point.y - origin_.y) / cell_size_));
+    z = static_cast<int>(std::floor((point.z - origin_.z) / cell_size_));
+}
+
+void VertexGrid::build(const std::vector<float>& vertices)
+/** Chooses a cell size holding a few vertices on average and sorts vertex ids by bucket with a counting sort.
+The grid keeps a pointer to the vertices, so it has to be rebuilt whenever they are reallocated. */
+{
+    clear();
+    size_t vertex_count = vertices.size() / 3;
+    if (vertex_count == 0)
+    {
+        return;
+    }
+    vertices_ = vertices.data();
+
+    glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        glm::vec3 vertex(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]);
+        min = glm::min(min, vertex);
+        max = glm::max(max, vertex);
+    }
+    origin_ = min;
+
+    // Vertices of a mesh lie on its surface, so the cell size is derived from the area of the bounding box
+    // rather than its volume, aiming at about 4 vertices per occupied cell.
+    glm::vec3 extent = max - min;
+    float area = extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    cell_size_ = area > 0 ? std::sqrt(4.0f * area / static_cast<float>(vertex_count)) : 1.0f;
+
+    size_t bucket_count = 1;
+    while (bucket_count < vertex_count)
+    {
+        bucket_count <<= 1;
+    }
+    bucket_start_.assign(bucket_count + 1, 0);
+
+    std::vector<uint32_t> vertex_buckets(vertex_count);
+    parallelFor(vertex_count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            int x, y, z;
+            cellOf(glm::vec3(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]), x, y, z);
+            vertex_buckets[i] = static_cast<uint32_t>(bucket(x, y, z));
+        }
+    });
+
+    for (uint32_t vertex_bucket : vertex_buckets)
+    {
+        bucket_start_[vertex_bucket + 1]++;
+    }
+    for (size_t b = 1; b <= bucket_count; b++)
+    {
+        bucket_start_[b] += bucket_start_[b - 1];
+    }
+    vertex_ids_.resize(vertex_count);
+    std::vector<uint32_t> fill(bucket_start_.begin(), bucket_start_.end() - 1);
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        vertex_ids_[fill[vertex_buckets[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+bool VertexGrid::nearest(const glm::vec3& point, float radius, uint32_t& vertex, float& distance) const
+/** Finds the vertex closest to the point within the radius by checking buckets of all cells the radius overlaps.
+Returns false if there is no such vertex. */
+{
+    if (vertex_ids_.empty())
+    {
+        return false;
+    }
+
+    int x_min, y_min, z_min, x_max, y_max, z_max;
+    cellOf(point - glm::vec3(radius), x_min, y_min, z_min);
+    cellOf(point + glm::vec3(radius), x_max, y_max, z_max);
+
+    float best = radius * radius;
+    bool found = false;
+    auto check_bucket = [&](size_t b) {
+        for (uint32_t i = bucket_start_[b]; i < bucket_start_[b + 1]; i++)
+        {
+            uint32_t id = vertex_ids_[i];
+            glm::vec3 d = glm::vec3(vertices_[3 * size_t(id)], vertices_[3 * size_t(id) + 1], vertices_[3 * size_t(id) + 2]) - point;
+            float distance_squared = glm::dot(d, d);
+            if (distance_squared <= best)
+            {
+                best = distance_squared;
+                vertex = id;
+                found = true;
+            }
+        }
+    };
+
+    // A radius covering more cells than there are buckets would visit buckets repeatedly, all of them are checked instead.
+    double cell_count = double(x_max - x_min + 1) * double(y_max - y_min + 1) * double(z_max - z_min + 1);
+    if (cell_count >= static_cast<double>(bucket_start_.size() - 1))
+    {
+        for (size_t b = 0; b + 1 < bucket_start_.size(); b++)
+        {
+            check_bucket(b);
+        }
+    }
+    else
+    {
+        for (int x = x_min; x <= x_max; x++)
+            for (int y = y_min; y <= y_max; y++)
+                for (int z = z_min; z <= z_max; z++)
+                    check_bucket(bucket(x, y, z));
+    }
+
+    if (found)
+    {
+        distance = std::sqrt(best);
+    }
+    return found;
+}
+
+size_t VertexGrid::memoryBytes() const
+{
+    return vectorBytes(bucket_start_) + vectorBytes(vertex_ids_);
+}
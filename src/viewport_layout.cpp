@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include "../include/viewport_layout.h"
+
+namespace
+{
+    std::vector<Viewport> predefinedViewports(ViewportLayoutType type)
+    {
+        const float third = 1.0f / 3.0f;
+        std::vector<Viewport> viewports;
+        switch (type)
+        {
+            case kRowLayout:
+                viewports = {{0, 0, third, 1, kFront}, {third, 0, third, 1, kTop}, {2 * third, 0, 1 - 2 * third, 1, kFree}};
+                break;
+            case kSingleLayout:
+                viewports = {{0, 0, 1, 1, kFree}};
+                break;
+            case kCustomLayout:
+                viewports = ViewportLayout::customViewports(0.65f, kDefaultCustomViews);
+                break;
+            case kDualLayout:
+                viewports = {{0, 0, 0.5f, 1, kFree}, {0.5f, 0, 0.5f, 1, kFree}};
+                break;
+            default:
+                // Front view in the bottom-left quarter, Side view next to it, Top view above it and Free view on the top right.
+                viewports = {{0, 0, 0.5f, 0.5f, kFront}, {0.5f, 0, 0.5f, 0.5f, kSide},
+                             {0, 0.5f, 0.5f, 0.5f, kTop}, {0.5f, 0.5f, 0.5f, 0.5f, kFree}};
+                break;
+        }
+        return viewports;
+    }
+}
+
+ViewportLayout::ViewportLayout(ViewportLayoutType type) : ViewportLayout(predefinedViewports(type))
+/** Creates one of the predefined layouts. The custom layout is created with its default views and split; the one
+set in Config is created from customViewports. */
+{
+}
+
+ViewportLayout::ViewportLayout(std::vector<Viewport> viewports) : viewports_(std::move(viewports))
+/** Creates a layout of any viewports and numbers the cameras of its Free views in order. */
+{
+    for (auto& viewport : viewports_)
+    {
+        viewport.camera = viewport.view == kFree ? static_cast<int>(free_cameras_++) : 0;
+    }
+}
+
+std::vector<Viewport> ViewportLayout::customViewports(float split, const std::array<int, 4>& views)
+/** Returns the viewports of the custom layout: the main view (views[0]) on the left, taking split of the window
+width, and a column of the other views on the right, from top to bottom. Slots set to kNoView are left out of the
+column; without any, the main view fills the window. */
+{
+    split = std::min(std::max(split, 0.1f), 0.9f);
+    std::vector<DomeCameraRotate> column;
+    for (size_t slot = 1; slot < views.size(); slot++)
+    {
+        if (views[slot] >= kFront && views[slot] <= kFree)
+        {
+            column.push_back(static_cast<DomeCameraRotate>(views[slot]));
+        }
+    }
+    auto main_view = views[0] >= kFront && views[0] <= kFree ? static_cast<DomeCameraRotate>(views[0]) : kFree;
+    if (column.empty())
+    {
+        return {{0, 0, 1, 1, main_view}};
+    }
+
+    std::vector<Viewport> viewports = {{0, 0, split, 1, main_view}};
+    // Rows share their edges exactly: the bottom of a row is the top of the next one.
+    auto edge = [&column](size_t row) {
+        return row == column.size() ? 0.0f : 1.0f - static_cast<float>(row) / static_cast<float>(column.size());
+    };
+    for (size_t row = 0; row < column.size(); row++)
+    {
+        viewports.push_back({split, edge(row + 1), 1 - split, edge(row) - edge(row + 1), column[row]});
+    }
+    return viewports;
+}
+
+ViewportRect ViewportLayout::rect(size_t index, int window_width, int window_height) const
+/** Returns the viewport in window pixels. Both edges are rounded, so the right edge of a viewport is the left edge
+of its neighbour. */
+{
+    const Viewport& viewport = viewports_[index];
+    ViewportRect rect;
+    rect.x = static_cast<int>(std::lround(viewport.x * float(window_width)));
+    rect.y = static_cast<int>(std::lround(viewport.y * float(window_height)));
+    rect.width = static_cast<int>(std::lround((viewport.x + viewport.width) * float(window_width))) - rect.x;
+    rect.height = static_cast<int>(std::lround((viewport.y + viewport.height) * float(window_height))) - rect.y;
+    return rect;
+}
+
+int ViewportLayout::viewportAt(double x_screen, double y_screen, int window_width, int window_height) const
+/** Returns the index of the viewport containing the screen coordinates, whose origin is the top-left corner of the
+window, or -1 if there is none. */
+{
+    double x_window = x_screen;
+    double y_window = window_height - y_screen;
+    for (size_t i = 0; i < viewports_.size(); i++)
+    {
+        ViewportRect viewport = rect(i, window_width, window_height);
+        // Window rows grow upwards, so the top edge of a viewport belongs to it and the bottom edge does not.
+        if (x_window >= viewport.x && x_window < viewport.x + viewport.width &&
+            y_window > viewport.y && y_window <= viewport.y + viewport.height)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+const char* ViewportLayout::name(ViewportLayoutType type)
+{
+    switch (type)
+    {
+        case kGridLayout: return "2x2";
+        case kRowLayout: return "1x3";
+        case kSingleLayout: return "1x1";
+        case kCustomLayout: return "Custom split";
+        case kDualLayout: return "2 Free views";
+        default: return "Unknown";
+    }
+}